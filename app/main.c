@@ -33,11 +33,24 @@
 
 
 #define SLEEP_MIN_TIME 1
+#define OPT_IIO_DIR 1000
+#define OPT_IIO_DEV 1001
+#define OPT_AMS_REGS 1002
+#define OPT_INA_I2C 1003
+#define OPT_IIO_TRIGGER 1004
+#define OPT_ALARMS 1005
+#define OPT_HIGH_RATE_CPU 1006
+#define OPT_HIGH_RATE_SENSORS 1007
 
 /************************** Variable Definitions *****************************/
 static int verbose_flag=0;
 int interval=1;
 char *filename;
+char *iio_dir;
+char *iio_dev;
+char *iio_trigger;
+int high_rate_cpu=-1;
+char *high_rate_sensors;
 
 /************************** Function Definitions *****************************/
 /*****************************************************************************/
@@ -61,6 +74,7 @@ static void print_usage()
 	printf(" 	-v --verbose		Print verbose messages  \n");
 	printf(" 	-l --logfile		Print output to logfile  \n");
 	printf(" 	-s --stop   		Stop any running instances of platformstats  \n");
+	printf("	-b --benchmark		Time N passes over all hwmon sensors and print the per tick cost.\n");
 	printf("	-h --help		Show this usuage.\n\n");
 	printf(" List of stats to print\n");
 	printf("	-a --all		Print all supported stats.\n");
@@ -70,6 +84,28 @@ static void print_usage()
 	printf("	-p --power-util		Print Power Utilization.\n");
 	printf("	-m --cma-util		Print CMA Mem Utilization.\n");
 	printf("	-f --cpu-freq		Print CPU frequency.\n");
+	printf("	-d --devfreq		Print devfreq device frequency and residency.\n");
+	printf("	-t --thermal		Print thermal zones, trip point headroom and cooling devices.\n");
+	printf("	-T --throttle		Detect thermal throttling episodes from CPU frequency and thermal state.\n");
+	printf("	-w --hwmon		Print all hwmon sensors.\n");
+	printf("	-R --rails		Load the given rail file and print power and headroom per rail group.\n");
+	printf("	-P --cpu-power		Estimate CPU power per cluster from frequency and idle residency.\n");
+	printf("	-u --proc-power		Attribute SOM power to processes by frequency weighted CPU time.\n");
+	printf("	-g --runtime-pm		Print devices that did not runtime suspend in the interval.\n");
+	printf("	-k --wakeup		Print the wakeup sources most active in the interval.\n");
+	printf("	-C --calibrate-cpu-power Fit the CPU power estimate against the INA260 over the interval\n");
+	printf("				and write the coefficients to the given file.\n");
+	printf("	-H --high-rate		Sample power and current sensors at the given rate in Hz (max 1000)\n");
+	printf("				and print min/mean/max, p99 and spike count every second.\n");
+	printf("	   --high-rate-cpu	CPU to pin the -H sampling thread to.\n");
+	printf("	   --high-rate-sensors	Comma separated device or device/attr hwmon sensors for -H.\n");
+	printf("	-I --iio-capture	Capture the given number of AMS frames through IIO buffered capture.\n");
+	printf("	   --iio-dir		IIO device directory to capture from instead of the AMS.\n");
+	printf("	   --iio-dev		IIO character device, or file of packed frames, for --iio-dir.\n");
+	printf("	   --iio-trigger	IIO trigger to capture with, written to trigger/current_trigger.\n");
+	printf("	   --ams-regs		Read the AMS through the mapped registers described in the given file.\n");
+	printf("	   --ina-i2c		Read the SOM power monitor on the given bus,address[,chip[,shunt uOhm]].\n");
+	printf("	   --alarms		Watch hwmon alarms from a background thread and print them with -p.\n");
 
 }
 
@@ -87,19 +123,40 @@ int main(int argc, char *argv[])
 		{"logfile", required_argument, 0, 'l'},
 		{"stop", required_argument, 0, 's'},
 		{"help", no_argument, 0, 'h'},
+		{"benchmark", required_argument, 0, 'b'},
 		{"cpu-util", no_argument, 0, 'c'},
 		{"ram-util", no_argument, 0, 'r'},
 		{"swap-util", no_argument, 0, 's'},
 		{"power-util", no_argument, 0, 'p'},
 		{"cma-util", no_argument, 0, 'm'},
 		{"cpu-freq", no_argument, 0, 'f'},
+		{"devfreq", no_argument, 0, 'd'},
+		{"thermal", no_argument, 0, 't'},
+		{"throttle", no_argument, 0, 'T'},
+		{"hwmon", no_argument, 0, 'w'},
+		{"rails", required_argument, 0, 'R'},
+		{"cpu-power", no_argument, 0, 'P'},
+		{"calibrate-cpu-power", required_argument, 0, 'C'},
+		{"proc-power", no_argument, 0, 'u'},
+		{"runtime-pm", no_argument, 0, 'g'},
+		{"wakeup", no_argument, 0, 'k'},
+		{"high-rate", required_argument, 0, 'H'},
+		{"iio-capture", required_argument, 0, 'I'},
+		{"iio-dir", required_argument, 0, OPT_IIO_DIR},
+		{"iio-dev", required_argument, 0, OPT_IIO_DEV},
+		{"iio-trigger", required_argument, 0, OPT_IIO_TRIGGER},
+		{"ams-regs", required_argument, 0, OPT_AMS_REGS},
+		{"ina-i2c", required_argument, 0, OPT_INA_I2C},
+		{"alarms", no_argument, 0, OPT_ALARMS},
+		{"high-rate-cpu", required_argument, 0, OPT_HIGH_RATE_CPU},
+		{"high-rate-sensors", required_argument, 0, OPT_HIGH_RATE_SENSORS},
 		{0,0,0,0}
 	};
 
 	while(1)
 	{
 		/* Parse arguments */
-		opt = getopt_long(argc, argv, "voacrspmfi:l:s:h",long_options, &options_index);
+		opt = getopt_long(argc, argv, "voacrspmfdtTwPugki:l:s:b:H:I:R:C:h",long_options, &options_index);
 		if (opt == -1)
 		{
 			break;
@@ -116,10 +173,28 @@ int main(int argc, char *argv[])
 				filename = optarg;
 				if(filename)
 				{
-				        int fd = open(filename,O_CREAT |O_WRONLY | O_APPEND, 0755);
-				        dup2(fd,1);
+					/*
+					 * Output buffered so far belongs to the previous
+					 * destination; the log fd is not kept open next to
+					 * stdout.
+					 */
+					int fd;
+
+					fflush(stdout);
+					fd = open(filename, O_CREAT | O_WRONLY | O_APPEND | O_CLOEXEC, 0644);
+					if(fd < 0 || dup2(fd, STDOUT_FILENO) < 0)
+					{
+						fprintf(stderr, "Unable to open log file %s\n", filename);
+					}
+					if(fd >= 0)
+					{
+						close(fd);
+					}
 				}
 				break;
+			case 'b':
+				benchmark_sensor_reads(atoi(optarg));
+				break;
 			case 'h':
 				print_usage();
 				break;
@@ -179,6 +254,126 @@ int main(int argc, char *argv[])
 					print_cpu_frequency(verbose_flag);
 				}
 				break;
+			case 'd':
+				print_devfreq_info(verbose_flag);
+				for(int i=1; i<interval; i++)
+				{
+					sleep(1);
+					print_devfreq_info(verbose_flag);
+				}
+				break;
+			case 't':
+				print_thermal_info(verbose_flag);
+				for(int i=1; i<interval; i++)
+				{
+					sleep(1);
+					print_thermal_info(verbose_flag);
+				}
+				break;
+			case 'T':
+				print_throttle_info(verbose_flag);
+				for(int i=1; i<interval; i++)
+				{
+					sleep(1);
+					print_throttle_info(verbose_flag);
+				}
+				break;
+			case 'w':
+				print_hwmon_sensor_info(verbose_flag);
+				for(int i=1; i<interval; i++)
+				{
+					sleep(1);
+					print_hwmon_sensor_info(verbose_flag);
+				}
+				break;
+			case 'R':
+				if(load_rail_model(optarg))
+				{
+					break;
+				}
+				print_rail_budget(verbose_flag);
+				for(int i=1; i<interval; i++)
+				{
+					sleep(1);
+					print_rail_budget(verbose_flag);
+				}
+				break;
+			case 'P':
+				print_cpu_power_estimate(verbose_flag);
+				for(int i=1; i<interval; i++)
+				{
+					sleep(1);
+					print_cpu_power_estimate(verbose_flag);
+				}
+				break;
+			case 'u':
+				print_process_power(verbose_flag);
+				for(int i=1; i<interval; i++)
+				{
+					sleep(1);
+					print_process_power(verbose_flag);
+				}
+				break;
+			case 'g':
+				print_runtime_pm_info(verbose_flag);
+				for(int i=1; i<interval; i++)
+				{
+					sleep(1);
+					print_runtime_pm_info(verbose_flag);
+				}
+				break;
+			case 'k':
+				print_wakeup_info(verbose_flag);
+				for(int i=1; i<interval; i++)
+				{
+					sleep(1);
+					print_wakeup_info(verbose_flag);
+				}
+				break;
+			case 'C':
+				calibrate_cpu_power(optarg, interval);
+				break;
+			case 'H':
+				if(start_power_sampling(atoi(optarg), high_rate_cpu,
+						high_rate_sensors))
+				{
+					break;
+				}
+				for(int i=0; i<interval; i++)
+				{
+					sleep(1);
+					print_power_sampling_stats(verbose_flag);
+				}
+				stop_power_sampling();
+				break;
+			case OPT_IIO_DIR:
+				iio_dir = optarg;
+				break;
+			case OPT_IIO_DEV:
+				iio_dev = optarg;
+				break;
+			case OPT_IIO_TRIGGER:
+				iio_trigger = optarg;
+				break;
+			case OPT_AMS_REGS:
+				load_ams_registers(optarg);
+				break;
+			case OPT_INA_I2C:
+				open_ina_i2c(optarg);
+				break;
+			case OPT_ALARMS:
+				start_alarm_monitoring();
+				break;
+			case OPT_HIGH_RATE_CPU:
+				high_rate_cpu = atoi(optarg);
+				break;
+			case OPT_HIGH_RATE_SENSORS:
+				high_rate_sensors = optarg;
+				break;
+			case 'I':
+				print_iio_capture(verbose_flag, iio_dir, iio_dev, iio_trigger,
+						atoi(optarg));
+				break;
 			default:
 				printf("Incorrect options passed, please see usage");
 				print_usage();
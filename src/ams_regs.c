@@ -0,0 +1,374 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ams_regs.h"
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API parses an unsigned number in any base accepted by strtoull.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int ams_parse_number(const char *tok, uint64_t *value)
+{
+	char *end;
+
+	errno = 0;
+	*value = strtoull(tok, &end, 0);
+	if(errno || *end != '\0' || tok[0] == '-')
+	{
+		return(EINVAL);
+	}
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API parses one line of an AMS register file into the map.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int ams_regs_parse_line(struct ams_regs *regs, char *line)
+{
+	char *tok[6];
+	char *save;
+	uint64_t value;
+	int num_tok;
+
+	num_tok = 0;
+	for(tok[0] = strtok_r(line, " \t\r\n", &save); tok[num_tok] != NULL;
+		tok[num_tok] = strtok_r(NULL, " \t\r\n", &save))
+	{
+		if(tok[num_tok][0] == '#' || ++num_tok == 6)
+		{
+			break;
+		}
+	}
+
+	if(num_tok == 0)
+	{
+		return(0);
+	}
+
+	if(!strcmp(tok[0], "device") && (num_tok == 2 || num_tok == 3))
+	{
+		snprintf(regs->dev_path, sizeof(regs->dev_path), "%s", tok[1]);
+		regs->base = 0;
+		if(num_tok == 3 && ams_parse_number(tok[2], &regs->base))
+		{
+			return(EINVAL);
+		}
+		return(0);
+	}
+
+	if(!strcmp(tok[0], "size") && num_tok == 2)
+	{
+		if(ams_parse_number(tok[1], &value) || value < sizeof(uint32_t) ||
+			value > UINT32_MAX)
+		{
+			return(EINVAL);
+		}
+		regs->size = value;
+		return(0);
+	}
+
+	if(!strcmp(tok[0], "reg") && (num_tok == 4 || num_tok == 5))
+	{
+		struct ams_reg *reg;
+
+		if(regs->num_regs == MAX_AMS_REGS)
+		{
+			return(ENOSPC);
+		}
+
+		if(ams_parse_number(tok[2], &value) || value % 4 || value > UINT32_MAX)
+		{
+			return(EINVAL);
+		}
+
+		reg = &regs->regs[regs->num_regs];
+		memset(reg, 0, sizeof(*reg));
+		snprintf(reg->name, sizeof(reg->name), "%s", tok[1]);
+		reg->offset = value;
+
+		if(num_tok == 4 && !strcmp(tok[3], "temp"))
+		{
+			reg->scale = AMS_TEMP_SCALE;
+			reg->bias = AMS_TEMP_OFFSET;
+		}
+		else if(num_tok == 4 && !strcmp(tok[3], "supply3"))
+		{
+			reg->scale = AMS_SUPPLY3_SCALE;
+		}
+		else if(num_tok == 4 && !strcmp(tok[3], "supply6"))
+		{
+			reg->scale = AMS_SUPPLY6_SCALE;
+		}
+		else if(num_tok == 5)
+		{
+			char *end1, *end2;
+
+			reg->scale = strtod(tok[3], &end1);
+			reg->bias = strtod(tok[4], &end2);
+			if(*end1 != '\0' || *end2 != '\0')
+			{
+				return(EINVAL);
+			}
+		}
+		else
+		{
+			return(EINVAL);
+		}
+
+		regs->num_regs++;
+		return(0);
+	}
+
+	return(EINVAL);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API loads an AMS register map from a text file. Each line is one of
+*
+*	device <path> [<offset of the block>]
+*	size <bytes>
+*	reg <name> <offset> temp | supply3 | supply6
+*	reg <name> <offset> <scale> <bias>
+*
+* The device is a UIO node with the block as its first map, /dev/mem with
+* the physical address of the block, or a regular file standing in for it.
+* Register offsets are relative to the block. The named transfer functions
+* are those of the AMS, PS and PL sysmon result registers; the last form
+* computes (raw & 0xffff) * scale + bias. Text after '#' is ignored.
+*
+* @param	regs: register map to fill
+* @param	path: register file
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int ams_regs_load(struct ams_regs *regs, const char *path)
+{
+	FILE *fp;
+	char line[256];
+	int line_no, ret, i;
+
+	memset(regs, 0, sizeof(*regs));
+	regs->fd = -1;
+
+	fp = fopen(path, "r");
+	if(fp == NULL)
+	{
+		return(errno);
+	}
+
+	line_no = 0;
+	ret = 0;
+
+	while(fgets(line, sizeof(line), fp) != NULL)
+	{
+		line_no++;
+
+		ret = ams_regs_parse_line(regs, line);
+		if(ret)
+		{
+			printf("%s:%d: invalid register definition\n", path, line_no);
+			break;
+		}
+	}
+
+	fclose(fp);
+
+	if(!ret && (regs->dev_path[0] == '\0' || regs->size == 0))
+	{
+		printf("%s: device and size are required\n", path);
+		ret = EINVAL;
+	}
+
+	for(i = 0; !ret && i < regs->num_regs; i++)
+	{
+		if(regs->regs[i].offset > regs->size - sizeof(uint32_t))
+		{
+			printf("%s: %s is outside the register block\n", path,
+				regs->regs[i].name);
+			ret = EINVAL;
+		}
+	}
+
+	if(ret)
+	{
+		memset(regs, 0, sizeof(*regs));
+		regs->fd = -1;
+		return(ret);
+	}
+
+	regs->loaded = 1;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API maps the register block of a loaded map read only. The mapping
+* starts at the page holding the block, as mmap requires.
+*
+* @param	regs: loaded register map
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int ams_regs_open(struct ams_regs *regs)
+{
+	struct stat st;
+	uint64_t page, delta;
+	int ret;
+
+	if(!regs->loaded)
+	{
+		return(EINVAL);
+	}
+
+	ams_regs_close(regs);
+
+	regs->fd = open(regs->dev_path, O_RDONLY | O_SYNC | O_CLOEXEC);
+	if(regs->fd < 0)
+	{
+		return(errno);
+	}
+
+	/* Touching a page past the end of a stand-in file raises SIGBUS */
+	if(fstat(regs->fd, &st) == 0 && S_ISREG(st.st_mode) &&
+		(uint64_t)st.st_size < regs->base + regs->size)
+	{
+		close(regs->fd);
+		regs->fd = -1;
+		return(EINVAL);
+	}
+
+	page = sysconf(_SC_PAGESIZE);
+	delta = regs->base % page;
+	regs->map_len = delta + regs->size;
+
+	regs->map = mmap(NULL, regs->map_len, PROT_READ, MAP_SHARED, regs->fd,
+			regs->base - delta);
+	if(regs->map == MAP_FAILED)
+	{
+		ret = errno;
+		regs->map = NULL;
+		close(regs->fd);
+		regs->fd = -1;
+		return(ret);
+	}
+
+	regs->block = (volatile const uint32_t *)((char *)regs->map + delta);
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads every register of the map with one 32 bit load each and
+* converts the results. No system call is made.
+*
+* @param	regs: opened register map
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void ams_regs_read(struct ams_regs *regs)
+{
+	int i;
+
+	for(i = 0; i < regs->num_regs; i++)
+	{
+		struct ams_reg *reg = &regs->regs[i];
+		uint32_t raw = regs->block[reg->offset / sizeof(uint32_t)];
+
+		reg->value = (long)((raw & 0xffff) * reg->scale + reg->bias);
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API returns the register of the given name, NULL if the map has none.
+*
+* @param	regs: register map
+* @param	name: register name
+*
+* @return	register, or NULL.
+*
+* @note		None.
+*
+******************************************************************************/
+struct ams_reg *ams_regs_lookup(struct ams_regs *regs, const char *name)
+{
+	int i;
+
+	for(i = 0; i < regs->num_regs; i++)
+	{
+		if(!strcmp(regs->regs[i].name, name))
+		{
+			return(&regs->regs[i]);
+		}
+	}
+
+	return(NULL);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API unmaps the register block. The map stays loaded.
+*
+* @param	regs: register map
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void ams_regs_close(struct ams_regs *regs)
+{
+	if(regs->map != NULL)
+	{
+		munmap(regs->map, regs->map_len);
+		regs->map = NULL;
+		regs->block = NULL;
+	}
+
+	if(regs->fd >= 0)
+	{
+		close(regs->fd);
+		regs->fd = -1;
+	}
+}
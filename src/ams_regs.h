@@ -0,0 +1,59 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+#ifndef _PLATFORMSTATS_AMS_REGS_H_
+#define _PLATFORMSTATS_AMS_REGS_H_
+
+#include <stdint.h>
+
+/************************** Constant Definitions *****************************/
+#define MAX_AMS_REGS		32
+#define AMS_REG_NAME_LEN	32
+#define AMS_PATH_LEN		256
+
+/*
+ * Transfer functions of the 16 bit AMS result registers, in hwmon units:
+ * millidegrees Celsius for temperatures, millivolts for supplies.
+ */
+#define AMS_TEMP_SCALE		(509314.0 / 65536.0)
+#define AMS_TEMP_OFFSET		(-280230.0)
+#define AMS_SUPPLY3_SCALE	(3000.0 / 65536.0)
+#define AMS_SUPPLY6_SCALE	(6000.0 / 65536.0)
+
+/**************************** Type Definitions *******************************/
+struct ams_reg {
+	char name[AMS_REG_NAME_LEN];	/* hwmon attribute it replaces, e.g. temp1 */
+	uint32_t offset;		/* byte offset in the register block */
+	double scale;			/* value = (raw & 0xffff) * scale + bias */
+	double bias;
+	long value;
+};
+
+/*
+ * A register map of the AMS block and, once opened, the mapping of the block
+ * through UIO or /dev/mem. Any file large enough to hold the block can
+ * stand in for the device.
+ */
+struct ams_regs {
+	int loaded;
+	char dev_path[AMS_PATH_LEN];
+	uint64_t base;			/* offset of the block in dev_path */
+	uint32_t size;			/* bytes of the block */
+	int num_regs;
+	struct ams_reg regs[MAX_AMS_REGS];
+	int fd;
+	void *map;			/* page aligned mapping, NULL if closed */
+	size_t map_len;
+	volatile const uint32_t *block;	/* first register of the block */
+};
+
+/************************** Function Prototypes  *****************************/
+int ams_regs_load(struct ams_regs *regs, const char *path);
+int ams_regs_open(struct ams_regs *regs);
+void ams_regs_read(struct ams_regs *regs);
+struct ams_reg *ams_regs_lookup(struct ams_regs *regs, const char *name);
+void ams_regs_close(struct ams_regs *regs);
+
+#endif /* _PLATFORMSTATS_AMS_REGS_H_ */
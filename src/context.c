@@ -0,0 +1,1851 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/sysinfo.h>
+
+#include "context.h"
+#include "utils.h"
+
+/************************** Constant Definitions *****************************/
+enum {
+	MEMINFO_MEM_TOTAL, MEMINFO_MEM_FREE, MEMINFO_MEM_AVAILABLE,
+	MEMINFO_SWAP_TOTAL, MEMINFO_SWAP_FREE, MEMINFO_CMA_TOTAL, MEMINFO_CMA_FREE,
+	MEMINFO_NUM_KEYS
+};
+
+/* Unit the published snapshot is copied in, see ps_context_publish */
+typedef unsigned long __attribute__((__may_alias__)) ps_word_t;
+
+#define PS_SNAPSHOT_WORDS	(sizeof(struct ps_snapshot) / sizeof(ps_word_t))
+
+_Static_assert(sizeof(struct ps_snapshot) % sizeof(ps_word_t) == 0,
+	"ps_snapshot is copied in whole words");
+
+/************************** Variable Definitions *****************************/
+static const char *const meminfo_keys[MEMINFO_NUM_KEYS] = {
+	"MemTotal", "MemFree", "MemAvailable",
+	"SwapTotal", "SwapFree", "CmaTotal", "CmaFree"
+};
+
+const char *const ps_som_attrs[PS_SOM_NUM] = {
+	"power1", "curr1", "in1"
+};
+
+const char *const ps_sysmon_attrs[PS_SYSMON_NUM] = {
+	"temp1", "temp2", "temp3",
+	"in1", "in3", "in6",
+	"in7", "in9", "in13",
+	"in16", "in17"
+};
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API takes size bytes from the arena. While the layout is measured,
+* the arena has no memory and NULL is returned.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void *ps_arena_alloc(struct ps_arena *arena, size_t size)
+{
+	void *ptr;
+
+	size = (size + sizeof(long long) - 1) & ~(sizeof(long long) - 1);
+	ptr = arena->base ? arena->base + arena->used : NULL;
+	arena->used += size;
+
+	return(ptr);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API lays the per CPU arrays, the parse buffer and the collectors out
+* in the arena. The parse buffer fits the largest of the files read for
+* num_cpus CPUs.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_context_layout(struct ps_context *ctx)
+{
+	size_t n = ctx->num_cpus;
+
+	ctx->arena.used = 0;
+
+	ctx->buf_len = PROC_STAT_BUF_LEN(n);
+	if(ctx->buf_len < PROC_MEMINFO_BUF_LEN)
+	{
+		ctx->buf_len = PROC_MEMINFO_BUF_LEN;
+	}
+	if(ctx->buf_len < PROC_CPUINFO_BUF_LEN(n))
+	{
+		ctx->buf_len = PROC_CPUINFO_BUF_LEN(n);
+	}
+
+	ctx->prev = ps_arena_alloc(&ctx->arena, n * sizeof(*ctx->prev));
+	ctx->prev_status = ps_arena_alloc(&ctx->arena, n * sizeof(*ctx->prev_status));
+	ctx->cur = ps_arena_alloc(&ctx->arena, n * sizeof(*ctx->cur));
+	ctx->cur_status = ps_arena_alloc(&ctx->arena, n * sizeof(*ctx->cur_status));
+	ctx->mhz = ps_arena_alloc(&ctx->arena, n * sizeof(*ctx->mhz));
+	ctx->mhz_status = ps_arena_alloc(&ctx->arena, n * sizeof(*ctx->mhz_status));
+	ctx->buf = ps_arena_alloc(&ctx->arena, ctx->buf_len);
+	ctx->pending = ps_arena_alloc(&ctx->arena, sizeof(*ctx->pending));
+	ctx->latest = ps_arena_alloc(&ctx->arena, sizeof(*ctx->latest));
+
+	ctx->powercap = ps_arena_alloc(&ctx->arena, sizeof(*ctx->powercap));
+	ctx->supplies = ps_arena_alloc(&ctx->arena, sizeof(*ctx->supplies));
+	ctx->regulators = ps_arena_alloc(&ctx->arena, sizeof(*ctx->regulators));
+	ctx->rails = ps_arena_alloc(&ctx->arena, sizeof(*ctx->rails));
+	ctx->throttle = ps_arena_alloc(&ctx->arena, sizeof(*ctx->throttle));
+	ctx->cpu_power = ps_arena_alloc(&ctx->arena, sizeof(*ctx->cpu_power));
+	ctx->proc_power = ps_arena_alloc(&ctx->arena, sizeof(*ctx->proc_power));
+	ctx->rpm = ps_arena_alloc(&ctx->arena, sizeof(*ctx->rpm));
+	ctx->wakeup = ps_arena_alloc(&ctx->arena, sizeof(*ctx->wakeup));
+	ctx->proc_order = ps_arena_alloc(&ctx->arena,
+		MAX_PROC_ENTRIES * sizeof(*ctx->proc_order));
+	ctx->rpm_order = ps_arena_alloc(&ctx->arena,
+		MAX_RPM_DEVICES * sizeof(*ctx->rpm_order));
+	ctx->alarms = ps_arena_alloc(&ctx->arena, sizeof(*ctx->alarms));
+	ctx->sampler = ps_arena_alloc(&ctx->arena, sizeof(*ctx->sampler));
+}
+
+/*****************************************************************************/
+/*
+*
+* This API creates a collection context. The proc and cpufreq files are
+* opened, and the hwmon devices, thermal zones and devfreq devices found,
+* once here; collecting through the context only reads them. Sources that
+* are missing are reported through the snapshot status fields, so creation
+* only fails for lack of memory. All the scratch memory collection needs is
+* allocated here too, so collecting never allocates, except when a hwmon
+* uevent makes the sensor table rescan /sys/class/hwmon: the rescan opens
+* directory streams and copies the previous sensors, and frees both before
+* the collection returns. The devices of the groups derived over time are
+* scanned by their first collection instead, see ps_context_probe.
+*
+* @return	context, or NULL if it could not be allocated.
+*
+* @note		None.
+*
+******************************************************************************/
+struct ps_context *ps_context_create(void)
+{
+	struct ps_context *ctx;
+	char path[128];
+	int i;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if(ctx == NULL)
+	{
+		return(NULL);
+	}
+
+	ctx->num_cpus = get_nprocs_conf();
+	if(ctx->num_cpus > PS_MAX_CPUS)
+	{
+		ctx->num_cpus = PS_MAX_CPUS;
+	}
+
+	ps_context_layout(ctx);
+	ctx->arena.size = ctx->arena.used;
+	ctx->arena.base = calloc(1, ctx->arena.size);
+	if(ctx->arena.base == NULL)
+	{
+		free(ctx);
+		return(NULL);
+	}
+	ps_context_layout(ctx);
+	pthread_mutex_init(&ctx->publish_lock, NULL);
+
+	ctx->stat_fd = open(PROC_STAT_PATH, O_RDONLY | O_CLOEXEC);
+	ctx->meminfo_fd = open(PROC_MEMINFO_PATH, O_RDONLY | O_CLOEXEC);
+	ctx->cpuinfo_fd = open(PROC_CPUINFO_PATH, O_RDONLY | O_CLOEXEC);
+
+	for(i = 0; i < ctx->num_cpus; i++)
+	{
+		snprintf(path, sizeof(path), CPUFREQ_CUR_FMT, i);
+		ctx->freq_fd[i] = open(path, O_RDONLY | O_CLOEXEC);
+	}
+
+	/* Building the sensor table indexes the hwmon devices */
+	ctx->hwmon.uevent_fd = -1;
+	hwmon_sensors_init(&ctx->sensors, &ctx->hwmon);
+	hwmon_sensor_set_init(&ctx->som_set, PS_SOM_DEVICE, ps_som_attrs, PS_SOM_NUM);
+	hwmon_sensor_set_init(&ctx->sysmon_set, PS_SYSMON_DEVICE, ps_sysmon_attrs,
+		PS_SYSMON_NUM);
+
+	thermal_init(&ctx->thermal);
+	devfreq_init(&ctx->devfreq);
+
+	ctx->ina.fd = -1;
+	ctx->ams.fd = -1;
+
+	power_sampler_init(ctx->sampler);
+
+	return(ctx);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API scans the collectors of a context that walk a directory tree to
+* find their devices, the first time they are asked for. The CPU power
+* coefficients are taken from CPU_POWER_MODEL_PATH, or else from the kernel
+* energy model, and the rail model from RAIL_CONFIG_PATH unless one was
+* loaded with ps_context_load_rail_model. Collectors without devices stay
+* probed, their status tells why.
+*
+* @param	ctx: context
+* @param	what: PS_PROBE_* collectors
+*
+* @return	None.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+void ps_context_probe(struct ps_context *ctx, unsigned int what)
+{
+	what &= ~ctx->probed;
+	ctx->probed |= what;
+
+	if(what & PS_PROBE_POWERCAP)
+	{
+		powercap_init(ctx->powercap);
+	}
+	if(what & PS_PROBE_SUPPLY)
+	{
+		supply_power_supplies_init(ctx->supplies);
+		supply_regulators_init(ctx->regulators);
+	}
+	if(what & PS_PROBE_RAILS)
+	{
+		rail_model_load(ctx->rails, RAIL_CONFIG_PATH);
+	}
+	if(what & PS_PROBE_THROTTLE)
+	{
+		throttle_init(ctx->throttle);
+	}
+	if(what & PS_PROBE_CPU_POWER)
+	{
+		if(!cpu_power_init(ctx->cpu_power) &&
+			cpu_power_load(ctx->cpu_power, CPU_POWER_MODEL_PATH))
+		{
+			cpu_power_load_energy_model(ctx->cpu_power, ENERGY_MODEL_PATH);
+		}
+	}
+	if(what & PS_PROBE_PROC_POWER)
+	{
+		proc_power_init(ctx->proc_power);
+	}
+	if(what & PS_PROBE_RUNTIME_PM)
+	{
+		rpm_init(ctx->rpm);
+	}
+	if(what & PS_PROBE_WAKEUP)
+	{
+		wakeup_init(ctx->wakeup);
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API stops the threads started on a context, closes every file of it
+* and frees it.
+*
+* @param	ctx: context, may be NULL
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void ps_context_destroy(struct ps_context *ctx)
+{
+	int i;
+
+	if(ctx == NULL)
+	{
+		return;
+	}
+
+	if(ctx->stat_fd >= 0)
+	{
+		close(ctx->stat_fd);
+	}
+	if(ctx->meminfo_fd >= 0)
+	{
+		close(ctx->meminfo_fd);
+	}
+	if(ctx->cpuinfo_fd >= 0)
+	{
+		close(ctx->cpuinfo_fd);
+	}
+	for(i = 0; i < ctx->num_cpus; i++)
+	{
+		if(ctx->freq_fd[i] >= 0)
+		{
+			close(ctx->freq_fd[i]);
+		}
+	}
+
+	ps_context_stop_alarms(ctx);
+	power_sampler_stop(ctx->sampler);
+	pthread_mutex_destroy(&ctx->sampler->lock);
+
+	powercap_release(ctx->powercap);
+	supply_class_release(ctx->supplies);
+	supply_class_release(ctx->regulators);
+	throttle_release(ctx->throttle);
+	cpu_power_release(ctx->cpu_power);
+	proc_power_release(ctx->proc_power);
+	rpm_release(ctx->rpm);
+	wakeup_release(ctx->wakeup);
+
+	hwmon_sensors_release(&ctx->sensors);
+	hwmon_index_release(&ctx->hwmon);
+	thermal_release(&ctx->thermal);
+	devfreq_release(&ctx->devfreq);
+	ina_i2c_close(&ctx->ina);
+	ams_regs_close(&ctx->ams);
+
+	pthread_mutex_destroy(&ctx->publish_lock);
+	free(ctx->arena.base);
+	free(ctx);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API makes a context read the SOM power monitor directly over i2c-dev
+* instead of through its hwmon driver. The monitor is given as
+*
+*	<i2c-dev node>,<address>[,ina260]
+*	<i2c-dev node>,<address>,ina226,<shunt uOhm>
+*
+* e.g. /dev/i2c-1,0x40. On failure the context goes back to hwmon, and
+* ctx->ina.dev_path is empty if spec itself was invalid.
+*
+* @param	ctx: context
+* @param	spec: monitor specification
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int ps_context_open_ina_i2c(struct ps_context *ctx, const char *spec)
+{
+	char buf[INA_I2C_PATH_LEN + 64];
+	char *tok[4], *save, *end;
+	enum ina_chip chip;
+	long addr, shunt_uohm;
+	int num_tok, ret;
+
+	ina_i2c_close(&ctx->ina);
+	ctx->ina_active = 0;
+	ctx->ina.dev_path[0] = '\0';
+
+	snprintf(buf, sizeof(buf), "%s", spec);
+	num_tok = 0;
+	for(tok[0] = strtok_r(buf, ",", &save); tok[num_tok] != NULL;
+		tok[num_tok] = strtok_r(NULL, ",", &save))
+	{
+		if(++num_tok == 4)
+		{
+			break;
+		}
+	}
+
+	ret = EINVAL;
+	chip = INA_CHIP_INA260;
+	shunt_uohm = 0;
+	if(num_tok >= 2)
+	{
+		addr = strtol(tok[1], &end, 0);
+		ret = (*end != '\0' || addr < 0x03 || addr > 0x77) ? EINVAL : 0;
+	}
+	if(!ret && num_tok == 3 && strcmp(tok[2], "ina260"))
+	{
+		ret = EINVAL;
+	}
+	if(!ret && num_tok == 4)
+	{
+		chip = INA_CHIP_INA226;
+		shunt_uohm = strtol(tok[3], &end, 0);
+		ret = (strcmp(tok[2], "ina226") || *end != '\0') ? EINVAL : 0;
+	}
+	if(ret)
+	{
+		return(ret);
+	}
+
+	ret = ina_i2c_open(&ctx->ina, tok[0], addr, chip, shunt_uohm);
+	if(ret)
+	{
+		return(ret);
+	}
+
+	ctx->ina_active = 1;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API makes a context read the AMS values from the mapped AMS register
+* block instead of the ams hwmon device. Each sysmon value is taken from the
+* register named after its hwmon attribute (temp1, in1, ...). On failure the
+* context goes back to hwmon, and ctx->ams.loaded tells whether the file was
+* loaded but its block could not be mapped.
+*
+* @param	ctx: context
+* @param	path: AMS register file
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int ps_context_load_ams_registers(struct ps_context *ctx, const char *path)
+{
+	int ret;
+
+	ams_regs_close(&ctx->ams);
+	ctx->ams_active = 0;
+
+	ret = ams_regs_load(&ctx->ams, path);
+	if(ret)
+	{
+		return(ret);
+	}
+
+	ret = ams_regs_open(&ctx->ams);
+	if(ret)
+	{
+		return(ret);
+	}
+
+	ctx->ams_active = 1;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API loads the rail model of a context from path, replacing the one
+* loaded so far. The file maps power monitor sensors to named rails and
+* rail groups with an optional power budget per group, see rail_model_load.
+*
+* @param	ctx: context
+* @param	path: rail file
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int ps_context_load_rail_model(struct ps_context *ctx, const char *path)
+{
+	ctx->probed |= PS_PROBE_RAILS;
+
+	return(rail_model_load(ctx->rails, path));
+}
+
+/*****************************************************************************/
+/*
+*
+* This API starts watching the alarm attributes of the hwmon devices of a
+* context from a background thread. The thread is only started here, so
+* contexts that do not ask for alarms pay nothing for it. It reads nothing
+* of the context after starting, so the context may be collected through
+* concurrently.
+*
+* @param	ctx: context
+*
+* @return	0 on success or if already started, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int ps_context_start_alarms(struct ps_context *ctx)
+{
+	if(ctx->alarms->running)
+	{
+		return(0);
+	}
+
+	hwmon_sensors_sync(&ctx->sensors);
+
+	return(hwmon_alarm_monitor_start(ctx->alarms, &ctx->sensors));
+}
+
+/*****************************************************************************/
+/*
+*
+* This API stops the alarm thread started by ps_context_start_alarms.
+*
+* @param	ctx: context
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void ps_context_stop_alarms(struct ps_context *ctx)
+{
+	if(ctx->alarms->running)
+	{
+		hwmon_alarm_monitor_stop(ctx->alarms);
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API returns CLOCK_MONOTONIC in ns.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static long long ps_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return((long long)ts.tv_sec * 1000000000LL + ts.tv_nsec);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads the CPU counters from /proc/stat and computes the load of
+* every CPU over the window since the previous collection.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_collect_cpu_util(struct ps_context *ctx, struct ps_snapshot *snap)
+{
+	size_t len;
+	int i, ret;
+
+	ret = ctx->stat_fd < 0 ? ENOENT :
+		procfs_read(ctx->stat_fd, ctx->buf, PROC_STAT_BUF_LEN(ctx->num_cpus), &len);
+	if(ret)
+	{
+		for(i = 0; i < ctx->num_cpus; i++)
+		{
+			snap->cpus[i].stat_status = ret;
+		}
+		return;
+	}
+
+	procfs_parse_stat(ctx->buf, ctx->cur, ctx->cur_status, ctx->num_cpus);
+
+	for(i = 0; i < ctx->num_cpus; i++)
+	{
+		struct ps_cpu *cpu = &snap->cpus[i];
+
+		cpu->stat = ctx->cur[i];
+		cpu->stat_status = ctx->cur_status[i];
+		cpu->stat.total_util = ctx->prev_ns && !ctx->prev_status[i] && !ctx->cur_status[i] ?
+			calculate_load(&ctx->prev[i], &ctx->cur[i]) : 0;
+
+		ctx->prev[i] = ctx->cur[i];
+		ctx->prev_status[i] = ctx->cur_status[i];
+	}
+
+	snap->util_window_ns = ctx->prev_ns ? snap->timestamp_ns - ctx->prev_ns : 0;
+	ctx->prev_ns = snap->timestamp_ns;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads the current frequency of every CPU from cpufreq, or from
+* /proc/cpuinfo for CPUs without cpufreq.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_collect_cpu_freq(struct ps_context *ctx, struct ps_snapshot *snap)
+{
+	size_t len;
+	int i, j, ret, cpuinfo_read = 0;
+
+	for(i = 0; i < ctx->num_cpus; i++)
+	{
+		struct ps_cpu *cpu = &snap->cpus[i];
+		char buf[32];
+		long khz;
+
+		if(ctx->freq_fd[i] >= 0)
+		{
+			ret = procfs_read(ctx->freq_fd[i], buf, sizeof(buf), &len);
+			if(!ret)
+			{
+				ret = parse_long(buf, len, &khz);
+			}
+			cpu->freq_status = ret;
+			cpu->freq_mhz = ret ? 0 : khz / 1000.0;
+			continue;
+		}
+
+		if(!cpuinfo_read)
+		{
+			cpuinfo_read = 1;
+			ret = ctx->cpuinfo_fd < 0 ? ENOENT :
+				procfs_read(ctx->cpuinfo_fd, ctx->buf, ctx->buf_len, &len);
+			if(ret)
+			{
+				for(j = 0; j < ctx->num_cpus; j++)
+				{
+					ctx->mhz[j] = 0;
+					ctx->mhz_status[j] = ret;
+				}
+			}
+			else
+			{
+				procfs_parse_cpuinfo_mhz(ctx->buf, ctx->mhz, ctx->mhz_status,
+					ctx->num_cpus);
+			}
+		}
+
+		cpu->freq_status = ctx->mhz_status[i];
+		cpu->freq_mhz = ctx->mhz_status[i] ? 0 : ctx->mhz[i];
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads RAM, swap and CMA usage from /proc/meminfo.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_collect_memory(struct ps_context *ctx, struct ps_snapshot *snap)
+{
+	unsigned long values[MEMINFO_NUM_KEYS];
+	int status[MEMINFO_NUM_KEYS];
+	struct ps_memory *mem = &snap->mem;
+	size_t len;
+	int i, ret;
+
+	memset(mem, 0, sizeof(*mem));
+
+	ret = ctx->meminfo_fd < 0 ? ENOENT :
+		procfs_read(ctx->meminfo_fd, ctx->buf, PROC_MEMINFO_BUF_LEN, &len);
+	if(ret)
+	{
+		mem->mem_status = mem->swap_status = mem->cma_status = ret;
+		return;
+	}
+
+	procfs_parse_meminfo(ctx->buf, meminfo_keys, values, status, MEMINFO_NUM_KEYS);
+	for(i = 0; i < MEMINFO_NUM_KEYS; i++)
+	{
+		if(status[i])
+		{
+			values[i] = 0;
+		}
+	}
+
+	mem->mem_total = values[MEMINFO_MEM_TOTAL];
+	mem->mem_free = values[MEMINFO_MEM_FREE];
+	mem->mem_available = values[MEMINFO_MEM_AVAILABLE];
+	mem->mem_status = status[MEMINFO_MEM_TOTAL] | status[MEMINFO_MEM_FREE] |
+		status[MEMINFO_MEM_AVAILABLE];
+	mem->swap_total = values[MEMINFO_SWAP_TOTAL];
+	mem->swap_free = values[MEMINFO_SWAP_FREE];
+	mem->swap_status = status[MEMINFO_SWAP_TOTAL] | status[MEMINFO_SWAP_FREE];
+	mem->cma_total = values[MEMINFO_CMA_TOTAL];
+	mem->cma_free = values[MEMINFO_CMA_FREE];
+	mem->cma_status = status[MEMINFO_CMA_TOTAL] | status[MEMINFO_CMA_FREE];
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads a sensor set of one hwmon device into values and status.
+* Every status is ENODEV when the device is absent and ENOENT for attributes
+* the device does not have.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_collect_sensor_set(struct ps_context *ctx, struct hwmon_sensor_set *set,
+		long *values, int *status)
+{
+	int i;
+
+	hwmon_sensors_sync(&ctx->sensors);
+	if(hwmon_index_lookup(&ctx->hwmon, set->device) == NULL)
+	{
+		for(i = 0; i < set->num_attrs; i++)
+		{
+			values[i] = 0;
+			status[i] = ENODEV;
+		}
+		return;
+	}
+
+	hwmon_sensor_set_read(&ctx->sensors, set);
+
+	for(i = 0; i < set->num_attrs; i++)
+	{
+		struct hwmon_sensor *sensor = set->sensors[i];
+
+		status[i] = sensor == NULL ? ENOENT : sensor->status;
+		values[i] = status[i] ? 0 : sensor->value;
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads the SOM power monitor, through i2c-dev when it was opened
+* with ps_context_open_ina_i2c and through hwmon otherwise.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_collect_som_power(struct ps_context *ctx, struct ps_snapshot *snap)
+{
+	int i, ret;
+
+	if(!ctx->ina_active)
+	{
+		ps_collect_sensor_set(ctx, &ctx->som_set, snap->som, snap->som_status);
+		return;
+	}
+
+	ret = ina_i2c_read(&ctx->ina);
+	snap->som[PS_SOM_POWER] = ctx->ina.power_uw;
+	snap->som[PS_SOM_CURRENT] = ctx->ina.current_ma;
+	snap->som[PS_SOM_VOLTAGE] = ctx->ina.voltage_mv;
+	for(i = 0; i < PS_SOM_NUM; i++)
+	{
+		snap->som_status[i] = ret;
+		if(ret)
+		{
+			snap->som[i] = 0;
+		}
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads the AMS values, from the mapped AMS registers when they
+* were loaded with ps_context_load_ams_registers and through hwmon otherwise.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_collect_sysmon(struct ps_context *ctx, struct ps_snapshot *snap)
+{
+	int i;
+
+	if(!ctx->ams_active)
+	{
+		ps_collect_sensor_set(ctx, &ctx->sysmon_set, snap->sysmon, snap->sysmon_status);
+		return;
+	}
+
+	ams_regs_read(&ctx->ams);
+	for(i = 0; i < PS_SYSMON_NUM; i++)
+	{
+		struct ams_reg *reg = ams_regs_lookup(&ctx->ams, ps_sysmon_attrs[i]);
+
+		snap->sysmon_status[i] = reg == NULL ? ENOENT : 0;
+		snap->sysmon[i] = reg == NULL ? 0 : reg->value;
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API copies the temperature, trip points and headroom of every thermal
+* zone and the state of every cooling device.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_collect_thermal(struct ps_context *ctx, struct ps_snapshot *snap)
+{
+	struct thermal_index *th = &ctx->thermal;
+	int i, j;
+
+	thermal_read(th);
+
+	snap->num_zones = th->num_zones < PS_MAX_THERMAL_ZONES ?
+		th->num_zones : PS_MAX_THERMAL_ZONES;
+	for(i = 0; i < snap->num_zones; i++)
+	{
+		struct thermal_zone *zone = &th->zones[i];
+		struct ps_thermal_zone *out = &snap->zones[i];
+
+		out->id = zone->id;
+		snprintf(out->type, sizeof(out->type), "%s", zone->type);
+		out->status = zone->status;
+		out->temp = zone->status ? 0 : zone->temp;
+		out->has_trip = !zone->status && zone->nearest >= 0 &&
+			zone->nearest < PS_MAX_TRIPS;
+		out->nearest = out->has_trip ? zone->nearest : -1;
+		out->headroom = out->has_trip ? zone->headroom : 0;
+
+		out->num_trips = zone->num_trips < PS_MAX_TRIPS ?
+			zone->num_trips : PS_MAX_TRIPS;
+		for(j = 0; j < out->num_trips; j++)
+		{
+			out->trips[j].temp = zone->trips[j].temp;
+			snprintf(out->trips[j].type, sizeof(out->trips[j].type), "%s",
+				zone->trips[j].type);
+		}
+	}
+
+	snap->num_cooling = th->num_cooling < PS_MAX_COOLING ?
+		th->num_cooling : PS_MAX_COOLING;
+	for(i = 0; i < snap->num_cooling; i++)
+	{
+		struct cooling_device *cdev = &th->cooling[i];
+		struct ps_cooling_device *out = &snap->cooling[i];
+
+		out->id = cdev->id;
+		snprintf(out->type, sizeof(out->type), "%s", cdev->type);
+		out->status = cdev->status;
+		out->cur_state = cdev->status ? 0 : cdev->cur_state;
+		out->max_state = cdev->max_state;
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API copies the current frequency, governor and frequency residency
+* over the window of every devfreq device.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_collect_devfreq(struct ps_context *ctx, struct ps_snapshot *snap)
+{
+	struct devfreq_index *df = &ctx->devfreq;
+	int i, j;
+
+	devfreq_read(df);
+
+	snap->num_devfreq = df->num_devices < PS_MAX_DEVFREQ ?
+		df->num_devices : PS_MAX_DEVFREQ;
+	for(i = 0; i < snap->num_devfreq; i++)
+	{
+		struct devfreq_device *dev = &df->devices[i];
+		struct ps_devfreq *out = &snap->devfreq[i];
+
+		snprintf(out->name, sizeof(out->name), "%s", dev->name);
+		snprintf(out->governor, sizeof(out->governor), "%s", dev->governor);
+		out->status = dev->status;
+		out->cur_freq = dev->status ? 0 : dev->cur_freq;
+		out->window_ms = dev->window_ms;
+		out->transitions = dev->delta_transitions;
+
+		out->num_states = dev->num_states < PS_MAX_DEVFREQ_STATES ?
+			dev->num_states : PS_MAX_DEVFREQ_STATES;
+		for(j = 0; j < out->num_states; j++)
+		{
+			out->states[j].freq = dev->states[j].freq;
+			out->states[j].delta_ms = dev->states[j].delta_ms;
+		}
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API copies the report of an energy accumulator, starting its next
+* window.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_copy_energy(struct ps_energy *out, struct energy_accum *acc)
+{
+	struct energy_report rep;
+
+	energy_accum_report(acc, &rep);
+
+	out->window_joules = rep.window_joules;
+	out->window_seconds = rep.window_seconds;
+	out->total_joules = rep.total_joules;
+	out->total_seconds = rep.total_seconds;
+	out->avg_watts = rep.avg_watts;
+	out->peak_watts = rep.peak_watts;
+	out->num_samples = acc->num_samples;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads every hwmon sensor and powercap energy counter and copies
+* the energy of every power sensor and powercap domain over the window.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_collect_energy(struct ps_context *ctx, struct ps_snapshot *snap)
+{
+	struct hwmon_sensor_table *tbl = &ctx->sensors;
+	struct powercap_index *pc = ctx->powercap;
+	int i, n = 0;
+
+	ps_context_probe(ctx, PS_PROBE_POWERCAP);
+
+	hwmon_sensors_read_all(tbl);
+	powercap_read(pc);
+
+	for(i = 0; i < tbl->num_sensors && n < PS_MAX_ENERGY; i++)
+	{
+		struct hwmon_sensor *sensor = &tbl->sensors[i];
+		struct ps_energy *out = &snap->energy[n];
+
+		if(sensor->type != HWMON_SENSOR_POWER)
+		{
+			continue;
+		}
+
+		memset(out, 0, sizeof(*out));
+		snprintf(out->device, sizeof(out->device), "%s", sensor->device);
+		snprintf(out->label, sizeof(out->label), "%s", sensor->label);
+		out->status = sensor->status;
+		ps_copy_energy(out, &sensor->energy);
+		n++;
+	}
+
+	for(i = 0; i < pc->num_domains && n < PS_MAX_ENERGY; i++)
+	{
+		struct powercap_domain *dom = &pc->domains[i];
+		struct ps_energy *out = &snap->energy[n++];
+
+		memset(out, 0, sizeof(*out));
+		snprintf(out->device, sizeof(out->device), "%s", dom->zone);
+		snprintf(out->label, sizeof(out->label), "%s", dom->name);
+		out->powercap = 1;
+		out->status = dom->status;
+		out->wraps = dom->wraps;
+		if(!dom->status)
+		{
+			ps_copy_energy(out, &dom->energy);
+		}
+	}
+
+	snap->num_energy = n;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API copies the devices of a power_supply or regulator class, mapping
+* the attributes of the class to enum ps_supply_value.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int ps_copy_supplies(struct supply_class *cls, const int *map,
+		struct ps_supply *out)
+{
+	int i, j, n;
+
+	supply_class_read(cls);
+
+	n = cls->num_devices < PS_MAX_SUPPLIES ? cls->num_devices : PS_MAX_SUPPLIES;
+	for(i = 0; i < n; i++)
+	{
+		struct supply_device *dev = &cls->devices[i];
+
+		snprintf(out[i].name, sizeof(out[i].name), "%s", dev->name);
+		snprintf(out[i].dir, sizeof(out[i].dir), "%s", dev->dir);
+		for(j = 0; j < PS_SUPPLY_NUM; j++)
+		{
+			out[i].value[j] = 0;
+			out[i].status[j] = ENOENT;
+		}
+		for(j = 0; j < cls->num_attrs; j++)
+		{
+			out[i].status[map[j]] = dev->status[j];
+			out[i].value[map[j]] = dev->status[j] ? 0 : dev->value[j];
+		}
+	}
+
+	return(n);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads the voltage, current, power and energy of every power
+* supply and the output voltage and current of every regulator.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_collect_supply(struct ps_context *ctx, struct ps_snapshot *snap)
+{
+	static const int supply_map[] = {
+		[SUPPLY_VOLTAGE] = PS_SUPPLY_VOLTAGE,
+		[SUPPLY_CURRENT] = PS_SUPPLY_CURRENT,
+		[SUPPLY_POWER] = PS_SUPPLY_POWER,
+		[SUPPLY_ENERGY] = PS_SUPPLY_ENERGY,
+	};
+	static const int regulator_map[] = {
+		[REGULATOR_MICROVOLTS] = PS_SUPPLY_VOLTAGE,
+		[REGULATOR_MICROAMPS] = PS_SUPPLY_CURRENT,
+	};
+
+	ps_context_probe(ctx, PS_PROBE_SUPPLY);
+
+	snap->num_supplies = ps_copy_supplies(ctx->supplies, supply_map,
+				snap->supplies);
+	snap->num_regulators = ps_copy_supplies(ctx->regulators, regulator_map,
+				snap->regulators);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads every rail of the rail model and copies the power of each
+* rail and the totals and headroom of each rail group.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_collect_rails(struct ps_context *ctx, struct ps_snapshot *snap)
+{
+	struct rail_model *model = ctx->rails;
+	struct ps_rails *out = &snap->rails;
+	int i;
+
+	ps_context_probe(ctx, PS_PROBE_RAILS);
+
+	out->num_rails = 0;
+	out->num_groups = 0;
+	out->total_watts = 0;
+	out->status = model->loaded ? 0 : ENOENT;
+	if(out->status)
+	{
+		return;
+	}
+
+	rail_model_update(model, &ctx->sensors);
+
+	out->total_watts = model->total_watts;
+	out->num_rails = model->num_rails < PS_MAX_RAILS ? model->num_rails : PS_MAX_RAILS;
+	for(i = 0; i < out->num_rails; i++)
+	{
+		struct rail *rail = &model->rails[i];
+		struct ps_rail *r = &out->rails[i];
+
+		snprintf(r->name, sizeof(r->name), "%s", rail->name);
+		snprintf(r->device, sizeof(r->device), "%s", rail->device);
+		snprintf(r->attr, sizeof(r->attr), "%s", rail->power_attr[0] ?
+			rail->power_attr : rail->curr_attr);
+		r->group = rail->group;
+		r->watts = rail->valid ? rail->watts : 0;
+
+		if(rail->valid)
+		{
+			r->status = 0;
+		}
+		else if(rail->power)
+		{
+			r->status = rail->power->status;
+		}
+		else if(rail->curr && rail->volt)
+		{
+			r->status = rail->curr->status ? rail->curr->status : rail->volt->status;
+		}
+		else
+		{
+			r->status = ENODEV;
+		}
+	}
+
+	out->num_groups = model->num_groups < PS_MAX_RAIL_GROUPS ?
+		model->num_groups : PS_MAX_RAIL_GROUPS;
+	for(i = 0; i < out->num_groups; i++)
+	{
+		struct rail_group *group = &model->groups[i];
+		struct ps_rail_group *g = &out->groups[i];
+
+		snprintf(g->name, sizeof(g->name), "%s", group->name);
+		g->budget_watts = group->budget_watts;
+		g->total_watts = group->total_watts;
+		g->headroom_watts = group->headroom_watts;
+		g->peak_watts = group->peak_watts;
+		g->num_rails = group->num_rails;
+		g->num_valid = group->num_valid;
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API copies a throttling episode.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_copy_episode(struct ps_throttle_episode *out,
+		const struct throttle_episode *ep)
+{
+	out->start_ns = (long long)ep->start.tv_sec * 1000000000LL + ep->start.tv_nsec;
+	out->duration = ep->duration;
+	out->lost_ghz_s = ep->lost_ghz_s;
+	out->min_khz = ep->min_khz;
+	snprintf(out->cause, sizeof(out->cause), "%s", ep->cause);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API samples CPU frequency and thermal state and copies the throttling
+* episodes that ended in the window, followed by the one in progress.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_collect_throttle(struct ps_context *ctx, struct ps_snapshot *snap)
+{
+	struct throttle_episode episodes[PS_MAX_EPISODES];
+	struct throttle_detector *det = ctx->throttle;
+	struct ps_throttle *out = &snap->throttle;
+	int i;
+
+	ps_context_probe(ctx, PS_PROBE_THROTTLE);
+
+	throttle_update(det, &ctx->thermal);
+
+	out->status = det->num_policies ? 0 : ENOENT;
+	out->num_policies = det->num_policies < PS_MAX_POLICIES ?
+		det->num_policies : PS_MAX_POLICIES;
+	for(i = 0; i < out->num_policies; i++)
+	{
+		struct cpufreq_policy *policy = &det->policies[i];
+		struct ps_cpufreq_policy *p = &out->policies[i];
+
+		p->id = policy->id;
+		p->status = policy->status;
+		p->cur_khz = policy->status ? 0 : policy->cur_khz;
+		p->cap_khz = policy->status ? 0 : policy->cap_khz;
+		p->user_khz = policy->user_khz;
+		p->max_khz = policy->hw_max_khz;
+	}
+
+	out->num_episodes = throttle_drain(det, episodes, PS_MAX_EPISODES);
+	for(i = 0; i < out->num_episodes; i++)
+	{
+		ps_copy_episode(&out->episodes[i], &episodes[i]);
+	}
+
+	out->active = det->active;
+	memset(&out->current, 0, sizeof(out->current));
+	if(det->active)
+	{
+		ps_copy_episode(&out->current, &det->current);
+	}
+
+	out->total_episodes = det->total_episodes;
+	out->total_lost_ghz_s = det->total_lost_ghz_s;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API estimates the power of every CPU cluster over the window from its
+* frequency and idle residency, see cpu_power_update.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_collect_cpu_power(struct ps_context *ctx, struct ps_snapshot *snap)
+{
+	struct cpu_power_model *model = ctx->cpu_power;
+	struct ps_cpu_power *out = &snap->cpu_power;
+	int i, j;
+
+	ps_context_probe(ctx, PS_PROBE_CPU_POWER);
+
+	out->num_clusters = 0;
+	snprintf(out->source, sizeof(out->source), "%s", model->source);
+	if(!model->have_coeffs)
+	{
+		out->status = ENOENT;
+		return;
+	}
+	out->status = cpu_power_update(model) ? 0 : ENODATA;
+	if(out->status)
+	{
+		return;
+	}
+
+	out->window_s = model->window_s;
+	out->base_mw = model->base_mw;
+	out->total_watts = model->total_watts;
+	out->num_clusters = model->num_clusters < PS_MAX_CLUSTERS ?
+		model->num_clusters : PS_MAX_CLUSTERS;
+	for(i = 0; i < out->num_clusters; i++)
+	{
+		struct cpu_cluster *cl = &model->clusters[i];
+		struct ps_cpu_cluster *c = &out->clusters[i];
+
+		c->policy = cl->policy;
+		c->num_cpus = cl->num_cpus;
+		c->busy_s = cl->busy_s;
+		c->watts = cl->watts;
+		c->num_opps = cl->num_opps < PS_MAX_OPPS ? cl->num_opps : PS_MAX_OPPS;
+		for(j = 0; j < c->num_opps; j++)
+		{
+			c->opps[j].khz = cl->opps[j].khz;
+			c->opps[j].delta_s = cl->opps[j].delta_s;
+			c->opps[j].power_mw = cl->opps[j].power_mw;
+		}
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API moves the item at root of a heap of pointers down until neither
+* child sorts after it.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_sift_down(void **items, int root, int num_items,
+		int (*compare)(const void *, const void *))
+{
+	void *tmp;
+	int child;
+
+	while((child = 2 * root + 1) < num_items)
+	{
+		if(child + 1 < num_items &&
+			compare(&items[child], &items[child + 1]) < 0)
+		{
+			child++;
+		}
+		if(compare(&items[root], &items[child]) >= 0)
+		{
+			break;
+		}
+
+		tmp = items[root];
+		items[root] = items[child];
+		items[child] = tmp;
+		root = child;
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API sorts an array of pointers in place with a heapsort, compare
+* taking pointers to the items as for qsort. glibc qsort may allocate a
+* merge buffer, which collections must not do.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_sort(void **items, int num_items,
+		int (*compare)(const void *, const void *))
+{
+	void *tmp;
+	int i;
+
+	for(i = num_items / 2 - 1; i >= 0; i--)
+	{
+		ps_sift_down(items, i, num_items, compare);
+	}
+
+	for(i = num_items - 1; i > 0; i--)
+	{
+		tmp = items[0];
+		items[0] = items[i];
+		items[i] = tmp;
+		ps_sift_down(items, 0, i, compare);
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API compares two processes by attributed power, highest first, for
+* ps_sort.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int ps_proc_compare(const void *a, const void *b)
+{
+	const struct proc_power_entry *pa = *(const struct proc_power_entry **)a;
+	const struct proc_power_entry *pb = *(const struct proc_power_entry **)b;
+
+	if(pa->watts != pb->watts)
+	{
+		return(pa->watts < pb->watts ? 1 : -1);
+	}
+
+	return(pa->joules < pb->joules ? 1 : pa->joules > pb->joules ? -1 : 0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API attributes the SOM energy measured over the window to processes,
+* see proc_power_update, and copies the processes drawing the most power and
+* the totals of their cgroups. The energy is the growth of the energy
+* accumulator of the SOM power sensor since the previous collection.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_collect_proc_power(struct ps_context *ctx, struct ps_snapshot *snap)
+{
+	struct proc_power_table *tab = ctx->proc_power;
+	struct proc_power_entry **order = ctx->proc_order;
+	struct ps_proc_power *out = &snap->proc_power;
+	struct hwmon_sensor *sensor;
+	double window_joules;
+	int i, j;
+
+	ps_context_probe(ctx, PS_PROBE_PROC_POWER);
+
+	out->num_procs = 0;
+	out->num_cgroups = 0;
+
+	hwmon_sensor_set_read(&ctx->sensors, &ctx->som_set);
+	sensor = ctx->som_set.sensors[PS_SOM_POWER];
+	out->som_status = sensor == NULL ? ENODEV : sensor->status;
+	out->status = tab->valid ? 0 : ENOENT;
+	if(out->som_status || out->status)
+	{
+		return;
+	}
+
+	window_joules = sensor->energy.total_joules - ctx->proc_power_joules;
+	ctx->proc_power_joules = sensor->energy.total_joules;
+
+	if(!proc_power_update(tab, window_joules > 0 ? window_joules : 0))
+	{
+		out->status = ENODATA;
+		return;
+	}
+
+	out->measured_watts = tab->measured_watts;
+	out->window_s = tab->window_s;
+	out->base_watts = tab->base_watts;
+	out->fitting = tab->rls_samples < PROC_POWER_MIN_SAMPLES;
+	out->num_entries = tab->num_entries;
+	out->new_procs = tab->new_procs;
+	out->exited_procs = tab->exited_procs;
+
+	for(i = 0; i < tab->num_entries; i++)
+	{
+		order[i] = &tab->entries[tab->cur][i];
+	}
+	ps_sort((void **)order, tab->num_entries, ps_proc_compare);
+
+	for(i = 0; i < tab->num_entries && out->num_procs < PS_MAX_PROCS; i++)
+	{
+		struct proc_power_entry *e = order[i];
+		struct ps_process *p = &out->procs[out->num_procs++];
+
+		if(e->watts <= 0)
+		{
+			out->num_procs--;
+			break;
+		}
+		p->pid = e->pid;
+		snprintf(p->comm, sizeof(p->comm), "%s", e->comm);
+		snprintf(p->cgroup, sizeof(p->cgroup), "%s", e->cgroup);
+		p->watts = e->watts;
+		p->joules = e->joules;
+		p->cpu_s = e->cpu_s;
+	}
+
+	/* per cgroup totals, in order of their top process */
+	for(i = 0; i < tab->num_entries && out->num_cgroups < PS_MAX_CGROUPS; i++)
+	{
+		struct proc_power_entry *e = order[i];
+		struct ps_cgroup *cg = &out->cgroups[out->num_cgroups];
+
+		for(j = 0; j < i; j++)
+		{
+			if(!strcmp(order[j]->cgroup, e->cgroup))
+			{
+				break;
+			}
+		}
+		if(j < i || e->cgroup[0] == '\0')
+		{
+			continue;
+		}
+
+		cg->watts = 0;
+		cg->joules = 0;
+		for(j = i; j < tab->num_entries; j++)
+		{
+			if(!strcmp(order[j]->cgroup, e->cgroup))
+			{
+				cg->watts += order[j]->watts;
+				cg->joules += order[j]->joules;
+			}
+		}
+
+		if(cg->watts > 0)
+		{
+			snprintf(cg->name, sizeof(cg->name), "%s", e->cgroup);
+			out->num_cgroups++;
+		}
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API compares two runtime PM devices by time active in the window,
+* longest first, for ps_sort.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int ps_rpm_compare(const void *a, const void *b)
+{
+	const struct rpm_device *da = *(const struct rpm_device **)a;
+	const struct rpm_device *db = *(const struct rpm_device **)b;
+
+	if(da->active_delta != db->active_delta)
+	{
+		return(da->active_delta < db->active_delta ? 1 : -1);
+	}
+
+	return(strcmp(da->path, db->path));
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads the runtime PM counters of the devices and copies those
+* active in the window, longest first.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_collect_runtime_pm(struct ps_context *ctx, struct ps_snapshot *snap)
+{
+	struct rpm_index *idx = ctx->rpm;
+	struct rpm_device **order = ctx->rpm_order;
+	struct ps_runtime_pm *out = &snap->rpm;
+	int i;
+
+	ps_context_probe(ctx, PS_PROBE_RUNTIME_PM);
+
+	out->num_active = 0;
+	out->num_awake = 0;
+	out->num_shown = 0;
+	out->num_devices = idx->num_devices;
+	out->truncated = idx->truncated;
+
+	if(!idx->primed)
+	{
+		rpm_read(idx);
+		out->status = ENODATA;
+		return;
+	}
+
+	out->status = idx->num_devices ? 0 : ENOENT;
+	if(out->status)
+	{
+		return;
+	}
+
+	rpm_read(idx);
+
+	for(i = 0; i < idx->num_devices; i++)
+	{
+		struct rpm_device *dev = &idx->devices[i];
+
+		if(dev->status || dev->active_delta == 0)
+		{
+			continue;
+		}
+		order[out->num_active++] = dev;
+		if(dev->suspended_delta == 0)
+		{
+			out->num_awake++;
+		}
+	}
+	ps_sort((void **)order, out->num_active, ps_rpm_compare);
+
+	out->num_shown = out->num_active < PS_MAX_RPM_DEVICES ?
+		out->num_active : PS_MAX_RPM_DEVICES;
+	for(i = 0; i < out->num_shown; i++)
+	{
+		struct ps_rpm_device *d = &out->devices[i];
+
+		snprintf(d->path, sizeof(d->path), "%s", order[i]->path);
+		d->forced_on = order[i]->forced_on;
+		d->active_ms = order[i]->active_delta;
+		d->suspended_ms = order[i]->suspended_delta;
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads the wakeup sources and copies those most active in the
+* window.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_collect_wakeup(struct ps_context *ctx, struct ps_snapshot *snap)
+{
+	struct wakeup_source *top[PS_MAX_WAKEUP_SOURCES];
+	struct wakeup_index *idx = ctx->wakeup;
+	struct ps_wakeup *out = &snap->wakeup;
+	int i;
+
+	ps_context_probe(ctx, PS_PROBE_WAKEUP);
+
+	out->num_top = 0;
+	out->num_sources = idx->num_sources;
+	out->truncated = idx->truncated;
+
+	if(!idx->primed)
+	{
+		wakeup_read(idx);
+		out->status = ENODATA;
+		return;
+	}
+
+	out->status = idx->valid ? 0 : ENOENT;
+	if(out->status)
+	{
+		return;
+	}
+
+	wakeup_read(idx);
+
+	out->num_top = wakeup_top(idx, top, PS_MAX_WAKEUP_SOURCES);
+	for(i = 0; i < out->num_top; i++)
+	{
+		struct ps_wakeup_source *w = &out->top[i];
+
+		snprintf(w->name, sizeof(w->name), "%s", top[i]->name);
+		w->events = top[i]->delta[WAKEUP_EVENTS];
+		w->wakeups = top[i]->delta[WAKEUP_WAKEUPS];
+		w->active_ms = top[i]->delta[WAKEUP_ACTIVE_MS];
+		w->prevent_ms = top[i]->delta[WAKEUP_PREVENT_MS];
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API moves the alarm transitions recorded by the alarm thread of a
+* context into the snapshot and copies the alarms raised now.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_collect_alarms(struct ps_context *ctx, struct ps_snapshot *snap)
+{
+	struct alarm_event events[PS_MAX_ALARM_EVENTS];
+	struct hwmon_alarm active[PS_MAX_ALARMS];
+	struct hwmon_alarm_monitor *mon = ctx->alarms;
+	struct ps_alarms *out = &snap->alarms;
+	int i;
+
+	out->num_events = 0;
+	out->num_active = 0;
+	out->num_watched = mon->num_alarms;
+	out->status = mon->running ? 0 : ESRCH;
+	if(out->status)
+	{
+		return;
+	}
+
+	out->num_events = hwmon_alarm_monitor_drain(mon, events, PS_MAX_ALARM_EVENTS);
+	for(i = 0; i < out->num_events; i++)
+	{
+		struct ps_alarm *a = &out->events[i];
+
+		a->time_ns = (long long)events[i].realtime.tv_sec * 1000000000LL +
+			events[i].realtime.tv_nsec;
+		a->state = events[i].state;
+		snprintf(a->device, sizeof(a->device), "%s", events[i].device);
+		snprintf(a->attr, sizeof(a->attr), "%s", events[i].attr);
+		snprintf(a->label, sizeof(a->label), "%s", events[i].label);
+	}
+
+	out->num_active = hwmon_alarm_monitor_active(mon, active, PS_MAX_ALARMS);
+	for(i = 0; i < out->num_active; i++)
+	{
+		struct ps_alarm *a = &out->active[i];
+
+		a->time_ns = 0;
+		a->state = 1;
+		snprintf(a->device, sizeof(a->device), "%s", active[i].device);
+		snprintf(a->attr, sizeof(a->attr), "%s", active[i].attr);
+		snprintf(a->label, sizeof(a->label), "%s", active[i].label);
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads every hwmon sensor in a single pass and copies its value.
+* Sensors whose chip has not refreshed yet keep their cached value and are
+* marked stale.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void ps_collect_hwmon(struct ps_context *ctx, struct ps_snapshot *snap)
+{
+	struct hwmon_sensor_table *tbl = &ctx->sensors;
+	struct timespec now;
+	int i;
+
+	hwmon_sensors_read_all(tbl);
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	snap->num_sensors = tbl->num_sensors < PS_MAX_SENSORS ?
+		tbl->num_sensors : PS_MAX_SENSORS;
+	for(i = 0; i < snap->num_sensors; i++)
+	{
+		struct hwmon_sensor *sensor = &tbl->sensors[i];
+		struct ps_hwmon_sensor *out = &snap->sensors[i];
+
+		out->hwmon_id = sensor->hwmon_id;
+		snprintf(out->device, sizeof(out->device), "%s", sensor->device);
+		snprintf(out->attr, sizeof(out->attr), "%s", sensor->attr);
+		snprintf(out->label, sizeof(out->label), "%s", sensor->label);
+		snprintf(out->unit, sizeof(out->unit), "%s", hwmon_sensor_unit(sensor));
+		out->status = sensor->status;
+		out->value = sensor->status ? 0 : sensor->value;
+		out->stale = sensor->stale;
+		out->age_ms = hwmon_sensor_age_ms(sensor, &now);
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API collects the requested groups of metrics of a context into a
+* snapshot. Nothing is printed and no file is opened; every value comes with
+* a status instead. The print APIs are formatters over this API.
+*
+* A context keeps state between calls, so one context must not be collected
+* through by two threads at once. Threads sharing a context use
+* ps_context_publish and ps_snapshot_latest instead.
+*
+* @param	ctx: context to collect through
+* @param	snap: snapshot to fill
+* @param	what: PS_SNAP_* groups to collect
+*
+* @return	0.
+*
+* @note		None.
+*
+******************************************************************************/
+int ps_snapshot_collect(struct ps_context *ctx, struct ps_snapshot *snap, unsigned int what)
+{
+	snap->collected = what & PS_SNAP_ALL;
+	snap->timestamp_ns = ps_now_ns();
+	snap->num_cpus = ctx->num_cpus;
+
+	if(what & PS_SNAP_CPU_UTIL)
+	{
+		ps_collect_cpu_util(ctx, snap);
+	}
+	if(what & PS_SNAP_CPU_FREQ)
+	{
+		ps_collect_cpu_freq(ctx, snap);
+	}
+	if(what & PS_SNAP_MEMORY)
+	{
+		ps_collect_memory(ctx, snap);
+	}
+	if(what & PS_SNAP_SOM_POWER)
+	{
+		ps_collect_som_power(ctx, snap);
+	}
+	if(what & PS_SNAP_SYSMON)
+	{
+		ps_collect_sysmon(ctx, snap);
+	}
+	if(what & PS_SNAP_THERMAL)
+	{
+		ps_collect_thermal(ctx, snap);
+	}
+	if(what & PS_SNAP_DEVFREQ)
+	{
+		ps_collect_devfreq(ctx, snap);
+	}
+	if(what & PS_SNAP_ENERGY)
+	{
+		ps_collect_energy(ctx, snap);
+	}
+	if(what & PS_SNAP_SUPPLY)
+	{
+		ps_collect_supply(ctx, snap);
+	}
+	if(what & PS_SNAP_RAILS)
+	{
+		ps_collect_rails(ctx, snap);
+	}
+	if(what & PS_SNAP_THROTTLE)
+	{
+		ps_collect_throttle(ctx, snap);
+	}
+	if(what & PS_SNAP_CPU_POWER)
+	{
+		ps_collect_cpu_power(ctx, snap);
+	}
+	if(what & PS_SNAP_PROC_POWER)
+	{
+		ps_collect_proc_power(ctx, snap);
+	}
+	if(what & PS_SNAP_RUNTIME_PM)
+	{
+		ps_collect_runtime_pm(ctx, snap);
+	}
+	if(what & PS_SNAP_WAKEUP)
+	{
+		ps_collect_wakeup(ctx, snap);
+	}
+	if(what & PS_SNAP_ALARMS)
+	{
+		ps_collect_alarms(ctx, snap);
+	}
+	if(what & PS_SNAP_HWMON)
+	{
+		ps_collect_hwmon(ctx, snap);
+	}
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API collects the requested groups of metrics of a context and makes
+* the snapshot the latest one of the context. It is the writer side of a
+* seqlock: the sequence number is odd while the snapshot is copied, so
+* ps_snapshot_latest never blocks and retries if it raced with a copy. The
+* sequence number is 64 bits wide, so it does not wrap back to 0, which
+* means nothing was published, in the lifetime of a process.
+* Publishers of one context are serialized by its publish lock. The copy is
+* made with atomic word accesses, so readers overlapping it are not data
+* races.
+*
+* @param	ctx: context shared by several threads
+* @param	what: PS_SNAP_* groups to collect
+*
+* @return	0.
+*
+* @note		None.
+*
+******************************************************************************/
+int ps_context_publish(struct ps_context *ctx, unsigned int what)
+{
+	const ps_word_t *src = (const ps_word_t *)ctx->pending;
+	ps_word_t *dst = (ps_word_t *)ctx->latest;
+	unsigned long long seq;
+	size_t i;
+
+	pthread_mutex_lock(&ctx->publish_lock);
+
+	ps_snapshot_collect(ctx, ctx->pending, what);
+
+	seq = __atomic_load_n(&ctx->seq, __ATOMIC_RELAXED);
+	__atomic_store_n(&ctx->seq, seq + 1, __ATOMIC_RELAXED);
+
+	/* Release keeps every word behind the odd sequence number */
+	for(i = 0; i < PS_SNAPSHOT_WORDS; i++)
+	{
+		__atomic_store_n(&dst[i], src[i], __ATOMIC_RELEASE);
+	}
+
+	__atomic_store_n(&ctx->seq, seq + 2, __ATOMIC_RELEASE);
+
+	pthread_mutex_unlock(&ctx->publish_lock);
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API copies the latest snapshot published on a context. Any number of
+* threads may call it concurrently with each other and with publishers; it
+* takes no lock and makes no system call.
+*
+* @param	ctx: context shared by several threads
+* @param	snap: snapshot to fill
+*
+* @return	0 on success, ENODATA if nothing was published yet.
+*
+* @note		None.
+*
+******************************************************************************/
+int ps_snapshot_latest(struct ps_context *ctx, struct ps_snapshot *snap)
+{
+	const ps_word_t *src = (const ps_word_t *)ctx->latest;
+	ps_word_t *dst = (ps_word_t *)snap;
+	unsigned long long seq0, seq1;
+	size_t i;
+
+	do
+	{
+		seq0 = __atomic_load_n(&ctx->seq, __ATOMIC_ACQUIRE);
+		if(seq0 == 0)
+		{
+			return(ENODATA);
+		}
+		if(seq0 & 1)
+		{
+			continue;
+		}
+
+		/* Acquire keeps the second sequence read behind every word */
+		for(i = 0; i < PS_SNAPSHOT_WORDS; i++)
+		{
+			dst[i] = __atomic_load_n(&src[i], __ATOMIC_ACQUIRE);
+		}
+
+		seq1 = __atomic_load_n(&ctx->seq, __ATOMIC_RELAXED);
+	} while((seq0 & 1) || seq0 != seq1);
+
+	return(0);
+}
@@ -0,0 +1,133 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+#ifndef _PLATFORMSTATS_CONTEXT_H_
+#define _PLATFORMSTATS_CONTEXT_H_
+
+#include <stddef.h>
+#include <pthread.h>
+
+#include "platformstats.h"
+#include "procfs.h"
+#include "hwmon.h"
+#include "thermal.h"
+#include "devfreq.h"
+#include "ina_i2c.h"
+#include "ams_regs.h"
+#include "powercap.h"
+#include "supply.h"
+#include "rail_model.h"
+#include "throttle.h"
+#include "cpu_power.h"
+#include "proc_power.h"
+#include "runtime_pm.h"
+#include "wakeup.h"
+#include "hwmon_alarm.h"
+#include "power_sampler.h"
+
+/************************** Constant Definitions *****************************/
+#define PS_SOM_DEVICE		"ina260_u14"
+#define PS_SYSMON_DEVICE	"ams"
+
+/* Collectors of a context scanned by ps_context_probe */
+#define PS_PROBE_POWERCAP	(1 << 0)
+#define PS_PROBE_SUPPLY		(1 << 1)
+#define PS_PROBE_RAILS		(1 << 2)
+#define PS_PROBE_THROTTLE	(1 << 3)
+#define PS_PROBE_CPU_POWER	(1 << 4)
+#define PS_PROBE_PROC_POWER	(1 << 5)
+#define PS_PROBE_RUNTIME_PM	(1 << 6)
+#define PS_PROBE_WAKEUP		(1 << 7)
+
+/**************************** Type Definitions *******************************/
+/*
+ * One block of scratch memory, sized by ps_context_create for the CPUs of
+ * the system and carved into the per CPU arrays and the parse buffer.
+ */
+struct ps_arena {
+	char *base;			/* NULL while the layout is measured */
+	size_t size;
+	size_t used;
+};
+
+/*
+ * Everything ps_snapshot_collect needs between two calls: the files, found
+ * and opened by ps_context_create and only read with pread afterwards, the
+ * parse buffer, and the previous counters the CPU load is computed from.
+ * The collectors that walk a directory tree to find their devices (powercap,
+ * supplies, rails, throttling, CPU and process power, runtime PM, wakeup
+ * sources) are carved from the arena too but only scanned by the first
+ * ps_context_probe that asks for them, so contexts that never use them do
+ * not pay for the walk. Contexts share nothing, so each one sees the deltas
+ * since its own last collection and separate contexts can be used from
+ * separate threads without locking. Nothing is allocated after
+ * ps_context_create, except while a hwmon uevent makes the sensor table
+ * rescan /sys/class/hwmon and while a collector is probed.
+ */
+struct ps_context {
+	int num_cpus;
+	int stat_fd;
+	int meminfo_fd;
+	int cpuinfo_fd;
+	int freq_fd[PS_MAX_CPUS];	/* scaling_cur_freq, -1 without cpufreq */
+	long long prev_ns;		/* time of the previous CPU counters, 0 if none */
+
+	/* num_cpus entries each, from the arena */
+	struct ps_arena arena;
+	struct cpustat *prev;
+	int *prev_status;
+	struct cpustat *cur;
+	int *cur_status;
+	float *mhz;			/* from /proc/cpuinfo */
+	int *mhz_status;
+	char *buf;			/* text of the file being parsed */
+	size_t buf_len;
+
+	/* snapshot shared through ps_context_publish, see context.c */
+	pthread_mutex_t publish_lock;	/* serializes publishers */
+	unsigned long long seq;		/* odd while latest is written, 0 before */
+	struct ps_snapshot *pending;	/* collected under publish_lock */
+	struct ps_snapshot *latest;	/* from the arena */
+
+	struct hwmon_index hwmon;
+	struct hwmon_sensor_table sensors;	/* read inline, no reader pool */
+	struct hwmon_sensor_set som_set;
+	struct hwmon_sensor_set sysmon_set;
+	struct thermal_index thermal;
+	struct devfreq_index devfreq;
+
+	int ina_active;			/* SOM power read through ina */
+	struct ina_i2c ina;
+	int ams_active;			/* AMS values read through ams */
+	struct ams_regs ams;
+
+	/* from the arena, valid once probed */
+	unsigned int probed;		/* PS_PROBE_* */
+	struct powercap_index *powercap;
+	struct supply_class *supplies;
+	struct supply_class *regulators;
+	struct rail_model *rails;
+	struct throttle_detector *throttle;	/* on the thermal index above */
+	struct cpu_power_model *cpu_power;
+	struct proc_power_table *proc_power;
+	double proc_power_joules;	/* SOM energy total at the previous update */
+	struct rpm_index *rpm;
+	struct wakeup_index *wakeup;
+	struct proc_power_entry **proc_order;	/* MAX_PROC_ENTRIES, for sorting */
+	struct rpm_device **rpm_order;	/* MAX_RPM_DEVICES, for sorting */
+
+	/* from the arena, started on request only */
+	struct hwmon_alarm_monitor *alarms;
+	struct power_sampler *sampler;
+};
+
+/************************** Variable Definitions *****************************/
+extern const char *const ps_som_attrs[PS_SOM_NUM];
+extern const char *const ps_sysmon_attrs[PS_SYSMON_NUM];
+
+/************************** Function Prototypes  *****************************/
+void ps_context_probe(struct ps_context *ctx, unsigned int what);
+
+#endif /* _PLATFORMSTATS_CONTEXT_H_ */
@@ -0,0 +1,911 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include "cpu_power.h"
+#include "utils.h"
+
+/************************** Constant Definitions *****************************/
+#define TIME_IN_STATE_LEN	2048
+#define EM_MICROWATT_THRESHOLD	20000	/* larger OPP powers are in uW, not mW */
+#define ABS(x)			((x) < 0 ? -(x) : (x))
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API parses a CPU list as found in sysfs, either "0 1 2 3" or
+* "0-3,6".
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int parse_cpu_list(const char *str, int *cpus, int max_cpus)
+{
+	const char *p = str;
+	int n = 0;
+
+	while(*p && n < max_cpus)
+	{
+		char *end;
+		long first, last;
+
+		first = strtol(p, &end, 10);
+		if(end == p)
+		{
+			p++;
+			continue;
+		}
+
+		last = first;
+		if(*end == '-')
+		{
+			p = end + 1;
+			last = strtol(p, &end, 10);
+		}
+
+		for(; first <= last && n < max_cpus; first++)
+		{
+			cpus[n++] = first;
+		}
+		p = end;
+	}
+
+	return(n);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API compares two CPU clusters by policy for qsort.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int cpu_cluster_compare(const void *a, const void *b)
+{
+	const struct cpu_cluster *ca = a, *cb = b;
+
+	return(ca->policy - cb->policy);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API returns the highest OPP frequency of a cluster.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static long cpu_cluster_max_khz(const struct cpu_cluster *cl)
+{
+	long max_khz = 0;
+	int i;
+
+	for(i = 0; i < cl->num_opps; i++)
+	{
+		if(cl->opps[i].khz > max_khz)
+		{
+			max_khz = cl->opps[i].khz;
+		}
+	}
+
+	return(max_khz);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads stats/time_in_state of a cluster. On the first read it
+* records the OPPs; afterwards it computes the residency of each OPP since
+* the previous read. The OPP table is re-recorded if it changed.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void cpu_cluster_read_tis(struct cpu_cluster *cl, int primed)
+{
+	char buf[TIME_IN_STATE_LEN + 1];
+	char *line, *save;
+	ssize_t len;
+	int n;
+
+	if(cl->tis_fd < 0)
+	{
+		return;
+	}
+
+	len = pread(cl->tis_fd, buf, TIME_IN_STATE_LEN, 0);
+	if(len <= 0)
+	{
+		return;
+	}
+	buf[len] = '\0';
+
+	n = 0;
+	for(line = strtok_r(buf, "\n", &save); line != NULL && n < MAX_CPU_OPPS;
+		line = strtok_r(NULL, "\n", &save))
+	{
+		struct cpu_opp *opp = &cl->opps[n];
+		unsigned long long time;
+		long khz;
+
+		if(sscanf(line, "%ld %llu", &khz, &time) != 2)
+		{
+			continue;
+		}
+
+		if(!primed || n >= cl->num_opps || opp->khz != khz || time < opp->time)
+		{
+			if(n >= cl->num_opps || opp->khz != khz)
+			{
+				opp->power_mw = -1;
+			}
+			opp->delta_s = 0;
+		}
+		else
+		{
+			opp->delta_s = (time - opp->time) * 0.01;
+		}
+		opp->khz = khz;
+		opp->time = time;
+		n++;
+	}
+
+	cl->num_opps = n;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API returns the total idle time of the CPUs of a cluster: the
+* residency of all their cpuidle states, or, on kernels without cpuidle,
+* the idle and iowait time of /proc/stat as read by cpu_power_update.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static unsigned long long cpu_cluster_idle_us(struct cpu_power_model *model,
+		struct cpu_cluster *cl)
+{
+	unsigned long long total = 0;
+	char buf[32];
+	int i;
+
+	if(cl->num_idle == 0)
+	{
+		for(i = 0; i < cl->num_cpus && model->clk_tck > 0; i++)
+		{
+			int cpu = cl->cpus[i];
+
+			if(cpu < PS_MAX_CPUS && !model->stat_status[cpu])
+			{
+				total += (unsigned long long)(model->stat[cpu].idle +
+					model->stat[cpu].iowait) * 1000000 / model->clk_tck;
+			}
+		}
+
+		return(total);
+	}
+
+	for(i = 0; i < cl->num_idle; i++)
+	{
+		unsigned long long us;
+		ssize_t len;
+
+		len = pread(cl->idle_fd[i], buf, sizeof(buf) - 1, 0);
+		if(len > 0 && !parse_ulonglong(buf, len, &us))
+		{
+			total += us;
+		}
+	}
+
+	return(total);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API discovers the cpufreq policies and, for each one, opens its
+* time_in_state statistics and the cpuidle residency of each of its CPUs.
+* /proc/stat is opened as well when a cluster has no cpuidle states.
+* The model starts without coefficients.
+*
+* @param	model: CPU power model to initialize
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int cpu_power_init(struct cpu_power_model *model)
+{
+	DIR *d;
+	struct dirent *dir;
+	int cpu_fd, cpufreq_fd, i;
+
+	cpu_power_release(model);
+	memset(model, 0, sizeof(*model));
+	model->stat_fd = -1;
+
+	cpu_fd = open(CPU_SYSFS_PATH, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(cpu_fd < 0)
+	{
+		return(errno);
+	}
+
+	cpufreq_fd = openat(cpu_fd, "cpufreq", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(cpufreq_fd < 0 || (d = fdopendir(cpufreq_fd)) == NULL)
+	{
+		int ret = errno;
+
+		if(cpufreq_fd >= 0)
+		{
+			close(cpufreq_fd);
+		}
+		close(cpu_fd);
+		return(ret);
+	}
+
+	while((dir = readdir(d)) != NULL && model->num_clusters < MAX_CPU_CLUSTERS)
+	{
+		struct cpu_cluster *cl = &model->clusters[model->num_clusters];
+		char path[64], buf[128];
+		int id, policy_fd, i, j;
+
+		if(sscanf(dir->d_name, "policy%d", &id) != 1)
+		{
+			continue;
+		}
+
+		policy_fd = openat(cpufreq_fd, dir->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if(policy_fd < 0)
+		{
+			continue;
+		}
+
+		memset(cl, 0, sizeof(*cl));
+		cl->policy = id;
+
+		if(read_sysfs_string(policy_fd, "related_cpus", buf, sizeof(buf)) == 0)
+		{
+			cl->num_cpus = parse_cpu_list(buf, cl->cpus, MAX_CLUSTER_CPUS);
+		}
+
+		cl->tis_fd = openat(policy_fd, "stats/time_in_state", O_RDONLY | O_CLOEXEC);
+		close(policy_fd);
+
+		if(cl->num_cpus == 0)
+		{
+			if(cl->tis_fd >= 0)
+			{
+				close(cl->tis_fd);
+			}
+			continue;
+		}
+
+		cpu_cluster_read_tis(cl, 0);
+
+		for(i = 0; i < cl->num_cpus; i++)
+		{
+			for(j = 0; j < MAX_IDLE_STATES; j++)
+			{
+				int fd;
+
+				snprintf(path, sizeof(path), "cpu%d/cpuidle/state%d/time",
+					cl->cpus[i], j);
+				fd = openat(cpu_fd, path, O_RDONLY | O_CLOEXEC);
+				if(fd < 0)
+				{
+					break;
+				}
+				cl->idle_fd[cl->num_idle++] = fd;
+			}
+		}
+
+		model->num_clusters++;
+	}
+
+	closedir(d);
+	close(cpu_fd);
+
+	qsort(model->clusters, model->num_clusters, sizeof(model->clusters[0]),
+		cpu_cluster_compare);
+
+	for(i = 0; i < model->num_clusters; i++)
+	{
+		if(model->clusters[i].num_idle == 0)
+		{
+			model->stat_fd = open(PROC_STAT_PATH, O_RDONLY | O_CLOEXEC);
+			model->clk_tck = sysconf(_SC_CLK_TCK);
+			break;
+		}
+	}
+
+	model->valid = 1;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API closes all fds held by the CPU power model.
+*
+* @param	model: CPU power model
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void cpu_power_release(struct cpu_power_model *model)
+{
+	int i, j;
+
+	for(i = 0; i < model->num_clusters; i++)
+	{
+		struct cpu_cluster *cl = &model->clusters[i];
+
+		if(cl->tis_fd >= 0)
+		{
+			close(cl->tis_fd);
+		}
+		for(j = 0; j < cl->num_idle; j++)
+		{
+			close(cl->idle_fd[j]);
+		}
+	}
+
+	if(model->valid && model->stat_fd >= 0)
+	{
+		close(model->stat_fd);
+		model->stat_fd = -1;
+	}
+
+	model->num_clusters = 0;
+	model->valid = 0;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API returns the cluster that contains a CPU.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static struct cpu_cluster *cpu_power_find_cpu(struct cpu_power_model *model, int cpu)
+{
+	int i, j;
+
+	for(i = 0; i < model->num_clusters; i++)
+	{
+		for(j = 0; j < model->clusters[i].num_cpus; j++)
+		{
+			if(model->clusters[i].cpus[j] == cpu)
+			{
+				return(&model->clusters[i]);
+			}
+		}
+	}
+
+	return(NULL);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API sets the power of the OPP of a cluster running at khz.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int cpu_cluster_set_power(struct cpu_cluster *cl, long khz, double power_mw)
+{
+	int i;
+
+	for(i = 0; i < cl->num_opps; i++)
+	{
+		if(cl->opps[i].khz == khz)
+		{
+			cl->opps[i].power_mw = power_mw;
+			return(1);
+		}
+	}
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API takes the per OPP power of every cluster from the kernel energy
+* model in debugfs, laid out as <pd>/cpus and <pd>/ps:<freq>/{frequency,power}.
+* Older kernels report power in mW and newer ones in uW; the unit is guessed
+* from the magnitude of the values.
+*
+* @param	model: initialized CPU power model
+* @param	path: energy model directory, normally ENERGY_MODEL_PATH
+*
+* @return	0 if coefficients were found, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int cpu_power_load_energy_model(struct cpu_power_model *model, const char *path)
+{
+	DIR *d, *pd;
+	struct dirent *dir, *ps;
+	int found = 0;
+
+	d = opendir(path);
+	if(!d)
+	{
+		return(errno);
+	}
+
+	while((dir = readdir(d)) != NULL)
+	{
+		struct cpu_cluster *cl;
+		char buf[128];
+		long khz[MAX_CPU_OPPS], power[MAX_CPU_OPPS], max_power;
+		int cpus[MAX_CLUSTER_CPUS], pd_fd, num_ps, i;
+
+		if(dir->d_name[0] == '.')
+		{
+			continue;
+		}
+
+		pd_fd = openat(dirfd(d), dir->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if(pd_fd < 0)
+		{
+			continue;
+		}
+
+		if(read_sysfs_string(pd_fd, "cpus", buf, sizeof(buf)) ||
+			parse_cpu_list(buf, cpus, MAX_CLUSTER_CPUS) == 0 ||
+			(cl = cpu_power_find_cpu(model, cpus[0])) == NULL ||
+			(pd = fdopendir(pd_fd)) == NULL)
+		{
+			close(pd_fd);
+			continue;
+		}
+
+		num_ps = 0;
+		max_power = 0;
+
+		while((ps = readdir(pd)) != NULL && num_ps < MAX_CPU_OPPS)
+		{
+			char attr[300];
+
+			if(strncmp(ps->d_name, "ps:", 3))
+			{
+				continue;
+			}
+
+			snprintf(attr, sizeof(attr), "%s/frequency", ps->d_name);
+			if(read_sysfs_string(dirfd(pd), attr, buf, sizeof(buf)) ||
+				parse_long(buf, strlen(buf), &khz[num_ps]))
+			{
+				continue;
+			}
+
+			snprintf(attr, sizeof(attr), "%s/power", ps->d_name);
+			if(read_sysfs_string(dirfd(pd), attr, buf, sizeof(buf)) ||
+				parse_long(buf, strlen(buf), &power[num_ps]))
+			{
+				continue;
+			}
+
+			if(power[num_ps] > max_power)
+			{
+				max_power = power[num_ps];
+			}
+			num_ps++;
+		}
+
+		closedir(pd);
+
+		for(i = 0; i < num_ps; i++)
+		{
+			double mw = max_power > EM_MICROWATT_THRESHOLD ?
+				power[i] / 1000.0 : power[i];
+
+			found += cpu_cluster_set_power(cl, khz[i], mw);
+		}
+	}
+
+	closedir(d);
+
+	if(!found)
+	{
+		return(ENOENT);
+	}
+
+	model->have_coeffs = 1;
+	snprintf(model->source, sizeof(model->source), "%s", path);
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API loads per OPP power coefficients from a calibration file, as
+* written by cpu_power_save. Each line is one of
+*
+*	base <mW>
+*	opp <policy> <kHz> <mW per busy CPU>
+*
+* and text after '#' is ignored.
+*
+* @param	model: initialized CPU power model
+* @param	path: calibration file
+*
+* @return	0 if coefficients were found, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int cpu_power_load(struct cpu_power_model *model, const char *path)
+{
+	FILE *fp;
+	char line[128];
+	int found = 0;
+
+	fp = fopen(path, "r");
+	if(fp == NULL)
+	{
+		return(errno);
+	}
+
+	while(fgets(line, sizeof(line), fp) != NULL)
+	{
+		double mw;
+		long khz;
+		int policy, i;
+
+		line[strcspn(line, "#")] = '\0';
+
+		if(sscanf(line, " base %lf", &mw) == 1)
+		{
+			model->base_mw = mw;
+			continue;
+		}
+
+		if(sscanf(line, " opp %d %ld %lf", &policy, &khz, &mw) != 3)
+		{
+			continue;
+		}
+
+		for(i = 0; i < model->num_clusters; i++)
+		{
+			if(model->clusters[i].policy == policy)
+			{
+				found += cpu_cluster_set_power(&model->clusters[i], khz, mw);
+			}
+		}
+	}
+
+	fclose(fp);
+
+	if(!found)
+	{
+		return(ENOENT);
+	}
+
+	model->have_coeffs = 1;
+	snprintf(model->source, sizeof(model->source), "%s", path);
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API writes the coefficients of the model to a calibration file that
+* cpu_power_load can read back.
+*
+* @param	model: CPU power model with coefficients
+* @param	path: calibration file
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int cpu_power_save(struct cpu_power_model *model, const char *path)
+{
+	FILE *fp;
+	int i, j;
+
+	fp = fopen(path, "w");
+	if(fp == NULL)
+	{
+		return(errno);
+	}
+
+	fprintf(fp, "# platformstats CPU power model, %d samples\n", model->num_samples);
+	fprintf(fp, "# opp <policy> <kHz> <mW per busy CPU>\n");
+	fprintf(fp, "base %.1f\n", model->base_mw);
+
+	for(i = 0; i < model->num_clusters; i++)
+	{
+		struct cpu_cluster *cl = &model->clusters[i];
+
+		for(j = 0; j < cl->num_opps; j++)
+		{
+			if(cl->opps[j].power_mw >= 0)
+			{
+				fprintf(fp, "opp %d %ld %.1f\n", cl->policy, cl->opps[j].khz,
+					cl->opps[j].power_mw);
+			}
+		}
+	}
+
+	if(fclose(fp))
+	{
+		return(errno);
+	}
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API samples the frequency and idle residency of every cluster and
+* estimates the power of each one over the window since the previous call:
+* the busy CPU-seconds of a cluster are spread over its OPPs by their
+* residency and weighted by the power of one busy CPU at each OPP. The
+* first call only sets the starting point.
+*
+* @param	model: initialized CPU power model
+*
+* @return	1 if a window was measured, 0 on the first call.
+*
+* @note		None.
+*
+******************************************************************************/
+int cpu_power_update(struct cpu_power_model *model)
+{
+	struct timespec now;
+	int i, j, primed;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	primed = model->primed;
+	model->window_s = primed ? (now.tv_sec - model->last.tv_sec) +
+		(now.tv_nsec - model->last.tv_nsec) / 1e9 : 0;
+	model->last = now;
+	model->primed = 1;
+	model->total_watts = model->base_mw / 1000;
+
+	if(model->stat_fd >= 0)
+	{
+		size_t len;
+
+		if(procfs_read(model->stat_fd, model->stat_buf, sizeof(model->stat_buf), &len))
+		{
+			model->stat_buf[0] = '\0';
+		}
+		procfs_parse_stat(model->stat_buf, model->stat, model->stat_status,
+			PS_MAX_CPUS);
+	}
+
+	for(i = 0; i < model->num_clusters; i++)
+	{
+		struct cpu_cluster *cl = &model->clusters[i];
+		unsigned long long idle_us;
+		double residency, idle_s, max_khz;
+
+		cpu_cluster_read_tis(cl, primed);
+		idle_us = cpu_cluster_idle_us(model, cl);
+		idle_s = primed && idle_us >= cl->idle_us ? (idle_us - cl->idle_us) / 1e6 : 0;
+		cl->idle_us = idle_us;
+
+		cl->busy_s = cl->num_cpus * model->window_s - idle_s;
+		if(cl->busy_s < 0 || !primed)
+		{
+			cl->busy_s = 0;
+		}
+
+		residency = 0;
+		for(j = 0; j < cl->num_opps; j++)
+		{
+			residency += cl->opps[j].delta_s;
+		}
+
+		cl->load = 0;
+		cl->watts = 0;
+		max_khz = cpu_cluster_max_khz(cl);
+
+		if(residency <= 0 || model->window_s <= 0)
+		{
+			continue;
+		}
+
+		for(j = 0; j < cl->num_opps; j++)
+		{
+			struct cpu_opp *opp = &cl->opps[j];
+			double busy = cl->busy_s * opp->delta_s / residency;
+			double f = opp->khz / max_khz;
+
+			cl->load += busy * f * f * f / model->window_s;
+			if(opp->power_mw > 0)
+			{
+				cl->watts += busy * opp->power_mw / 1000 / model->window_s;
+			}
+		}
+
+		model->total_watts += cl->watts;
+	}
+
+	return(primed);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API adds one calibration sample: the measured power over the window
+* of the last cpu_power_update call. Samples are folded into least squares
+* normal equations, so calibration uses constant memory.
+*
+* @param	model: CPU power model, updated for the window
+* @param	measured_watts: power measured over the same window
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void cpu_power_calib_add(struct cpu_power_model *model, double measured_watts)
+{
+	double x[MAX_CPU_CLUSTERS + 1];
+	int i, j, n;
+
+	if(model->window_s <= 0)
+	{
+		return;
+	}
+
+	n = model->num_clusters + 1;
+	x[0] = 1;
+	for(i = 0; i < model->num_clusters; i++)
+	{
+		x[i + 1] = model->clusters[i].load;
+	}
+
+	for(i = 0; i < n; i++)
+	{
+		for(j = 0; j < n; j++)
+		{
+			model->xtx[i][j] += x[i] * x[j];
+		}
+		model->xty[i] += x[i] * measured_watts;
+	}
+
+	model->num_samples++;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API fits the model to the calibration samples. The fitted model is
+*
+*	P = base + sum over clusters of k * busy CPUs * (f / fmax)^3
+*
+* i.e. dynamic power growing with the cube of the frequency as voltage
+* scales with it. The per OPP coefficients of each cluster are then set to
+* k * (f / fmax)^3. Negative fits are clamped to 0.
+*
+* @param	model: CPU power model with calibration samples
+*
+* @return	0 on success, EAGAIN without enough samples, EDOM if the load did
+*		not vary enough to tell the clusters apart.
+*
+* @note		None.
+*
+******************************************************************************/
+int cpu_power_calib_solve(struct cpu_power_model *model)
+{
+	double a[MAX_CPU_CLUSTERS + 1][MAX_CPU_CLUSTERS + 2];
+	double beta[MAX_CPU_CLUSTERS + 1];
+	int i, j, k, n;
+
+	n = model->num_clusters + 1;
+	if(model->num_samples < n + 1)
+	{
+		return(EAGAIN);
+	}
+
+	memset(beta, 0, sizeof(beta));
+	for(i = 0; i < n; i++)
+	{
+		for(j = 0; j < n; j++)
+		{
+			a[i][j] = model->xtx[i][j];
+		}
+		a[i][n] = model->xty[i];
+	}
+
+	/* Gaussian elimination with partial pivoting */
+	for(k = 0; k < n; k++)
+	{
+		int pivot = k;
+
+		for(i = k + 1; i < n; i++)
+		{
+			if(ABS(a[i][k]) > ABS(a[pivot][k]))
+			{
+				pivot = i;
+			}
+		}
+
+		if(ABS(a[pivot][k]) < 1e-9)
+		{
+			return(EDOM);
+		}
+
+		for(j = 0; j <= n; j++)
+		{
+			double t = a[k][j];
+
+			a[k][j] = a[pivot][j];
+			a[pivot][j] = t;
+		}
+
+		for(i = k + 1; i < n; i++)
+		{
+			double f = a[i][k] / a[k][k];
+
+			for(j = k; j <= n; j++)
+			{
+				a[i][j] -= f * a[k][j];
+			}
+		}
+	}
+
+	for(i = n - 1; i >= 0; i--)
+	{
+		beta[i] = a[i][n];
+		for(j = i + 1; j < n; j++)
+		{
+			beta[i] -= a[i][j] * beta[j];
+		}
+		beta[i] /= a[i][i];
+	}
+
+	model->base_mw = beta[0] > 0 ? beta[0] * 1000 : 0;
+
+	for(i = 0; i < model->num_clusters; i++)
+	{
+		struct cpu_cluster *cl = &model->clusters[i];
+		double max_khz = cpu_cluster_max_khz(cl);
+		double k_mw = beta[i + 1] > 0 ? beta[i + 1] * 1000 : 0;
+
+		for(j = 0; j < cl->num_opps; j++)
+		{
+			double f = cl->opps[j].khz / max_khz;
+
+			cl->opps[j].power_mw = k_mw * f * f * f;
+		}
+	}
+
+	model->have_coeffs = 1;
+	snprintf(model->source, sizeof(model->source), "calibration");
+
+	return(0);
+}
@@ -0,0 +1,90 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+#ifndef _PLATFORMSTATS_CPU_POWER_H_
+#define _PLATFORMSTATS_CPU_POWER_H_
+
+#include <time.h>
+
+#include "platformstats.h"
+#include "procfs.h"
+
+/************************** Constant Definitions *****************************/
+#define CPU_SYSFS_PATH		"/sys/devices/system/cpu"
+#define ENERGY_MODEL_PATH	"/sys/kernel/debug/energy_model"
+#define CPU_POWER_MODEL_PATH	"/etc/platformstats/cpu_power.conf"
+#define MAX_CPU_CLUSTERS	8
+#define MAX_CLUSTER_CPUS	16
+#define MAX_CPU_OPPS		32
+#define MAX_IDLE_STATES		8
+#define CPU_POWER_SOURCE_LEN	128
+#define CPU_POWER_CALIB_READS	10	/* power reads per calibration second */
+
+/**************************** Type Definitions *******************************/
+struct cpu_opp {
+	long khz;
+	unsigned long long time;	/* time_in_state, in 10 ms units */
+	double delta_s;			/* residency since the previous update */
+	double power_mw;		/* power of one busy CPU at this OPP, < 0 if unknown */
+};
+
+/*
+ * One cpufreq policy, i.e. a cluster of CPUs sharing a clock. Its busy time
+ * is the window minus the cpuidle residency of each CPU, or their idle time
+ * in /proc/stat without cpuidle, spread over the OPPs according to the
+ * time_in_state residency of the window.
+ */
+struct cpu_cluster {
+	int policy;			/* N of policyN */
+	int num_cpus;
+	int cpus[MAX_CLUSTER_CPUS];
+	int tis_fd;			/* open fd of stats/time_in_state, -1 if absent */
+	int num_opps;
+	struct cpu_opp opps[MAX_CPU_OPPS];
+	int num_idle;			/* 0 without cpuidle, /proc/stat is used */
+	int idle_fd[MAX_CLUSTER_CPUS * MAX_IDLE_STATES];	/* cpuidle stateK/time */
+	unsigned long long idle_us;	/* sum of all idle state times */
+	double busy_s;			/* busy CPU-seconds in the window */
+	double load;			/* cubic frequency weighted busy share, for calibration */
+	double watts;			/* estimate, valid if the model has coefficients */
+};
+
+struct cpu_power_model {
+	int valid;
+	int primed;
+	struct timespec last;		/* CLOCK_MONOTONIC time of previous update */
+	double window_s;
+	int num_clusters;
+	struct cpu_cluster clusters[MAX_CPU_CLUSTERS];
+
+	/* per CPU idle and iowait time for clusters without cpuidle */
+	int stat_fd;			/* /proc/stat, -1 if every cluster has cpuidle */
+	long clk_tck;
+	char stat_buf[PROC_STAT_BUF_LEN(PS_MAX_CPUS)];
+	struct cpustat stat[PS_MAX_CPUS];
+	int stat_status[PS_MAX_CPUS];
+
+	int have_coeffs;
+	double base_mw;			/* power not attributed to any cluster */
+	char source[CPU_POWER_SOURCE_LEN];	/* where the coefficients come from */
+	double total_watts;
+
+	/* least squares normal equations accumulated in calibration mode */
+	int num_samples;
+	double xtx[MAX_CPU_CLUSTERS + 1][MAX_CPU_CLUSTERS + 1];
+	double xty[MAX_CPU_CLUSTERS + 1];
+};
+
+/************************** Function Prototypes  *****************************/
+int cpu_power_init(struct cpu_power_model *model);
+void cpu_power_release(struct cpu_power_model *model);
+int cpu_power_load_energy_model(struct cpu_power_model *model, const char *path);
+int cpu_power_load(struct cpu_power_model *model, const char *path);
+int cpu_power_save(struct cpu_power_model *model, const char *path);
+int cpu_power_update(struct cpu_power_model *model);
+void cpu_power_calib_add(struct cpu_power_model *model, double measured_watts);
+int cpu_power_calib_solve(struct cpu_power_model *model);
+
+#endif /* _PLATFORMSTATS_CPU_POWER_H_ */
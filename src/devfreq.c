@@ -0,0 +1,258 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include "devfreq.h"
+#include "hwmon.h"
+#include "utils.h"
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API parses a devfreq trans_stat table into the residency of each
+* frequency and computes the residency and transitions since the previous
+* reading. A row looks like
+*
+*	*  400000000:         0        12         3      81234
+*
+* where the leading '*' marks the current frequency, the middle columns are
+* transition counts and the last column is the time spent at the frequency
+* in ms.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void devfreq_parse_trans_stat(struct devfreq_device *dev, char *buf)
+{
+	char *line, *save;
+	int n;
+
+	n = 0;
+	dev->window_ms = 0;
+
+	for(line = strtok_r(buf, "\n", &save); line != NULL;
+		line = strtok_r(NULL, "\n", &save))
+	{
+		struct devfreq_state *state;
+		unsigned long long time_ms;
+		unsigned long freq;
+		char *p, *end;
+
+		p = line + strspn(line, " *");
+
+		if(!strncmp(p, "Total transition", 16))
+		{
+			unsigned long total;
+
+			p = strchr(p, ':');
+			if(p == NULL)
+			{
+				continue;
+			}
+			total = strtoul(p + 1, NULL, 10);
+			dev->delta_transitions = dev->primed ? total - dev->transitions : 0;
+			dev->transitions = total;
+			continue;
+		}
+
+		freq = strtoul(p, &end, 10);
+		if(end == p || *end != ':' || n == MAX_DEVFREQ_STATES)
+		{
+			continue;
+		}
+
+		/* the last column of the row is the residency */
+		time_ms = 0;
+		for(p = end + 1; ; p = end)
+		{
+			unsigned long long v = strtoull(p, &end, 10);
+
+			if(end == p)
+			{
+				break;
+			}
+			time_ms = v;
+		}
+
+		state = &dev->states[n];
+		if(!dev->primed || n >= dev->num_states || state->freq != freq ||
+			time_ms < state->time_ms)
+		{
+			state->delta_ms = 0;
+		}
+		else
+		{
+			state->delta_ms = time_ms - state->time_ms;
+		}
+		state->freq = freq;
+		state->time_ms = time_ms;
+		dev->window_ms += state->delta_ms;
+		n++;
+	}
+
+	dev->num_states = n;
+	dev->primed = 1;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API scans /sys/class/devfreq once and opens cur_freq and, when the
+* kernel provides it, trans_stat of every device.
+*
+* @param	df: devfreq index to populate
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int devfreq_init(struct devfreq_index *df)
+{
+	DIR *d;
+	struct dirent *dir;
+	int class_fd;
+
+	devfreq_release(df);
+
+	d = opendir(DEVFREQ_CLASS_PATH);
+	if(!d)
+	{
+		return(errno);
+	}
+
+	class_fd = dirfd(d);
+
+	while((dir = readdir(d)) != NULL && df->num_devices < MAX_DEVFREQ_DEVICES)
+	{
+		struct devfreq_device *dev = &df->devices[df->num_devices];
+		int dev_fd;
+
+		if(dir->d_name[0] == '.')
+		{
+			continue;
+		}
+
+		dev_fd = openat(class_fd, dir->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if(dev_fd < 0)
+		{
+			continue;
+		}
+
+		memset(dev, 0, sizeof(*dev));
+		dev->cur_fd = openat(dev_fd, "cur_freq", O_RDONLY | O_CLOEXEC);
+		if(dev->cur_fd < 0)
+		{
+			close(dev_fd);
+			continue;
+		}
+		dev->trans_fd = openat(dev_fd, "trans_stat", O_RDONLY | O_CLOEXEC);
+
+		snprintf(dev->name, sizeof(dev->name), "%.63s", dir->d_name);
+		if(read_sysfs_string(dev_fd, "governor", dev->governor,
+			sizeof(dev->governor)))
+		{
+			dev->governor[0] = '\0';
+		}
+
+		close(dev_fd);
+		df->num_devices++;
+	}
+
+	closedir(d);
+
+	df->valid = 1;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API closes all fds held by the devfreq index.
+*
+* @param	df: devfreq index
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void devfreq_release(struct devfreq_index *df)
+{
+	int i;
+
+	for(i = 0; i < df->num_devices; i++)
+	{
+		close(df->devices[i].cur_fd);
+		if(df->devices[i].trans_fd >= 0)
+		{
+			close(df->devices[i].trans_fd);
+		}
+	}
+
+	df->num_devices = 0;
+	df->valid = 0;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads the current frequency of every devfreq device and, where
+* available, the frequency residency accumulated since the previous call.
+*
+* @param	df: devfreq index
+*
+* @return	number of devices whose frequency was read successfully.
+*
+* @note		None.
+*
+******************************************************************************/
+int devfreq_read(struct devfreq_index *df)
+{
+	char buf[DEVFREQ_TRANS_STAT_LEN + 1];
+	int i, num_read;
+
+	num_read = 0;
+
+	for(i = 0; i < df->num_devices; i++)
+	{
+		struct devfreq_device *dev = &df->devices[i];
+		ssize_t len;
+
+		dev->status = hwmon_sensor_fetch(dev->cur_fd, &dev->cur_freq);
+		if(dev->status == 0)
+		{
+			num_read++;
+		}
+
+		if(dev->trans_fd < 0)
+		{
+			continue;
+		}
+
+		len = pread(dev->trans_fd, buf, DEVFREQ_TRANS_STAT_LEN, 0);
+		if(len <= 0)
+		{
+			dev->num_states = 0;
+			continue;
+		}
+		buf[len] = '\0';
+
+		devfreq_parse_trans_stat(dev, buf);
+	}
+
+	return(num_read);
+}
@@ -0,0 +1,54 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+#ifndef _PLATFORMSTATS_DEVFREQ_H_
+#define _PLATFORMSTATS_DEVFREQ_H_
+
+/************************** Constant Definitions *****************************/
+#define DEVFREQ_CLASS_PATH	"/sys/class/devfreq"
+#define MAX_DEVFREQ_DEVICES	16
+#define MAX_DEVFREQ_STATES	32
+#define DEVFREQ_NAME_LEN	64
+#define DEVFREQ_TRANS_STAT_LEN	4096	/* trans_stat is limited to a page */
+
+/**************************** Type Definitions *******************************/
+struct devfreq_state {
+	unsigned long freq;		/* Hz */
+	unsigned long long time_ms;	/* total residency at this frequency */
+	unsigned long long delta_ms;	/* residency since the previous read */
+};
+
+/*
+ * One devfreq device (DDR controller, GPU, interconnect, ...). Residency is
+ * taken from trans_stat, which is only present when the kernel was built
+ * with devfreq statistics.
+ */
+struct devfreq_device {
+	char name[DEVFREQ_NAME_LEN];	/* directory name under devfreq */
+	char governor[DEVFREQ_NAME_LEN];
+	int cur_fd;			/* open fd of <dev>/cur_freq */
+	int trans_fd;			/* open fd of <dev>/trans_stat, -1 if absent */
+	long cur_freq;			/* Hz */
+	int status;			/* 0 if cur_freq is valid, errno otherwise */
+	int primed;			/* states hold a previous trans_stat reading */
+	int num_states;
+	unsigned long long window_ms;	/* sum of delta_ms over all states */
+	unsigned long transitions;	/* total transitions since boot */
+	unsigned long delta_transitions;	/* transitions since the previous read */
+	struct devfreq_state states[MAX_DEVFREQ_STATES];
+};
+
+struct devfreq_index {
+	int valid;
+	int num_devices;
+	struct devfreq_device devices[MAX_DEVFREQ_DEVICES];
+};
+
+/************************** Function Prototypes  *****************************/
+int devfreq_init(struct devfreq_index *df);
+void devfreq_release(struct devfreq_index *df);
+int devfreq_read(struct devfreq_index *df);
+
+#endif /* _PLATFORMSTATS_DEVFREQ_H_ */
@@ -0,0 +1,161 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <string.h>
+#include <time.h>
+
+#include "energy.h"
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API returns the time between two monotonic timestamps in seconds.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static double energy_elapsed(const struct timespec *t0, const struct timespec *t1)
+{
+	return((t1->tv_sec - t0->tv_sec) + (t1->tv_nsec - t0->tv_nsec) / 1e9);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API clears an energy accumulator.
+*
+* @param	acc: energy accumulator
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void energy_accum_reset(struct energy_accum *acc)
+{
+	memset(acc, 0, sizeof(*acc));
+}
+
+/*****************************************************************************/
+/*
+*
+* This API integrates a power sample into the accumulator using the
+* trapezoidal rule between the previous sample and this one. The actual
+* time between the two samples is used, not the nominal polling interval,
+* so late or skipped ticks do not bias the energy.
+*
+* @param	acc: energy accumulator
+* @param	watts: instantaneous power
+* @param	t: CLOCK_MONOTONIC time the sample was taken
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void energy_accum_add_power(struct energy_accum *acc, double watts,
+		const struct timespec *t)
+{
+	double dt;
+
+	if(acc->num_samples > 0)
+	{
+		dt = energy_elapsed(&acc->last_time, t);
+		if(dt <= 0)
+		{
+			return;
+		}
+
+		acc->window_joules += (acc->last_watts + watts) / 2 * dt;
+		acc->window_seconds += dt;
+		acc->total_joules += (acc->last_watts + watts) / 2 * dt;
+		acc->total_seconds += dt;
+	}
+
+	if(watts > acc->window_peak_watts)
+	{
+		acc->window_peak_watts = watts;
+	}
+
+	acc->last_watts = watts;
+	acc->last_time = *t;
+	acc->num_samples++;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API adds the energy measured by a hardware counter since its previous
+* reading. The power over the interval is used for the peak figure.
+*
+* @param	acc: energy accumulator
+* @param	joules: energy since the previous reading
+* @param	t: CLOCK_MONOTONIC time of the reading
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void energy_accum_add_energy(struct energy_accum *acc, double joules,
+		const struct timespec *t)
+{
+	double dt;
+
+	if(acc->num_samples > 0)
+	{
+		dt = energy_elapsed(&acc->last_time, t);
+		if(dt <= 0)
+		{
+			return;
+		}
+
+		acc->window_joules += joules;
+		acc->window_seconds += dt;
+		acc->total_joules += joules;
+		acc->total_seconds += dt;
+		acc->last_watts = joules / dt;
+
+		if(acc->last_watts > acc->window_peak_watts)
+		{
+			acc->window_peak_watts = acc->last_watts;
+		}
+	}
+
+	acc->last_time = *t;
+	acc->num_samples++;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reports the energy of the current window and of the whole run,
+* then starts a new window.
+*
+* @param	acc: energy accumulator
+* @param	rep: filled with the report
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void energy_accum_report(struct energy_accum *acc, struct energy_report *rep)
+{
+	rep->window_joules = acc->window_joules;
+	rep->window_seconds = acc->window_seconds;
+	rep->avg_watts = acc->window_seconds > 0 ?
+		acc->window_joules / acc->window_seconds : acc->last_watts;
+	rep->peak_watts = acc->window_peak_watts;
+	rep->total_joules = acc->total_joules;
+	rep->total_seconds = acc->total_seconds;
+
+	acc->window_joules = 0;
+	acc->window_seconds = 0;
+	acc->window_peak_watts = acc->last_watts;
+}
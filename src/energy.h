@@ -0,0 +1,45 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+#ifndef _PLATFORMSTATS_ENERGY_H_
+#define _PLATFORMSTATS_ENERGY_H_
+
+#include <time.h>
+
+/**************************** Type Definitions *******************************/
+/*
+ * Energy accumulated from timestamped power samples or energy counter deltas.
+ * A window runs from one report to the next; totals run since the first
+ * sample.
+ */
+struct energy_accum {
+	int num_samples;
+	struct timespec last_time;	/* CLOCK_MONOTONIC time of last sample */
+	double last_watts;
+	double window_joules;
+	double window_seconds;
+	double window_peak_watts;
+	double total_joules;
+	double total_seconds;
+};
+
+struct energy_report {
+	double window_joules;
+	double window_seconds;
+	double avg_watts;		/* window_joules / window_seconds */
+	double peak_watts;		/* highest sample of the window */
+	double total_joules;
+	double total_seconds;
+};
+
+/************************** Function Prototypes  *****************************/
+void energy_accum_reset(struct energy_accum *acc);
+void energy_accum_add_power(struct energy_accum *acc, double watts,
+		const struct timespec *t);
+void energy_accum_add_energy(struct energy_accum *acc, double joules,
+		const struct timespec *t);
+void energy_accum_report(struct energy_accum *acc, struct energy_report *rep);
+
+#endif /* _PLATFORMSTATS_ENERGY_H_ */
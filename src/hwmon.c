@@ -0,0 +1,1159 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+
+#include "hwmon.h"
+#include "utils.h"
+
+/************************** Variable Definitions *****************************/
+static const struct {
+	const char *prefix;
+	enum hwmon_sensor_type type;
+	const char *unit;
+} hwmon_sensor_types[] = {
+	{ "in",		HWMON_SENSOR_IN,	"mV" },
+	{ "curr",	HWMON_SENSOR_CURR,	"mA" },
+	{ "power",	HWMON_SENSOR_POWER,	"uW" },
+	{ "energy",	HWMON_SENSOR_ENERGY,	"uJ" },
+	{ "temp",	HWMON_SENSOR_TEMP,	"mC" },
+	{ "fan",	HWMON_SENSOR_FAN,	"RPM" },
+	{ "humidity",	HWMON_SENSOR_HUMIDITY,	"m%" },
+};
+
+#define NUM_HWMON_SENSOR_TYPES \
+	(sizeof(hwmon_sensor_types) / sizeof(hwmon_sensor_types[0]))
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API reports whether the parent device of an hwmon device sits on a
+* serial bus. Reads from such devices are bus transactions that can take
+* milliseconds, so they are issued through the reader pool.
+*
+* @param	dirfd: open directory fd of /sys/class/hwmon/hwmonN
+*
+* @return	1 for I2C, SMBus or SPI backed devices, 0 otherwise.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int hwmon_is_bus_device(int dirfd)
+{
+	char link[256];
+	ssize_t len;
+	const char *bus;
+
+	len = readlinkat(dirfd, "device/subsystem", link, sizeof(link) - 1);
+	if(len <= 0)
+	{
+		return(0);
+	}
+	link[len] = '\0';
+
+	bus = strrchr(link, '/');
+	bus = bus ? bus + 1 : link;
+
+	return(!strcmp(bus, "i2c") || !strcmp(bus, "spi"));
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads the name of the parent device of an hwmon device, e.g.
+* "1-0040" for an I2C client. Unlike hwmonN/name it is unique per chip, so it
+* tells several monitors driven by the same driver apart.
+*
+* @param	dirfd: open directory fd of /sys/class/hwmon/hwmonN
+* @param	bus_id: buffer for the device name, "" if there is no parent
+* @param	len: size of bus_id
+*
+* @return	None.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void hwmon_read_bus_id(int dirfd, char *bus_id, size_t len)
+{
+	char link[256];
+	ssize_t n;
+	const char *base;
+
+	bus_id[0] = '\0';
+
+	n = readlinkat(dirfd, "device", link, sizeof(link) - 1);
+	if(n <= 0)
+	{
+		return;
+	}
+	link[n] = '\0';
+
+	base = strrchr(link, '/');
+	base = base ? base + 1 : link;
+
+	/* a truncated id could match another device, leave it empty instead */
+	if(strlen(base) < len)
+	{
+		memcpy(bus_id, base, strlen(base) + 1);
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads the update_interval attribute of an hwmon device, i.e. the
+* period in ms at which the chip refreshes its measurements.
+*
+* @param	dirfd: open directory fd of /sys/class/hwmon/hwmonN
+*
+* @return	update interval in ms, 0 if the chip does not report one.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int hwmon_read_update_interval(int dirfd)
+{
+	char buf[32];
+	long interval;
+
+	if(read_sysfs_string(dirfd, "update_interval", buf, sizeof(buf)) ||
+		parse_long(buf, strlen(buf), &interval) || interval < 0)
+	{
+		return(0);
+	}
+
+	return((int)interval);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API opens a kobject uevent netlink socket so that hwmon device add and
+* remove events can be detected without rescanning /sys/class/hwmon.
+*
+* @return	socket fd, or -1 if uevents are not available.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int hwmon_uevent_open(void)
+{
+	int fd, rcvbuf = HWMON_UEVENT_RCVBUF;
+	struct sockaddr_nl addr;
+
+	fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+			NETLINK_KOBJECT_UEVENT);
+	if(fd < 0)
+	{
+		return(-1);
+	}
+
+	/* every uevent of the system is queued here between two refreshes */
+	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.nl_family = AF_NETLINK;
+	addr.nl_groups = 1;
+
+	if(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+	{
+		close(fd);
+		return(-1);
+	}
+
+	return(fd);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API closes all directory fds held by the index and marks it invalid.
+* The uevent socket is kept so that the index can be rebuilt later.
+*
+* @param	idx: hwmon index
+*
+* @return	None.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void hwmon_index_close_devices(struct hwmon_index *idx)
+{
+	int i;
+
+	for(i = 0; i < idx->num_devices; i++)
+	{
+		if(idx->devices[i].dirfd >= 0)
+		{
+			close(idx->devices[i].dirfd);
+		}
+	}
+
+	idx->num_devices = 0;
+	idx->valid = 0;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API scans /sys/class/hwmon once, opens a directory fd for every hwmonN
+* entry and records its name. The resulting index is used for all later
+* name to hwmon lookups until a device is added or removed.
+*
+* @param	idx: hwmon index to populate
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int hwmon_index_init(struct hwmon_index *idx)
+{
+	DIR *d;
+	struct dirent *dir;
+	int class_fd;
+
+	hwmon_index_close_devices(idx);
+
+	if(idx->uevent_fd < 0)
+	{
+		idx->uevent_fd = hwmon_uevent_open();
+	}
+
+	d = opendir(HWMON_CLASS_PATH);
+	if(!d)
+	{
+		int ret = errno;
+
+		/*
+		 * Without the class there is nothing to look up until a device
+		 * shows up; an empty index keeps every lookup from rescanning.
+		 */
+		printf("Unable to open %s path\n", HWMON_CLASS_PATH);
+		if(ret == ENOENT)
+		{
+			idx->valid = 1;
+			idx->generation++;
+		}
+		return(ret);
+	}
+
+	class_fd = dirfd(d);
+
+	while((dir = readdir(d)) != NULL && idx->num_devices < MAX_HWMON_DEVICES)
+	{
+		struct hwmon_device *dev;
+		int id;
+
+		if(sscanf(dir->d_name, "hwmon%d", &id) != 1)
+		{
+			continue;
+		}
+
+		dev = &idx->devices[idx->num_devices];
+		dev->id = id;
+		dev->dirfd = openat(class_fd, dir->d_name,
+				O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if(dev->dirfd < 0)
+		{
+			continue;
+		}
+
+		if(read_sysfs_string(dev->dirfd, "name", dev->name, sizeof(dev->name)))
+		{
+			dev->name[0] = '\0';
+		}
+
+		dev->slow = hwmon_is_bus_device(dev->dirfd);
+		hwmon_read_bus_id(dev->dirfd, dev->bus_id, sizeof(dev->bus_id));
+		dev->update_interval = hwmon_read_update_interval(dev->dirfd);
+
+		idx->num_devices++;
+	}
+
+	closedir(d);
+
+	idx->valid = 1;
+	idx->generation++;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API releases all resources held by the index.
+*
+* @param	idx: hwmon index
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void hwmon_index_release(struct hwmon_index *idx)
+{
+	hwmon_index_close_devices(idx);
+
+	if(idx->uevent_fd >= 0)
+	{
+		close(idx->uevent_fd);
+		idx->uevent_fd = -1;
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API forces the index to be rebuilt on its next use.
+*
+* @param	idx: hwmon index
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void hwmon_index_invalidate(struct hwmon_index *idx)
+{
+	idx->valid = 0;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API drains pending kobject uevents and invalidates the index if an
+* hwmon device was added or removed. The index is then rebuilt if required.
+* Uevent messages have the form "<action>@<devpath>" followed by the
+* environment strings. If the socket overflowed, the lost events may have
+* been hwmon ones, so the index is rebuilt too.
+*
+* @param	idx: hwmon index
+*
+* @return	1 if the index was rebuilt, 0 if unchanged, errno on failure.
+*
+* @note		None.
+*
+******************************************************************************/
+int hwmon_index_refresh(struct hwmon_index *idx)
+{
+	char buf[4096];
+	ssize_t len;
+	int ret;
+
+	while(idx->uevent_fd >= 0)
+	{
+		len = recv(idx->uevent_fd, buf, sizeof(buf) - 1, 0);
+		if(len < 0 && errno == ENOBUFS)
+		{
+			/* events were dropped, one of them may have been an hwmon one */
+			idx->valid = 0;
+			continue;
+		}
+		if(len < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if(len <= 0)
+		{
+			break;
+		}
+
+		buf[len] = '\0';
+
+		if((!strncmp(buf, "add@", 4) || !strncmp(buf, "remove@", 7)) &&
+			strstr(buf, "/hwmon/hwmon"))
+		{
+			idx->valid = 0;
+		}
+	}
+
+	if(idx->valid)
+	{
+		return(0);
+	}
+
+	ret = hwmon_index_init(idx);
+
+	return(ret ? ret : 1);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API returns the indexed hwmon device with the given name.
+*
+* @param	idx: hwmon index
+* @param	name: device name as reported by hwmonN/name
+*
+* @return	hwmon device, or NULL if not found.
+*
+* @note		None.
+*
+******************************************************************************/
+struct hwmon_device *hwmon_index_lookup(struct hwmon_index *idx, const char *name)
+{
+	int i;
+
+	hwmon_index_refresh(idx);
+
+	if(!idx->valid)
+	{
+		return(NULL);
+	}
+
+	for(i = 0; i < idx->num_devices; i++)
+	{
+		if(!strcmp(idx->devices[i].name, name))
+		{
+			return(&idx->devices[i]);
+		}
+	}
+
+	return(NULL);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API classifies an hwmon attribute prefix such as "in1" or "temp3" by
+* its sensor type and channel number, following the sysfs hwmon ABI naming.
+*
+* @param	attr: attribute prefix without the _input suffix
+* @param	channel: parsed channel number
+*
+* @return	sensor type.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static enum hwmon_sensor_type hwmon_classify_attr(const char *attr, int *channel)
+{
+	size_t i, len;
+
+	for(i = 0; i < NUM_HWMON_SENSOR_TYPES; i++)
+	{
+		len = strlen(hwmon_sensor_types[i].prefix);
+
+		if(!strncmp(attr, hwmon_sensor_types[i].prefix, len) &&
+			sscanf(attr + len, "%d", channel) == 1)
+		{
+			return(hwmon_sensor_types[i].type);
+		}
+	}
+
+	*channel = 0;
+	return(HWMON_SENSOR_OTHER);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API returns the hwmon ABI unit of a sensor value.
+*
+* @param	sensor: hwmon sensor
+*
+* @return	unit string.
+*
+* @note		None.
+*
+******************************************************************************/
+const char *hwmon_sensor_unit(const struct hwmon_sensor *sensor)
+{
+	size_t i;
+
+	for(i = 0; i < NUM_HWMON_SENSOR_TYPES; i++)
+	{
+		if(hwmon_sensor_types[i].type == sensor->type)
+		{
+			return(hwmon_sensor_types[i].unit);
+		}
+	}
+
+	return("");
+}
+
+/*****************************************************************************/
+/*
+*
+* This API orders sensors by hwmon device, sensor type and channel so that
+* the table is printed in a stable order regardless of readdir order.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int hwmon_sensor_compare(const void *a, const void *b)
+{
+	const struct hwmon_sensor *sa = a, *sb = b;
+
+	if(sa->hwmon_id != sb->hwmon_id)
+	{
+		return(sa->hwmon_id - sb->hwmon_id);
+	}
+
+	if(sa->type != sb->type)
+	{
+		return((int)sa->type - (int)sb->type);
+	}
+
+	return(sa->channel - sb->channel);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API carries the configuration and accumulated state of a sensor of the
+* previous enumeration over to the same sensor of the new one. Sensors are
+* matched by device name, parent device and attribute, as hwmonN numbers
+* change when a chip is unbound and bound again.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void hwmon_sensor_adopt(struct hwmon_sensor *sensor,
+		const struct hwmon_sensor *old, int num_old)
+{
+	int i;
+
+	for(i = 0; i < num_old; i++)
+	{
+		if(!strcmp(old[i].attr, sensor->attr) &&
+			!strcmp(old[i].device, sensor->device) &&
+			!strcmp(old[i].bus_id, sensor->bus_id))
+		{
+			sensor->refresh_ms = old[i].refresh_ms;
+			sensor->timeout_ms = old[i].timeout_ms;
+			sensor->value = old[i].value;
+			sensor->status = old[i].status;
+			sensor->sampled_at = old[i].sampled_at;
+			sensor->energy = old[i].energy;
+			return;
+		}
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API closes all sensor fds held by the table, after waiting for reads
+* still in flight in the reader pool. The reader threads keep running.
+*
+* @param	tbl: sensor table
+*
+* @return	None.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void hwmon_sensors_close(struct hwmon_sensor_table *tbl)
+{
+	int i;
+
+	if(tbl->pool)
+	{
+		hwmon_reader_wait_idle(tbl->pool, tbl->sensors, tbl->num_sensors);
+	}
+
+	for(i = 0; i < tbl->num_sensors; i++)
+	{
+		if(tbl->sensors[i].fd >= 0)
+		{
+			close(tbl->sensors[i].fd);
+		}
+	}
+
+	tbl->num_sensors = 0;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API enumerates every <attr>_input attribute of every indexed hwmon
+* device, reads the matching <attr>_label and opens the input attribute once.
+* The resulting flat table is read with pread on every tick. When the table
+* is rebuilt after a hotplug event, sensors that are still present keep
+* their refresh and timeout overrides, cached value and energy accumulator.
+*
+* @param	tbl: sensor table to populate
+* @param	idx: hwmon index to enumerate
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int hwmon_sensors_init(struct hwmon_sensor_table *tbl, struct hwmon_index *idx)
+{
+	struct hwmon_sensor *old = NULL;
+	int i, num_old = 0;
+
+	if(tbl->pool)
+	{
+		hwmon_reader_wait_idle(tbl->pool, tbl->sensors, tbl->num_sensors);
+	}
+
+	/* Rebuilding after hotplug, the previous sensors are matched below */
+	if(tbl->num_sensors > 0)
+	{
+		old = malloc(tbl->num_sensors * sizeof(*old));
+		if(old != NULL)
+		{
+			num_old = tbl->num_sensors;
+			memcpy(old, tbl->sensors, num_old * sizeof(*old));
+		}
+	}
+
+	hwmon_sensors_close(tbl);
+
+	tbl->idx = idx;
+	hwmon_index_refresh(idx);
+
+	if(!idx->valid)
+	{
+		free(old);
+		return(ENODEV);
+	}
+
+	for(i = 0; i < idx->num_devices; i++)
+	{
+		struct hwmon_device *dev = &idx->devices[i];
+		struct dirent *dir;
+		DIR *d;
+		int fd;
+
+		fd = openat(dev->dirfd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if(fd < 0 || (d = fdopendir(fd)) == NULL)
+		{
+			if(fd >= 0)
+			{
+				close(fd);
+			}
+			continue;
+		}
+
+		while((dir = readdir(d)) != NULL && tbl->num_sensors < MAX_HWMON_SENSORS)
+		{
+			struct hwmon_sensor *sensor = &tbl->sensors[tbl->num_sensors];
+			char attr_file[HWMON_ATTR_LEN + 8];
+			char *suffix;
+			size_t len;
+
+			suffix = strstr(dir->d_name, "_input");
+			if(suffix == NULL || suffix[6] != '\0')
+			{
+				continue;
+			}
+
+			len = suffix - dir->d_name;
+			if(len == 0 || len >= HWMON_ATTR_LEN)
+			{
+				continue;
+			}
+
+			memset(sensor, 0, sizeof(*sensor));
+			memcpy(sensor->attr, dir->d_name, len);
+			sensor->attr[len] = '\0';
+			sensor->hwmon_id = dev->id;
+			sensor->slow = dev->slow;
+			sensor->timeout_ms = HWMON_SENSOR_TIMEOUT_MS;
+			sensor->refresh_ms = dev->update_interval;
+			sensor->type = hwmon_classify_attr(sensor->attr, &sensor->channel);
+			strcpy(sensor->device, dev->name);
+			strcpy(sensor->bus_id, dev->bus_id);
+
+			sensor->fd = openat(dev->dirfd, dir->d_name, O_RDONLY | O_CLOEXEC);
+			if(sensor->fd < 0)
+			{
+				continue;
+			}
+
+			sprintf(attr_file, "%s_label", sensor->attr);
+			if(read_sysfs_string(dev->dirfd, attr_file, sensor->label,
+					sizeof(sensor->label)))
+			{
+				strcpy(sensor->label, sensor->attr);
+			}
+
+			sensor->status = EAGAIN;
+			hwmon_sensor_adopt(sensor, old, num_old);
+			tbl->num_sensors++;
+		}
+
+		closedir(d);
+	}
+
+	free(old);
+
+	qsort(tbl->sensors, tbl->num_sensors, sizeof(tbl->sensors[0]),
+		hwmon_sensor_compare);
+
+	tbl->idx_generation = idx->generation;
+	tbl->generation++;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API closes all sensor fds held by the table, after waiting for reads
+* still in flight in the reader pool, and stops and joins the reader
+* threads. They are started again by the next read of a slow sensor.
+*
+* @param	tbl: sensor table
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void hwmon_sensors_release(struct hwmon_sensor_table *tbl)
+{
+	hwmon_sensors_close(tbl);
+
+	if(tbl->pool)
+	{
+		hwmon_reader_stop(tbl->pool);
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads one value with pread from offset 0 of an already open input
+* attribute into a stack buffer. No path is built, no file is opened and no
+* memory is allocated.
+*
+* @param	fd: open fd of an <attr>_input attribute
+* @param	value: parsed value
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int hwmon_sensor_fetch(int fd, long *value)
+{
+	char buf[32];
+	ssize_t len;
+
+	len = pread(fd, buf, sizeof(buf), 0);
+	if(len <= 0)
+	{
+		return(len < 0 ? errno : ENODATA);
+	}
+
+	return(parse_long(buf, len, value));
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads one sensor synchronously in the calling thread.
+*
+* @param	sensor: hwmon sensor
+*
+* @return	0 on success, errno otherwise. The error is also kept in
+*		sensor->status.
+*
+* @note		None.
+*
+******************************************************************************/
+int hwmon_sensor_read(struct hwmon_sensor *sensor)
+{
+	sensor->status = hwmon_sensor_fetch(sensor->fd, &sensor->value);
+	clock_gettime(CLOCK_MONOTONIC, &sensor->sampled_at);
+	hwmon_sensor_sampled(sensor);
+
+	return(sensor->status);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API processes a freshly read sensor value. Power sensors feed their
+* energy accumulator, in W, at the time the value was sampled.
+*
+* @param	sensor: hwmon sensor
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void hwmon_sensor_sampled(struct hwmon_sensor *sensor)
+{
+	if(sensor->type == HWMON_SENSOR_POWER && sensor->status == 0)
+	{
+		energy_accum_add_power(&sensor->energy, sensor->value / 1e6,
+			&sensor->sampled_at);
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API returns the age of the cached value of a sensor.
+*
+* @param	sensor: hwmon sensor
+* @param	now: current CLOCK_MONOTONIC time
+*
+* @return	age in ms, or -1 if the sensor was never read.
+*
+* @note		None.
+*
+******************************************************************************/
+long hwmon_sensor_age_ms(const struct hwmon_sensor *sensor, const struct timespec *now)
+{
+	if(sensor->sampled_at.tv_sec == 0 && sensor->sampled_at.tv_nsec == 0)
+	{
+		return(-1);
+	}
+
+	return((now->tv_sec - sensor->sampled_at.tv_sec) * 1000 +
+		(now->tv_nsec - sensor->sampled_at.tv_nsec) / 1000000);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads a list of sensors, through the reader pool of the table if
+* it has one and inline otherwise. Sensors whose cached value is younger than
+* their refresh period are not read again; they keep their cached value and
+* timestamp, so callers can poll faster than slow chips refresh without
+* spending bus bandwidth.
+*
+* @param	tbl: sensor table the sensors belong to
+* @param	sensors: sensors to read
+* @param	num_sensors: number of sensors
+*
+* @return	number of sensors actually read successfully.
+*
+* @note		None.
+*
+******************************************************************************/
+int hwmon_sensors_read_list(struct hwmon_sensor_table *tbl,
+		struct hwmon_sensor **sensors, int num_sensors)
+{
+	struct hwmon_sensor *due[MAX_HWMON_SENSORS];
+	struct timespec now;
+	int i, num_due, num_read;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	num_due = 0;
+
+	for(i = 0; i < num_sensors; i++)
+	{
+		long age = hwmon_sensor_age_ms(sensors[i], &now);
+
+		if(age < 0 || age >= sensors[i]->refresh_ms)
+		{
+			due[num_due++] = sensors[i];
+		}
+	}
+
+	if(tbl->pool)
+	{
+		return(hwmon_reader_read(tbl->pool, due, num_due));
+	}
+
+	num_read = 0;
+
+	for(i = 0; i < num_due; i++)
+	{
+		if(!hwmon_sensor_read(due[i]))
+		{
+			num_read++;
+		}
+	}
+
+	return(num_read);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API makes sure the table matches the current hwmon index and
+* re-enumerates it if the index was rebuilt since the last pass.
+*
+* @param	tbl: sensor table
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void hwmon_sensors_sync(struct hwmon_sensor_table *tbl)
+{
+	hwmon_index_refresh(tbl->idx);
+
+	if(tbl->idx_generation != tbl->idx->generation)
+	{
+		hwmon_sensors_init(tbl, tbl->idx);
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads every sensor of the table in a single pass. Slow sensors are
+* read concurrently by the reader pool while the others are read inline. The
+* table is re-enumerated if the hwmon index was rebuilt since the last pass.
+*
+* @param	tbl: sensor table
+*
+* @return	number of sensors read successfully.
+*
+* @note		None.
+*
+******************************************************************************/
+int hwmon_sensors_read_all(struct hwmon_sensor_table *tbl)
+{
+	struct hwmon_sensor *sensors[MAX_HWMON_SENSORS];
+	int i;
+
+	hwmon_sensors_sync(tbl);
+
+	for(i = 0; i < tbl->num_sensors; i++)
+	{
+		sensors[i] = &tbl->sensors[i];
+	}
+
+	return(hwmon_sensors_read_list(tbl, sensors, tbl->num_sensors));
+}
+
+/*****************************************************************************/
+/*
+*
+* This API checks whether a sensor belongs to the device described by spec.
+* The spec is either the hwmon device name, the name followed by the parent
+* device ("ina226@1-0040") to tell chips of the same driver apart, or the
+* hwmon directory name ("hwmon3").
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int hwmon_sensor_match(struct hwmon_sensor_table *tbl,
+		const struct hwmon_sensor *sensor, const char *spec)
+{
+	const char *at;
+	size_t len;
+	int i, id;
+	char c;
+
+	if(sscanf(spec, "hwmon%d%c", &id, &c) == 1)
+	{
+		return(sensor->hwmon_id == id);
+	}
+
+	at = strchr(spec, '@');
+	if(at == NULL)
+	{
+		return(!strcmp(sensor->device, spec));
+	}
+
+	len = at - spec;
+	if(strncmp(sensor->device, spec, len) || sensor->device[len] != '\0')
+	{
+		return(0);
+	}
+
+	for(i = 0; i < tbl->idx->num_devices; i++)
+	{
+		if(tbl->idx->devices[i].id == sensor->hwmon_id)
+		{
+			return(!strcmp(tbl->idx->devices[i].bus_id, at + 1));
+		}
+	}
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API returns the sensor for the given hwmon device and attribute
+* prefix, e.g. ("ina260_u14", "power1") or ("ina226@1-0040", "curr1").
+*
+* @param	tbl: sensor table
+* @param	device: hwmon device name, name@parent or hwmonN
+* @param	attr: attribute prefix without the _input suffix
+*
+* @return	sensor, or NULL if not found.
+*
+* @note		None.
+*
+******************************************************************************/
+struct hwmon_sensor *hwmon_sensor_lookup(struct hwmon_sensor_table *tbl,
+		const char *device, const char *attr)
+{
+	int i;
+
+	for(i = 0; i < tbl->num_sensors; i++)
+	{
+		if(!strcmp(tbl->sensors[i].attr, attr) &&
+			hwmon_sensor_match(tbl, &tbl->sensors[i], device))
+		{
+			return(&tbl->sensors[i]);
+		}
+	}
+
+	return(NULL);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API describes a set of attributes of one hwmon device. The set is
+* resolved against the sensor table on its first read.
+*
+* @param	set: sensor set
+* @param	device: hwmon device name
+* @param	attrs: attribute prefixes without the _input suffix
+* @param	num_attrs: number of attributes, at most MAX_SENSOR_SET
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void hwmon_sensor_set_init(struct hwmon_sensor_set *set, const char *device,
+		const char *const *attrs, int num_attrs)
+{
+	set->device = device;
+	set->attrs = attrs;
+	set->num_attrs = num_attrs < MAX_SENSOR_SET ? num_attrs : MAX_SENSOR_SET;
+	set->generation = 0;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads every sensor of the set. The attributes are looked up in the
+* sensor table only when the table was rebuilt since the last read, so the
+* steady state cost is one pread per attribute. Missing attributes are left
+* NULL in set->sensors.
+*
+* @param	tbl: sensor table
+* @param	set: sensor set
+*
+* @return	number of sensors read successfully.
+*
+* @note		None.
+*
+******************************************************************************/
+int hwmon_sensor_set_read(struct hwmon_sensor_table *tbl, struct hwmon_sensor_set *set)
+{
+	struct hwmon_sensor *sensors[MAX_SENSOR_SET];
+	int i, num_sensors;
+
+	hwmon_sensors_sync(tbl);
+
+	if(set->generation != tbl->generation)
+	{
+		for(i = 0; i < set->num_attrs; i++)
+		{
+			set->sensors[i] = hwmon_sensor_lookup(tbl, set->device,
+						set->attrs[i]);
+		}
+		set->generation = tbl->generation;
+	}
+
+	num_sensors = 0;
+
+	for(i = 0; i < set->num_attrs; i++)
+	{
+		if(set->sensors[i])
+		{
+			sensors[num_sensors++] = set->sensors[i];
+		}
+	}
+
+	return(hwmon_sensors_read_list(tbl, sensors, num_sensors));
+}
+
+/*****************************************************************************/
+/*
+*
+* This API sets the read timeout of the slow sensors of one hwmon device, or
+* of every device if device is NULL. A sensor whose read does not complete
+* within its timeout is marked stale and keeps its previous value.
+*
+* @param	tbl: sensor table
+* @param	device: hwmon device name, name@parent, hwmonN or NULL for all
+* @param	timeout_ms: read timeout in ms
+*
+* @return	number of sensors updated.
+*
+* @note		None.
+*
+******************************************************************************/
+int hwmon_sensors_set_timeout(struct hwmon_sensor_table *tbl, const char *device,
+		int timeout_ms)
+{
+	int i, num_updated;
+
+	num_updated = 0;
+
+	for(i = 0; i < tbl->num_sensors; i++)
+	{
+		if(device == NULL || hwmon_sensor_match(tbl, &tbl->sensors[i], device))
+		{
+			tbl->sensors[i].timeout_ms = timeout_ms;
+			num_updated++;
+		}
+	}
+
+	return(num_updated);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API overrides the minimum refresh period of sensors. By default a
+* sensor is refreshed at most every update_interval ms of its hwmon device,
+* or on every read if the chip does not report an update interval.
+*
+* @param	tbl: sensor table
+* @param	device: hwmon device name, name@parent, hwmonN or NULL for all
+* @param	attr: attribute prefix, or NULL for every sensor of the device
+* @param	refresh_ms: minimum period between two reads, 0 to read every time
+*
+* @return	number of sensors updated.
+*
+* @note		None.
+*
+******************************************************************************/
+int hwmon_sensors_set_refresh(struct hwmon_sensor_table *tbl, const char *device,
+		const char *attr, int refresh_ms)
+{
+	int i, num_updated;
+
+	num_updated = 0;
+
+	for(i = 0; i < tbl->num_sensors; i++)
+	{
+		if((device == NULL || hwmon_sensor_match(tbl, &tbl->sensors[i], device)) &&
+			(attr == NULL || !strcmp(tbl->sensors[i].attr, attr)))
+		{
+			tbl->sensors[i].refresh_ms = refresh_ms;
+			num_updated++;
+		}
+	}
+
+	return(num_updated);
+}
@@ -0,0 +1,155 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+#ifndef _PLATFORMSTATS_HWMON_H_
+#define _PLATFORMSTATS_HWMON_H_
+
+#include <time.h>
+#include <pthread.h>
+
+#include "energy.h"
+
+/************************** Constant Definitions *****************************/
+#define HWMON_CLASS_PATH	"/sys/class/hwmon"
+#define MAX_HWMON_DEVICES	64
+#define HWMON_NAME_LEN		64
+#define MAX_HWMON_SENSORS	256
+#define HWMON_ATTR_LEN		32
+#define HWMON_LABEL_LEN		64
+#define MAX_SENSOR_SET		16
+#define HWMON_READER_THREADS	4
+#define HWMON_SENSOR_TIMEOUT_MS	50	/* default per sensor read timeout */
+#define HWMON_UEVENT_RCVBUF	(1024 * 1024)	/* uevent socket buffer, bytes */
+
+/**************************** Type Definitions *******************************/
+struct hwmon_device {
+	int id;				/* N of /sys/class/hwmon/hwmonN */
+	int dirfd;			/* open O_DIRECTORY fd of hwmonN */
+	int slow;			/* parent device sits on an I2C/SPI bus */
+	int update_interval;		/* hwmonN/update_interval in ms, 0 if absent */
+	char name[HWMON_NAME_LEN];	/* contents of hwmonN/name */
+	char bus_id[HWMON_NAME_LEN];	/* parent device, e.g. "1-0040", or "" */
+};
+
+struct hwmon_index {
+	int valid;
+	int num_devices;
+	int uevent_fd;			/* kobject uevent socket, -1 if unavailable */
+	unsigned int generation;	/* bumped every time the index is rebuilt */
+	struct hwmon_device devices[MAX_HWMON_DEVICES];
+};
+
+enum hwmon_sensor_type {
+	HWMON_SENSOR_IN,
+	HWMON_SENSOR_CURR,
+	HWMON_SENSOR_POWER,
+	HWMON_SENSOR_ENERGY,
+	HWMON_SENSOR_TEMP,
+	HWMON_SENSOR_FAN,
+	HWMON_SENSOR_HUMIDITY,
+	HWMON_SENSOR_OTHER,
+};
+
+struct hwmon_sensor {
+	int hwmon_id;
+	int channel;			/* N of inN, tempN, ... */
+	enum hwmon_sensor_type type;
+	char device[HWMON_NAME_LEN];	/* hwmonN/name */
+	char bus_id[HWMON_NAME_LEN];	/* parent device, see hwmon_device */
+	char attr[HWMON_ATTR_LEN];	/* attribute prefix, e.g. "in1" */
+	char label[HWMON_LABEL_LEN];	/* <attr>_label, or attr if absent */
+	int fd;				/* open fd of <attr>_input */
+	long value;			/* last value in hwmon ABI units */
+	int status;			/* 0 if value is valid, errno otherwise */
+	int refresh_ms;			/* minimum period between two reads */
+	struct timespec sampled_at;	/* CLOCK_MONOTONIC time of value */
+	struct energy_accum energy;	/* integrated power, power sensors only */
+
+	/* asynchronous read state, owned by the reader pool lock */
+	int slow;			/* read through the reader pool */
+	int stale;			/* last read did not finish in time */
+	int timeout_ms;			/* per read timeout for slow sensors */
+	int in_flight;			/* queued or being read by a worker */
+	int result_ready;		/* worker result not yet adopted */
+	long pending_value;
+	int pending_status;
+	struct timespec pending_time;
+	struct timespec deadline;
+};
+
+/*
+ * Small pool of reader threads used to read slow, bus backed sensors
+ * concurrently so that one slow transaction does not stall the whole tick.
+ */
+struct hwmon_reader_pool {
+	pthread_mutex_t lock;
+	pthread_cond_t work_cond;	/* signalled when a read is queued */
+	pthread_cond_t done_cond;	/* signalled when a read completes */
+	pthread_t threads[HWMON_READER_THREADS];
+	int num_threads;
+	int running;
+	int head;
+	int count;
+	struct hwmon_sensor *queue[MAX_HWMON_SENSORS];
+};
+
+struct hwmon_sensor_table {
+	struct hwmon_index *idx;
+	struct hwmon_reader_pool *pool;	/* NULL to read every sensor inline */
+	unsigned int idx_generation;	/* idx->generation the table was built from */
+	unsigned int generation;	/* bumped every time the table is rebuilt */
+	int num_sensors;
+	struct hwmon_sensor sensors[MAX_HWMON_SENSORS];
+};
+
+/*
+ * A fixed set of attributes of one hwmon device, resolved once against the
+ * sensor table so that the per tick path only issues pread calls.
+ */
+struct hwmon_sensor_set {
+	const char *device;
+	const char *const *attrs;
+	int num_attrs;
+	unsigned int generation;	/* tbl->generation the set was bound to */
+	struct hwmon_sensor *sensors[MAX_SENSOR_SET];	/* NULL if absent */
+};
+
+/************************** Function Prototypes  *****************************/
+int hwmon_index_init(struct hwmon_index *idx);
+void hwmon_index_release(struct hwmon_index *idx);
+int hwmon_index_refresh(struct hwmon_index *idx);
+void hwmon_index_invalidate(struct hwmon_index *idx);
+struct hwmon_device *hwmon_index_lookup(struct hwmon_index *idx, const char *name);
+
+int hwmon_sensors_init(struct hwmon_sensor_table *tbl, struct hwmon_index *idx);
+void hwmon_sensors_release(struct hwmon_sensor_table *tbl);
+int hwmon_sensors_read_all(struct hwmon_sensor_table *tbl);
+int hwmon_sensors_read_list(struct hwmon_sensor_table *tbl,
+		struct hwmon_sensor **sensors, int num_sensors);
+void hwmon_sensors_sync(struct hwmon_sensor_table *tbl);
+int hwmon_sensor_fetch(int fd, long *value);
+int hwmon_sensor_read(struct hwmon_sensor *sensor);
+void hwmon_sensor_sampled(struct hwmon_sensor *sensor);
+int hwmon_sensors_set_timeout(struct hwmon_sensor_table *tbl, const char *device,
+		int timeout_ms);
+int hwmon_sensors_set_refresh(struct hwmon_sensor_table *tbl, const char *device,
+		const char *attr, int refresh_ms);
+long hwmon_sensor_age_ms(const struct hwmon_sensor *sensor, const struct timespec *now);
+struct hwmon_sensor *hwmon_sensor_lookup(struct hwmon_sensor_table *tbl,
+		const char *device, const char *attr);
+const char *hwmon_sensor_unit(const struct hwmon_sensor *sensor);
+
+void hwmon_sensor_set_init(struct hwmon_sensor_set *set, const char *device,
+		const char *const *attrs, int num_attrs);
+int hwmon_sensor_set_read(struct hwmon_sensor_table *tbl, struct hwmon_sensor_set *set);
+
+int hwmon_reader_start(struct hwmon_reader_pool *pool, int num_threads);
+void hwmon_reader_stop(struct hwmon_reader_pool *pool);
+int hwmon_reader_read(struct hwmon_reader_pool *pool, struct hwmon_sensor **sensors,
+		int num_sensors);
+void hwmon_reader_wait_idle(struct hwmon_reader_pool *pool,
+		struct hwmon_sensor *sensors, int num_sensors);
+
+#endif /* _PLATFORMSTATS_HWMON_H_ */
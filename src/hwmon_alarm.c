@@ -0,0 +1,341 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+
+#include "hwmon_alarm.h"
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API records an alarm transition in the event ring. The oldest event
+* is overwritten when the ring is full.
+*
+* @note		Internal API only. Called with the monitor lock held.
+*
+******************************************************************************/
+static void hwmon_alarm_record(struct hwmon_alarm_monitor *mon, struct hwmon_alarm *alarm)
+{
+	struct alarm_event *ev;
+
+	if(mon->count == ALARM_EVENT_RING)
+	{
+		mon->head = (mon->head + 1) % ALARM_EVENT_RING;
+		mon->count--;
+		mon->dropped++;
+	}
+
+	ev = &mon->events[(mon->head + mon->count) % ALARM_EVENT_RING];
+	clock_gettime(CLOCK_MONOTONIC, &ev->monotonic);
+	clock_gettime(CLOCK_REALTIME, &ev->realtime);
+	ev->state = alarm->state;
+	strcpy(ev->device, alarm->device);
+	strcpy(ev->attr, alarm->attr);
+	strcpy(ev->label, alarm->label);
+	mon->count++;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API re-reads one alarm attribute and records a transition if its
+* state changed. Reading from offset 0 also re-arms sysfs poll notification.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void hwmon_alarm_check(struct hwmon_alarm_monitor *mon, struct hwmon_alarm *alarm)
+{
+	long value;
+
+	if(hwmon_sensor_fetch(alarm->fd, &value))
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&mon->lock);
+	if((value != 0) != alarm->state)
+	{
+		alarm->state = (value != 0);
+		hwmon_alarm_record(mon, alarm);
+	}
+	pthread_mutex_unlock(&mon->lock);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API is the body of the alarm thread. It sleeps in poll() on every
+* alarm attribute with POLLPRI, which hwmon drivers trigger through
+* sysfs_notify when an alarm changes. Drivers that do not notify are covered
+* by re-reading every alarm after ALARM_RESCAN_MS without a wakeup.
+*
+* @param	arg: alarm monitor
+*
+* @return	NULL.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void *hwmon_alarm_thread(void *arg)
+{
+	struct hwmon_alarm_monitor *mon = arg;
+	struct pollfd fds[MAX_HWMON_ALARMS + 1];
+	int i, ret;
+
+	for(i = 0; i < mon->num_alarms; i++)
+	{
+		fds[i].fd = mon->alarms[i].fd;
+		fds[i].events = POLLPRI | POLLERR;
+	}
+	fds[mon->num_alarms].fd = mon->stop_fd;
+	fds[mon->num_alarms].events = POLLIN;
+
+	while(1)
+	{
+		ret = poll(fds, mon->num_alarms + 1, ALARM_RESCAN_MS);
+		if(ret < 0 && errno != EINTR)
+		{
+			break;
+		}
+
+		if(fds[mon->num_alarms].revents & POLLIN)
+		{
+			break;
+		}
+
+		for(i = 0; i < mon->num_alarms; i++)
+		{
+			if(ret == 0 || fds[i].revents)
+			{
+				hwmon_alarm_check(mon, &mon->alarms[i]);
+			}
+		}
+	}
+
+	return(NULL);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API enumerates every *_alarm attribute (including *_crit_alarm,
+* *_min_alarm, ...) of every indexed hwmon device, reads its initial state
+* and starts a thread that records alarm transitions as they happen.
+*
+* @param	mon: alarm monitor
+* @param	tbl: sensor table, used for the labels of the alarms
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int hwmon_alarm_monitor_start(struct hwmon_alarm_monitor *mon,
+		struct hwmon_sensor_table *tbl)
+{
+	struct hwmon_index *idx = tbl->idx;
+	int i, ret;
+
+	if(mon->running)
+	{
+		return(0);
+	}
+
+	memset(mon, 0, sizeof(*mon));
+	pthread_mutex_init(&mon->lock, NULL);
+	mon->stop_fd = -1;
+
+	for(i = 0; i < idx->num_devices; i++)
+	{
+		struct hwmon_device *dev = &idx->devices[i];
+		struct dirent *dir;
+		DIR *d;
+		int fd;
+
+		fd = openat(dev->dirfd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if(fd < 0 || (d = fdopendir(fd)) == NULL)
+		{
+			if(fd >= 0)
+			{
+				close(fd);
+			}
+			continue;
+		}
+
+		while((dir = readdir(d)) != NULL && mon->num_alarms < MAX_HWMON_ALARMS)
+		{
+			struct hwmon_alarm *alarm = &mon->alarms[mon->num_alarms];
+			struct hwmon_sensor *sensor;
+			char prefix[HWMON_ATTR_LEN];
+			size_t len = strlen(dir->d_name);
+			long value;
+
+			if(len < 6 || len >= HWMON_ATTR_LEN ||
+				strcmp(dir->d_name + len - 6, "_alarm"))
+			{
+				continue;
+			}
+
+			alarm->fd = openat(dev->dirfd, dir->d_name, O_RDONLY | O_CLOEXEC);
+			if(alarm->fd < 0)
+			{
+				continue;
+			}
+
+			alarm->hwmon_id = dev->id;
+			strcpy(alarm->device, dev->name);
+			strcpy(alarm->attr, dir->d_name);
+
+			strcpy(prefix, dir->d_name);
+			prefix[strcspn(prefix, "_")] = '\0';
+			sensor = hwmon_sensor_lookup(tbl, dev->name, prefix);
+			strcpy(alarm->label, sensor ? sensor->label : prefix);
+
+			alarm->state = !hwmon_sensor_fetch(alarm->fd, &value) && value != 0;
+
+			mon->num_alarms++;
+		}
+
+		closedir(d);
+	}
+
+	mon->stop_fd = eventfd(0, EFD_CLOEXEC);
+	if(mon->stop_fd < 0)
+	{
+		ret = errno;
+		hwmon_alarm_monitor_stop(mon);
+		return(ret);
+	}
+
+	ret = pthread_create(&mon->thread, NULL, hwmon_alarm_thread, mon);
+	if(ret)
+	{
+		hwmon_alarm_monitor_stop(mon);
+		return(ret);
+	}
+
+	mon->running = 1;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API stops the alarm thread and closes all alarm fds.
+*
+* @param	mon: alarm monitor
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void hwmon_alarm_monitor_stop(struct hwmon_alarm_monitor *mon)
+{
+	uint64_t one = 1;
+	int i;
+
+	if(mon->running)
+	{
+		if(write(mon->stop_fd, &one, sizeof(one)) == sizeof(one))
+		{
+			pthread_join(mon->thread, NULL);
+		}
+		mon->running = 0;
+	}
+
+	if(mon->stop_fd >= 0)
+	{
+		close(mon->stop_fd);
+		mon->stop_fd = -1;
+	}
+
+	for(i = 0; i < mon->num_alarms; i++)
+	{
+		close(mon->alarms[i].fd);
+	}
+	mon->num_alarms = 0;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API moves the recorded alarm transitions, oldest first, out of the
+* monitor.
+*
+* @param	mon: alarm monitor
+* @param	events: array for the events
+* @param	max_events: size of events
+*
+* @return	number of events returned.
+*
+* @note		None.
+*
+******************************************************************************/
+int hwmon_alarm_monitor_drain(struct hwmon_alarm_monitor *mon,
+		struct alarm_event *events, int max_events)
+{
+	int n;
+
+	pthread_mutex_lock(&mon->lock);
+
+	for(n = 0; n < max_events && mon->count > 0; n++)
+	{
+		events[n] = mon->events[mon->head];
+		mon->head = (mon->head + 1) % ALARM_EVENT_RING;
+		mon->count--;
+	}
+
+	pthread_mutex_unlock(&mon->lock);
+
+	return(n);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API returns the alarms that are currently raised.
+*
+* @param	mon: alarm monitor
+* @param	alarms: array for the raised alarms
+* @param	max_alarms: size of alarms
+*
+* @return	number of raised alarms returned.
+*
+* @note		None.
+*
+******************************************************************************/
+int hwmon_alarm_monitor_active(struct hwmon_alarm_monitor *mon,
+		struct hwmon_alarm *alarms, int max_alarms)
+{
+	int i, n;
+
+	pthread_mutex_lock(&mon->lock);
+
+	for(i = 0, n = 0; i < mon->num_alarms && n < max_alarms; i++)
+	{
+		if(mon->alarms[i].state)
+		{
+			alarms[n++] = mon->alarms[i];
+		}
+	}
+
+	pthread_mutex_unlock(&mon->lock);
+
+	return(n);
+}
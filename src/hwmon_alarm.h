@@ -0,0 +1,60 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+#ifndef _PLATFORMSTATS_HWMON_ALARM_H_
+#define _PLATFORMSTATS_HWMON_ALARM_H_
+
+#include <time.h>
+#include <pthread.h>
+
+#include "hwmon.h"
+
+/************************** Constant Definitions *****************************/
+#define MAX_HWMON_ALARMS	128
+#define ALARM_EVENT_RING	256
+#define ALARM_RESCAN_MS		1000	/* re-read all alarms if no notification */
+
+/**************************** Type Definitions *******************************/
+struct hwmon_alarm {
+	int hwmon_id;
+	int fd;				/* open fd of the *_alarm attribute */
+	int state;			/* last value read, 0 or 1 */
+	char device[HWMON_NAME_LEN];
+	char attr[HWMON_ATTR_LEN];	/* e.g. in1_crit_alarm */
+	char label[HWMON_LABEL_LEN];	/* label of the sensor it belongs to */
+};
+
+struct alarm_event {
+	struct timespec monotonic;	/* CLOCK_MONOTONIC time of the transition */
+	struct timespec realtime;	/* CLOCK_REALTIME time of the transition */
+	int state;			/* 1 raised, 0 cleared */
+	char device[HWMON_NAME_LEN];
+	char attr[HWMON_ATTR_LEN];
+	char label[HWMON_LABEL_LEN];
+};
+
+struct hwmon_alarm_monitor {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	int running;
+	int stop_fd;			/* eventfd used to wake the thread on stop */
+	int num_alarms;
+	struct hwmon_alarm alarms[MAX_HWMON_ALARMS];
+	int head;
+	int count;
+	long dropped;			/* events lost because the ring was full */
+	struct alarm_event events[ALARM_EVENT_RING];
+};
+
+/************************** Function Prototypes  *****************************/
+int hwmon_alarm_monitor_start(struct hwmon_alarm_monitor *mon,
+		struct hwmon_sensor_table *tbl);
+void hwmon_alarm_monitor_stop(struct hwmon_alarm_monitor *mon);
+int hwmon_alarm_monitor_drain(struct hwmon_alarm_monitor *mon,
+		struct alarm_event *events, int max_events);
+int hwmon_alarm_monitor_active(struct hwmon_alarm_monitor *mon,
+		struct hwmon_alarm *alarms, int max_alarms);
+
+#endif /* _PLATFORMSTATS_HWMON_ALARM_H_ */
@@ -0,0 +1,386 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "hwmon.h"
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API moves a completed worker result into the visible sensor value.
+*
+* @param	sensor: hwmon sensor
+*
+* @return	None.
+*
+* @note		Internal API only. Called with the pool lock held.
+*
+******************************************************************************/
+static void hwmon_reader_adopt(struct hwmon_sensor *sensor)
+{
+	if(sensor->pending_status == 0)
+	{
+		sensor->value = sensor->pending_value;
+	}
+	sensor->status = sensor->pending_status;
+	sensor->sampled_at = sensor->pending_time;
+	hwmon_sensor_sampled(sensor);
+	sensor->stale = 0;
+	sensor->result_ready = 0;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API is the body of a reader thread. It pops queued sensors and reads
+* them outside of the pool lock, so several bus transactions are in flight
+* at the same time.
+*
+* @param	arg: reader pool
+*
+* @return	NULL.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void *hwmon_reader_thread(void *arg)
+{
+	struct hwmon_reader_pool *pool = arg;
+
+	pthread_mutex_lock(&pool->lock);
+
+	while(pool->running)
+	{
+		struct hwmon_sensor *sensor;
+		struct timespec now;
+		long value;
+		int status;
+
+		if(pool->count == 0)
+		{
+			pthread_cond_wait(&pool->work_cond, &pool->lock);
+			continue;
+		}
+
+		sensor = pool->queue[pool->head];
+		pool->head = (pool->head + 1) % MAX_HWMON_SENSORS;
+		pool->count--;
+
+		pthread_mutex_unlock(&pool->lock);
+		status = hwmon_sensor_fetch(sensor->fd, &value);
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		pthread_mutex_lock(&pool->lock);
+
+		sensor->pending_time = now;
+		sensor->pending_value = value;
+		sensor->pending_status = status;
+		sensor->result_ready = 1;
+		sensor->in_flight = 0;
+		pthread_cond_broadcast(&pool->done_cond);
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+
+	return(NULL);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API starts the reader threads of a pool. Completion waits use
+* CLOCK_MONOTONIC so that wall clock changes do not affect the timeouts.
+*
+* @param	pool: reader pool
+* @param	num_threads: number of reader threads, at most HWMON_READER_THREADS
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int hwmon_reader_start(struct hwmon_reader_pool *pool, int num_threads)
+{
+	pthread_condattr_t attr;
+	int i, ret = EINVAL;
+
+	pthread_mutex_lock(&pool->lock);
+
+	if(pool->running)
+	{
+		pthread_mutex_unlock(&pool->lock);
+		return(0);
+	}
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&pool->work_cond, &attr);
+	pthread_cond_init(&pool->done_cond, &attr);
+	pthread_condattr_destroy(&attr);
+
+	if(num_threads > HWMON_READER_THREADS)
+	{
+		num_threads = HWMON_READER_THREADS;
+	}
+
+	pool->head = 0;
+	pool->count = 0;
+	pool->num_threads = 0;
+	pool->running = 1;
+
+	for(i = 0; i < num_threads; i++)
+	{
+		ret = pthread_create(&pool->threads[i], NULL, hwmon_reader_thread, pool);
+		if(ret)
+		{
+			break;
+		}
+		pool->num_threads++;
+	}
+
+	if(pool->num_threads == 0)
+	{
+		pool->running = 0;
+		pthread_cond_destroy(&pool->work_cond);
+		pthread_cond_destroy(&pool->done_cond);
+		pthread_mutex_unlock(&pool->lock);
+		return(ret);
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API stops the reader threads of a pool. Reads already issued to the
+* kernel are allowed to finish.
+*
+* @param	pool: reader pool
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void hwmon_reader_stop(struct hwmon_reader_pool *pool)
+{
+	int i;
+
+	pthread_mutex_lock(&pool->lock);
+
+	if(!pool->running)
+	{
+		pthread_mutex_unlock(&pool->lock);
+		return;
+	}
+
+	pool->running = 0;
+	pthread_cond_broadcast(&pool->work_cond);
+	pthread_mutex_unlock(&pool->lock);
+
+	for(i = 0; i < pool->num_threads; i++)
+	{
+		pthread_join(pool->threads[i], NULL);
+	}
+
+	for(i = 0; i < pool->count; i++)
+	{
+		pool->queue[(pool->head + i) % MAX_HWMON_SENSORS]->in_flight = 0;
+	}
+
+	pool->num_threads = 0;
+	pool->count = 0;
+	pthread_cond_destroy(&pool->work_cond);
+	pthread_cond_destroy(&pool->done_cond);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads a list of sensors. Slow sensors are queued to the reader
+* threads and read concurrently while the remaining sensors are read inline.
+* It then waits for each queued sensor until its own deadline, so the call
+* takes as long as the slowest sensor rather than the sum of all of them.
+*
+* A sensor that misses its deadline is marked stale and keeps its previous
+* value. Its read is left to complete in the background, its result is
+* adopted on the next call and it is not queued again while still in flight.
+*
+* @param	pool: reader pool
+* @param	sensors: sensors to read
+* @param	num_sensors: number of sensors
+*
+* @return	number of sensors with a fresh, valid value.
+*
+* @note		None.
+*
+******************************************************************************/
+int hwmon_reader_read(struct hwmon_reader_pool *pool, struct hwmon_sensor **sensors,
+		int num_sensors)
+{
+	struct hwmon_sensor *queued[MAX_HWMON_SENSORS];
+	struct timespec now;
+	int i, num_queued, num_read, running;
+
+	num_queued = 0;
+	num_read = 0;
+
+	pthread_mutex_lock(&pool->lock);
+	running = pool->running;
+	pthread_mutex_unlock(&pool->lock);
+
+	for(i = 0; i < num_sensors && !running; i++)
+	{
+		if(sensors[i]->slow)
+		{
+			hwmon_reader_start(pool, HWMON_READER_THREADS);
+			break;
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	pthread_mutex_lock(&pool->lock);
+
+	/* sensors are read inline unless the threads are running */
+	running = pool->running;
+
+	for(i = 0; i < num_sensors && running; i++)
+	{
+		struct hwmon_sensor *sensor = sensors[i];
+
+		if(!sensor->slow)
+		{
+			continue;
+		}
+
+		if(sensor->result_ready)
+		{
+			hwmon_reader_adopt(sensor);
+		}
+
+		if(sensor->in_flight || pool->count == MAX_HWMON_SENSORS)
+		{
+			sensor->stale = 1;
+			continue;
+		}
+
+		sensor->deadline.tv_sec = now.tv_sec + sensor->timeout_ms / 1000;
+		sensor->deadline.tv_nsec = now.tv_nsec +
+			(long)(sensor->timeout_ms % 1000) * 1000000;
+		if(sensor->deadline.tv_nsec >= 1000000000)
+		{
+			sensor->deadline.tv_sec++;
+			sensor->deadline.tv_nsec -= 1000000000;
+		}
+
+		sensor->in_flight = 1;
+		pool->queue[(pool->head + pool->count) % MAX_HWMON_SENSORS] = sensor;
+		pool->count++;
+		queued[num_queued++] = sensor;
+	}
+
+	if(num_queued)
+	{
+		pthread_cond_broadcast(&pool->work_cond);
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+
+	for(i = 0; i < num_sensors; i++)
+	{
+		if(running && sensors[i]->slow)
+		{
+			continue;
+		}
+
+		if(!hwmon_sensor_read(sensors[i]))
+		{
+			num_read++;
+		}
+	}
+
+	if(num_queued == 0)
+	{
+		return(num_read);
+	}
+
+	pthread_mutex_lock(&pool->lock);
+
+	for(i = 0; i < num_queued; i++)
+	{
+		struct hwmon_sensor *sensor = queued[i];
+
+		while(!sensor->result_ready)
+		{
+			if(pthread_cond_timedwait(&pool->done_cond, &pool->lock,
+					&sensor->deadline) == ETIMEDOUT)
+			{
+				break;
+			}
+		}
+
+		if(sensor->result_ready)
+		{
+			hwmon_reader_adopt(sensor);
+			if(sensor->status == 0)
+			{
+				num_read++;
+			}
+		}
+		else
+		{
+			sensor->stale = 1;
+		}
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+
+	return(num_read);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API waits until none of the given sensors is queued or being read, so
+* that their fds can be closed safely.
+*
+* @param	pool: reader pool
+* @param	sensors: sensor array
+* @param	num_sensors: number of sensors
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void hwmon_reader_wait_idle(struct hwmon_reader_pool *pool,
+		struct hwmon_sensor *sensors, int num_sensors)
+{
+	int i;
+
+	pthread_mutex_lock(&pool->lock);
+
+	for(i = 0; i < num_sensors && pool->running; i++)
+	{
+		while(sensors[i].in_flight && pool->running)
+		{
+			pthread_cond_wait(&pool->done_cond, &pool->lock);
+		}
+		sensors[i].result_ready = 0;
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+}
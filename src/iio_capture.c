@@ -0,0 +1,569 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "iio_capture.h"
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API reads a one line attribute below an IIO device directory.
+*
+* @param	dir: IIO device sysfs directory
+* @param	attr: attribute path relative to dir
+* @param	value: buffer for the attribute value, newline stripped
+* @param	len: size of value
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int iio_read_attr(const char *dir, const char *attr, char *value, size_t len)
+{
+	char path[IIO_PATH_LEN * 2];
+	ssize_t bytes_read;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, attr);
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+	{
+		return(errno);
+	}
+
+	bytes_read = read(fd, value, len - 1);
+	close(fd);
+
+	if(bytes_read < 0)
+	{
+		return(errno);
+	}
+
+	while(bytes_read > 0 && isspace((unsigned char)value[bytes_read-1]))
+	{
+		bytes_read--;
+	}
+	value[bytes_read] = '\0';
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API writes an attribute below an IIO device directory.
+*
+* @param	dir: IIO device sysfs directory
+* @param	attr: attribute path relative to dir
+* @param	value: string to write
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int iio_write_attr(const char *dir, const char *attr, const char *value)
+{
+	char path[IIO_PATH_LEN * 2];
+	ssize_t len;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, attr);
+
+	fd = open(path, O_WRONLY | O_TRUNC | O_CLOEXEC);
+	if(fd < 0)
+	{
+		return(errno);
+	}
+
+	len = write(fd, value, strlen(value));
+	close(fd);
+
+	return(len < 0 ? errno : 0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads a floating point channel attribute such as in_voltage0_scale.
+* The channel specific attribute is tried first, then the attribute shared by
+* all channels of the same type (in_voltage_scale).
+*
+* @param	dir: IIO device sysfs directory
+* @param	channel: channel name
+* @param	suffix: attribute suffix, e.g. "scale"
+* @param	def: value returned if neither attribute exists
+*
+* @return	attribute value.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static double iio_read_channel_double(const char *dir, const char *channel,
+		const char *suffix, double def)
+{
+	char attr[IIO_NAME_LEN * 2];
+	char value[64];
+	size_t len;
+
+	snprintf(attr, sizeof(attr), "%s_%s", channel, suffix);
+	if(!iio_read_attr(dir, attr, value, sizeof(value)))
+	{
+		return(atof(value));
+	}
+
+	for(len = 0; channel[len] && !isdigit((unsigned char)channel[len]); len++)
+		;
+
+	snprintf(attr, sizeof(attr), "%.*s_%s", (int)len, channel, suffix);
+	if(!iio_read_attr(dir, attr, value, sizeof(value)))
+	{
+		return(atof(value));
+	}
+
+	return(def);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API parses a scan element type string of the form
+* [be|le]:[s|u]bits/storagebits[>>shift], e.g. "le:u16/16>>0".
+*
+* @param	type: type string
+* @param	ch: channel to fill
+*
+* @return	0 on success, EINVAL otherwise.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int iio_parse_type(const char *type, struct iio_channel *ch)
+{
+	char endian, sign;
+	unsigned int bits, storage_bits, shift;
+
+	shift = 0;
+
+	if(sscanf(type, "%ce:%c%u/%u>>%u", &endian, &sign, &bits, &storage_bits,
+			&shift) < 4)
+	{
+		return(EINVAL);
+	}
+
+	if(bits == 0 || storage_bits == 0 || storage_bits > 64 || storage_bits % 8 ||
+		bits > storage_bits)
+	{
+		return(EINVAL);
+	}
+
+	ch->big_endian = (endian == 'b');
+	ch->is_signed = (sign == 's' || sign == 'S');
+	ch->bits = bits;
+	ch->storage_bytes = storage_bits / 8;
+	ch->shift = shift;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API orders channels by scan index, which is the order of the samples
+* within a frame.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int iio_channel_compare(const void *a, const void *b)
+{
+	return(((const struct iio_channel *)a)->index -
+		((const struct iio_channel *)b)->index);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API looks up an IIO device by name.
+*
+* @param	name: device name as reported by iio:deviceN/name
+* @param	sysfs_dir: filled with the device sysfs directory
+* @param	dev_path: filled with the device character device path
+*
+* @return	0 on success, ENODEV if no device matches.
+*
+* @note		Both buffers must hold IIO_PATH_LEN bytes.
+*
+******************************************************************************/
+int iio_find_device(const char *name, char *sysfs_dir, char *dev_path)
+{
+	char dev_name[IIO_NAME_LEN];
+	struct dirent *dir;
+	DIR *d;
+
+	d = opendir(IIO_DEVICES_PATH);
+	if(!d)
+	{
+		return(errno);
+	}
+
+	while((dir = readdir(d)) != NULL)
+	{
+		if(strncmp(dir->d_name, "iio:device", 10))
+		{
+			continue;
+		}
+
+		snprintf(sysfs_dir, IIO_PATH_LEN, "%s/%.200s", IIO_DEVICES_PATH, dir->d_name);
+		if(iio_read_attr(sysfs_dir, "name", dev_name, sizeof(dev_name)) ||
+			strcmp(dev_name, name))
+		{
+			continue;
+		}
+
+		snprintf(dev_path, IIO_PATH_LEN, "/dev/%.200s", dir->d_name);
+		closedir(d);
+		return(0);
+	}
+
+	closedir(d);
+
+	return(ENODEV);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API prepares buffered capture on an IIO device. The requested scan
+* elements (and the timestamp, if the device has one) are enabled once, the
+* frame layout is derived from their index and type, and the buffer is
+* enabled. Frames are then read in bulk from the character device.
+*
+* Triggered capture only produces frames once trigger/current_trigger names
+* a trigger. The given trigger is written there; without one, an empty
+* current_trigger fails the open with ENXIO rather than leaving read()
+* waiting on frames that never come.
+*
+* Attributes that do not exist are skipped, so the capture can also run
+* against a stand-in: a directory holding scan_elements/<ch>_{en,index,type}
+* files and a regular file of packed frames in place of the device node.
+* Attributes that exist but cannot be written fail the open.
+*
+* @param	cap: capture to set up
+* @param	sysfs_dir: IIO device sysfs directory
+* @param	dev_path: character device, or regular file of frames
+* @param	trigger: trigger name for current_trigger, NULL to keep the
+*		configured one
+* @param	channels: scan element names to enable, NULL for all
+* @param	num_channels: number of names in channels
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int iio_capture_open(struct iio_capture *cap, const char *sysfs_dir,
+		const char *dev_path, const char *trigger,
+		const char *const *channels, int num_channels)
+{
+	char scan_dir[IIO_PATH_LEN + 16];
+	char attr[IIO_PATH_LEN + 32];
+	char value[64];
+	struct dirent *dir;
+	DIR *d;
+	int i, offset, align, ret;
+
+	memset(cap, 0, sizeof(*cap) - sizeof(cap->buf));
+	cap->fd = -1;
+	cap->timestamp_channel = -1;
+	snprintf(cap->sysfs_dir, sizeof(cap->sysfs_dir), "%s", sysfs_dir);
+	snprintf(cap->dev_path, sizeof(cap->dev_path), "%s", dev_path);
+
+	/* scan elements can only be changed while the buffer is disabled */
+	iio_write_attr(cap->sysfs_dir, "buffer/enable", "0");
+
+	if(trigger != NULL)
+	{
+		ret = iio_write_attr(cap->sysfs_dir, "trigger/current_trigger", trigger);
+		if(ret)
+		{
+			printf("Unable to set trigger %s on %s\n", trigger, cap->sysfs_dir);
+			return(ret);
+		}
+	}
+	else if(!iio_read_attr(cap->sysfs_dir, "trigger/current_trigger", value,
+			sizeof(value)) && value[0] == '\0')
+	{
+		printf("No trigger set in %s/trigger/current_trigger\n", cap->sysfs_dir);
+		return(ENXIO);
+	}
+
+	snprintf(scan_dir, sizeof(scan_dir), "%s/scan_elements", cap->sysfs_dir);
+	d = opendir(scan_dir);
+	if(!d)
+	{
+		ret = errno;
+		printf("Unable to open %s\n", scan_dir);
+		return(ret);
+	}
+
+	while((dir = readdir(d)) != NULL && cap->num_channels < IIO_MAX_CHANNELS)
+	{
+		struct iio_channel *ch = &cap->channels[cap->num_channels];
+		size_t len = strlen(dir->d_name);
+		int wanted;
+
+		if(len <= 3 || strcmp(dir->d_name + len - 3, "_en") ||
+			len - 3 >= IIO_NAME_LEN)
+		{
+			continue;
+		}
+
+		memset(ch, 0, sizeof(*ch));
+		memcpy(ch->name, dir->d_name, len - 3);
+
+		wanted = (channels == NULL) || !strcmp(ch->name, "in_timestamp");
+		for(i = 0; i < num_channels && !wanted; i++)
+		{
+			wanted = !strcmp(ch->name, channels[i]);
+		}
+
+		/* a channel is only enabled once its place in the frame is known */
+		if(wanted)
+		{
+			snprintf(attr, sizeof(attr), "scan_elements/%s_index", ch->name);
+			wanted = !iio_read_attr(cap->sysfs_dir, attr, value, sizeof(value));
+			ch->index = atoi(value);
+		}
+		if(wanted)
+		{
+			snprintf(attr, sizeof(attr), "scan_elements/%s_type", ch->name);
+			wanted = !iio_read_attr(cap->sysfs_dir, attr, value, sizeof(value)) &&
+				!iio_parse_type(value, ch);
+		}
+
+		snprintf(attr, sizeof(attr), "scan_elements/%s", dir->d_name);
+		if(!wanted)
+		{
+			iio_write_attr(cap->sysfs_dir, attr, "0");
+			continue;
+		}
+		if(iio_write_attr(cap->sysfs_dir, attr, "1"))
+		{
+			printf("Unable to enable %s in %s\n", ch->name, cap->sysfs_dir);
+			continue;
+		}
+
+		ch->scale = iio_read_channel_double(cap->sysfs_dir, ch->name, "scale", 1.0);
+		ch->offset = iio_read_channel_double(cap->sysfs_dir, ch->name, "offset", 0.0);
+
+		cap->num_channels++;
+	}
+
+	closedir(d);
+
+	if(cap->num_channels == 0)
+	{
+		return(ENOENT);
+	}
+
+	qsort(cap->channels, cap->num_channels, sizeof(cap->channels[0]),
+		iio_channel_compare);
+
+	/* each sample is aligned to its own storage size within the frame */
+	offset = 0;
+	align = 1;
+	for(i = 0; i < cap->num_channels; i++)
+	{
+		struct iio_channel *ch = &cap->channels[i];
+
+		if(offset % ch->storage_bytes)
+		{
+			offset += ch->storage_bytes - offset % ch->storage_bytes;
+		}
+		ch->frame_offset = offset;
+		offset += ch->storage_bytes;
+
+		if(ch->storage_bytes > align)
+		{
+			align = ch->storage_bytes;
+		}
+
+		if(!strcmp(ch->name, "in_timestamp"))
+		{
+			cap->timestamp_channel = i;
+		}
+	}
+	if(offset % align)
+	{
+		offset += align - offset % align;
+	}
+	cap->frame_size = offset;
+
+	if(cap->frame_size > IIO_MAX_FRAME_BYTES)
+	{
+		return(EINVAL);
+	}
+
+	snprintf(value, sizeof(value), "%d", IIO_BUFFER_LENGTH);
+	iio_write_attr(cap->sysfs_dir, "buffer/length", value);
+	ret = iio_write_attr(cap->sysfs_dir, "buffer/enable", "1");
+	if(ret && ret != ENOENT)
+	{
+		printf("Unable to enable the buffer of %s\n", cap->sysfs_dir);
+		return(ret);
+	}
+	cap->buffer_enabled = !ret;
+
+	cap->fd = open(cap->dev_path, O_RDONLY | O_CLOEXEC);
+	if(cap->fd < 0)
+	{
+		ret = errno;
+		printf("Unable to open %s\n", cap->dev_path);
+		iio_capture_close(cap);
+		return(ret);
+	}
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API extracts the raw value of one channel from a packed frame.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int64_t iio_decode_raw(const struct iio_channel *ch, const unsigned char *frame)
+{
+	const unsigned char *p = frame + ch->frame_offset;
+	uint64_t raw;
+	int i;
+
+	raw = 0;
+	for(i = 0; i < ch->storage_bytes; i++)
+	{
+		int byte = ch->big_endian ? i : ch->storage_bytes - 1 - i;
+
+		raw = (raw << 8) | p[byte];
+	}
+
+	raw >>= ch->shift;
+
+	if(ch->bits < 64)
+	{
+		raw &= (UINT64_C(1) << ch->bits) - 1;
+
+		if(ch->is_signed && (raw & (UINT64_C(1) << (ch->bits - 1))))
+		{
+			raw |= ~((UINT64_C(1) << ch->bits) - 1);
+		}
+	}
+
+	return((int64_t)raw);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads up to max_samples frames with a single read() and decodes
+* them. Values are converted with the channel scale and offset, and each
+* sample carries the timestamp captured by the kernel with the frame.
+*
+* @param	cap: open capture
+* @param	samples: array for the decoded samples, one per frame
+* @param	max_samples: size of samples
+*
+* @return	number of frames decoded, 0 at end of a stand-in file, or a
+*		negative errno.
+*
+* @note		None.
+*
+******************************************************************************/
+int iio_capture_read(struct iio_capture *cap, struct iio_sample *samples,
+		int max_samples)
+{
+	ssize_t len;
+	int num_frames, f, i;
+
+	if(max_samples > IIO_READ_FRAMES)
+	{
+		max_samples = IIO_READ_FRAMES;
+	}
+
+	len = read(cap->fd, cap->buf, (size_t)max_samples * cap->frame_size);
+	if(len < 0)
+	{
+		return(-errno);
+	}
+
+	num_frames = len / cap->frame_size;
+
+	for(f = 0; f < num_frames; f++)
+	{
+		const unsigned char *frame = cap->buf + f * cap->frame_size;
+
+		samples[f].timestamp = 0;
+
+		for(i = 0; i < cap->num_channels; i++)
+		{
+			struct iio_channel *ch = &cap->channels[i];
+			int64_t raw = iio_decode_raw(ch, frame);
+
+			if(i == cap->timestamp_channel)
+			{
+				samples[f].timestamp = raw;
+				samples[f].values[i] = raw;
+			}
+			else
+			{
+				samples[f].values[i] = (raw + ch->offset) * ch->scale;
+			}
+		}
+	}
+
+	return(num_frames);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API stops buffered capture and closes the device.
+*
+* @param	cap: capture
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void iio_capture_close(struct iio_capture *cap)
+{
+	if(cap->fd >= 0)
+	{
+		close(cap->fd);
+		cap->fd = -1;
+	}
+
+	if(cap->buffer_enabled)
+	{
+		iio_write_attr(cap->sysfs_dir, "buffer/enable", "0");
+		cap->buffer_enabled = 0;
+	}
+}
@@ -0,0 +1,61 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+#ifndef _PLATFORMSTATS_IIO_CAPTURE_H_
+#define _PLATFORMSTATS_IIO_CAPTURE_H_
+
+#include <stdint.h>
+
+/************************** Constant Definitions *****************************/
+#define IIO_DEVICES_PATH	"/sys/bus/iio/devices"
+#define IIO_AMS_NAME		"xilinx-ams"
+#define IIO_PATH_LEN		256
+#define IIO_NAME_LEN		64
+#define IIO_MAX_CHANNELS	32
+#define IIO_READ_FRAMES		256	/* frames fetched per read() */
+#define IIO_MAX_FRAME_BYTES	(IIO_MAX_CHANNELS * 8)
+#define IIO_BUFFER_LENGTH	1024	/* kernel buffer length in frames */
+
+/**************************** Type Definitions *******************************/
+struct iio_channel {
+	char name[IIO_NAME_LEN];	/* scan element, e.g. in_voltage0 */
+	int index;			/* position in the frame */
+	int is_signed;
+	int big_endian;
+	int bits;			/* valid bits */
+	int storage_bytes;		/* bytes used in the frame */
+	int shift;
+	int frame_offset;		/* byte offset within a frame */
+	double scale;			/* value = (raw + offset) * scale */
+	double offset;
+};
+
+struct iio_capture {
+	char sysfs_dir[IIO_PATH_LEN];	/* /sys/bus/iio/devices/iio:deviceN */
+	char dev_path[IIO_PATH_LEN];	/* /dev/iio:deviceN */
+	int fd;
+	int buffer_enabled;		/* buffer/enable was set by us */
+	int num_channels;
+	int timestamp_channel;		/* index in channels, -1 if none */
+	int frame_size;
+	struct iio_channel channels[IIO_MAX_CHANNELS];
+	unsigned char buf[IIO_READ_FRAMES * IIO_MAX_FRAME_BYTES];
+};
+
+struct iio_sample {
+	int64_t timestamp;		/* ns, from the timestamp channel */
+	double values[IIO_MAX_CHANNELS];
+};
+
+/************************** Function Prototypes  *****************************/
+int iio_find_device(const char *name, char *sysfs_dir, char *dev_path);
+int iio_capture_open(struct iio_capture *cap, const char *sysfs_dir,
+		const char *dev_path, const char *trigger,
+		const char *const *channels, int num_channels);
+int iio_capture_read(struct iio_capture *cap, struct iio_sample *samples,
+		int max_samples);
+void iio_capture_close(struct iio_capture *cap);
+
+#endif /* _PLATFORMSTATS_IIO_CAPTURE_H_ */
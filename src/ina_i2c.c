@@ -0,0 +1,273 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#include "ina_i2c.h"
+
+/************************** Constant Definitions *****************************/
+enum { INA_READ_VOLTAGE, INA_READ_CURRENT, INA_READ_POWER, INA_NUM_READS };
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API reads one 16 bit register through an SMBus word read. The chip
+* sends the MSB first, SMBus words are little endian, so the bytes are
+* swapped.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int ina_smbus_read(int fd, unsigned char reg, uint16_t *value)
+{
+	union i2c_smbus_data data;
+	struct i2c_smbus_ioctl_data args;
+
+	args.read_write = I2C_SMBUS_READ;
+	args.command = reg;
+	args.size = I2C_SMBUS_WORD_DATA;
+	args.data = &data;
+
+	if(ioctl(fd, I2C_SMBUS, &args) < 0)
+	{
+		return(errno);
+	}
+
+	*value = (uint16_t)((data.word >> 8) | (data.word << 8));
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads registers of the chip. With a plain I2C adapter, every
+* register pointer write and 2 byte read goes in a single I2C_RDWR
+* transaction, joined by repeated starts. Adapters that only speak SMBus
+* get one word read per register.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int ina_read_regs(struct ina_i2c *ina, const unsigned char *regs,
+		uint16_t *values, int num_regs)
+{
+	struct i2c_msg msgs[2 * INA_NUM_READS];
+	struct i2c_rdwr_ioctl_data xfer;
+	unsigned char ptr[INA_NUM_READS];
+	unsigned char buf[INA_NUM_READS][2];
+	int i, ret;
+
+	if(ina->use_smbus)
+	{
+		for(i = 0; i < num_regs; i++)
+		{
+			ret = ina_smbus_read(ina->fd, regs[i], &values[i]);
+			if(ret)
+			{
+				return(ret);
+			}
+		}
+		return(0);
+	}
+
+	for(i = 0; i < num_regs; i++)
+	{
+		ptr[i] = regs[i];
+		msgs[2 * i].addr = ina->addr;
+		msgs[2 * i].flags = 0;
+		msgs[2 * i].len = 1;
+		msgs[2 * i].buf = &ptr[i];
+		msgs[2 * i + 1].addr = ina->addr;
+		msgs[2 * i + 1].flags = I2C_M_RD;
+		msgs[2 * i + 1].len = 2;
+		msgs[2 * i + 1].buf = buf[i];
+	}
+
+	xfer.msgs = msgs;
+	xfer.nmsgs = 2 * num_regs;
+
+	if(ioctl(ina->fd, I2C_RDWR, &xfer) < 0)
+	{
+		return(errno);
+	}
+
+	for(i = 0; i < num_regs; i++)
+	{
+		values[i] = (uint16_t)((buf[i][0] << 8) | buf[i][1]);
+	}
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API opens an INA226 or INA260 on an i2c-dev bus. The hwmon driver
+* may stay bound to the chip; only its result registers are read. The
+* INA226 current scale follows from the calibration register the driver
+* programmed and the shunt resistance; the INA260 has fixed scales.
+*
+* @param	ina: INA device to open
+* @param	dev_path: i2c-dev node, e.g. /dev/i2c-1
+* @param	addr: 7 bit address of the chip
+* @param	chip: INA_CHIP_INA226 or INA_CHIP_INA260
+* @param	shunt_uohm: shunt resistance in uOhm, INA226 only
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int ina_i2c_open(struct ina_i2c *ina, const char *dev_path, int addr,
+		enum ina_chip chip, long shunt_uohm)
+{
+	unsigned long funcs;
+	int ret;
+
+	memset(ina, 0, sizeof(*ina));
+	snprintf(ina->dev_path, sizeof(ina->dev_path), "%s", dev_path);
+	ina->addr = addr;
+	ina->chip = chip;
+
+	if(chip == INA_CHIP_INA226 && shunt_uohm <= 0)
+	{
+		ina->fd = -1;
+		return(EINVAL);
+	}
+
+	ina->fd = open(dev_path, O_RDWR | O_CLOEXEC);
+	if(ina->fd < 0)
+	{
+		return(errno);
+	}
+
+	if(ioctl(ina->fd, I2C_FUNCS, &funcs) < 0)
+	{
+		ret = errno;
+		goto fail;
+	}
+
+	if(!(funcs & I2C_FUNC_I2C))
+	{
+		if(!(funcs & I2C_FUNC_SMBUS_READ_WORD_DATA))
+		{
+			ret = EOPNOTSUPP;
+			goto fail;
+		}
+
+		/* SMBus transfers go to the address bound to the fd */
+		if(ioctl(ina->fd, I2C_SLAVE, addr) < 0 &&
+			(errno != EBUSY || ioctl(ina->fd, I2C_SLAVE_FORCE, addr) < 0))
+		{
+			ret = errno;
+			goto fail;
+		}
+		ina->use_smbus = 1;
+	}
+
+	if(chip == INA_CHIP_INA260)
+	{
+		ina->reg_current = INA_REG_CURRENT;
+		ina->current_lsb = INA260_CURRENT_LSB;
+		ina->power_lsb = INA260_POWER_LSB;
+	}
+	else
+	{
+		unsigned char reg = INA_REG_CALIBRATION;
+		uint16_t cal;
+
+		ret = ina_read_regs(ina, &reg, &cal, 1);
+		if(ret)
+		{
+			goto fail;
+		}
+		if(cal == 0)
+		{
+			ret = ENODATA;
+			goto fail;
+		}
+
+		ina->reg_current = INA_REG_CURRENT_226;
+		ina->current_lsb = 1000.0 * INA226_CAL_CONSTANT /
+			(cal * (shunt_uohm / 1000000.0));
+		ina->power_lsb = INA226_POWER_RATIO * ina->current_lsb * 1000.0;
+	}
+
+	return(0);
+
+fail:
+	close(ina->fd);
+	ina->fd = -1;
+	return(ret);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads bus voltage, current and power of the chip in one combined
+* transaction and converts them to mV, mA and uW.
+*
+* @param	ina: opened INA device
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int ina_i2c_read(struct ina_i2c *ina)
+{
+	unsigned char regs[INA_NUM_READS];
+	uint16_t values[INA_NUM_READS];
+	int ret;
+
+	regs[INA_READ_VOLTAGE] = INA_REG_BUS_VOLTAGE;
+	regs[INA_READ_CURRENT] = ina->reg_current;
+	regs[INA_READ_POWER] = INA_REG_POWER;
+
+	ret = ina_read_regs(ina, regs, values, INA_NUM_READS);
+	if(ret)
+	{
+		return(ret);
+	}
+
+	ina->voltage_mv = (long)(values[INA_READ_VOLTAGE] * INA_BUS_VOLTAGE_LSB);
+	ina->current_ma = (long)((int16_t)values[INA_READ_CURRENT] * ina->current_lsb);
+	ina->power_uw = (long)(values[INA_READ_POWER] * ina->power_lsb);
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API closes the i2c-dev fd of the INA device.
+*
+* @param	ina: INA device
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void ina_i2c_close(struct ina_i2c *ina)
+{
+	if(ina->fd >= 0)
+	{
+		close(ina->fd);
+	}
+	ina->fd = -1;
+}
@@ -0,0 +1,52 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+#ifndef _PLATFORMSTATS_INA_I2C_H_
+#define _PLATFORMSTATS_INA_I2C_H_
+
+/************************** Constant Definitions *****************************/
+#define INA_I2C_PATH_LEN	64
+
+/* Register pointers common to the INA226 and INA260 */
+#define INA_REG_CURRENT		0x01	/* INA260; shunt voltage on the INA226 */
+#define INA_REG_BUS_VOLTAGE	0x02
+#define INA_REG_POWER		0x03
+#define INA_REG_CURRENT_226	0x04
+#define INA_REG_CALIBRATION	0x05
+
+#define INA_BUS_VOLTAGE_LSB	1.25	/* mV, both chips */
+#define INA260_CURRENT_LSB	1.25	/* mA */
+#define INA260_POWER_LSB	10000.0	/* uW */
+#define INA226_CAL_CONSTANT	0.00512
+#define INA226_POWER_RATIO	25	/* power LSB / current LSB */
+
+/**************************** Type Definitions *******************************/
+enum ina_chip { INA_CHIP_INA226, INA_CHIP_INA260 };
+
+/*
+ * An INA226 or INA260 read through i2c-dev, bypassing the hwmon driver.
+ * Values are in the units of the hwmon attributes they replace.
+ */
+struct ina_i2c {
+	char dev_path[INA_I2C_PATH_LEN];	/* /dev/i2c-N */
+	int fd;
+	int addr;
+	enum ina_chip chip;
+	int use_smbus;			/* adapter lacks plain I2C, e.g. i2c-stub */
+	unsigned char reg_current;	/* register holding the current */
+	double current_lsb;		/* mA per bit */
+	double power_lsb;		/* uW per bit */
+	long power_uw;
+	long current_ma;
+	long voltage_mv;
+};
+
+/************************** Function Prototypes  *****************************/
+int ina_i2c_open(struct ina_i2c *ina, const char *dev_path, int addr,
+		enum ina_chip chip, long shunt_uohm);
+int ina_i2c_read(struct ina_i2c *ina);
+void ina_i2c_close(struct ina_i2c *ina);
+
+#endif /* _PLATFORMSTATS_INA_I2C_H_ */
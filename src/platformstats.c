@@ -11,12 +11,123 @@
 #include <unistd.h>
 #include <dirent.h>
 #include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <sys/sysinfo.h>
 
 #include "platformstats.h"
 #include "utils.h"
+#include "hwmon.h"
+#include "power_sampler.h"
+#include "iio_capture.h"
+#include "hwmon_alarm.h"
+#include "rail_model.h"
+#include "powercap.h"
+#include "supply.h"
+#include "devfreq.h"
+#include "thermal.h"
+#include "throttle.h"
+#include "cpu_power.h"
+#include "proc_power.h"
+#include "runtime_pm.h"
+#include "wakeup.h"
+#include "ams_regs.h"
+#include "ina_i2c.h"
+#include "procfs.h"
+#include "context.h"
+
+/************************** Variable Definitions *****************************/
+/*
+ * State of the print APIs. The collectors live in the context the print
+ * APIs share, whose deltas are those since the previous print call; the
+ * context and the buffers below are not locked, so the print APIs,
+ * load_rail_model, open_ina_i2c, load_ams_registers and calibrate_cpu_power
+ * are called from one thread only. Threads collecting concurrently use
+ * contexts of their own, or ps_context_publish and ps_snapshot_latest on a
+ * shared one.
+ */
+static struct iio_capture ams_capture;
+static struct iio_sample ams_samples[IIO_READ_FRAMES];
+
+static pthread_once_t print_ctx_once = PTHREAD_ONCE_INIT;
+static struct ps_context *print_ctx;
+
+static struct ps_snapshot util_snap[2];
+static struct ps_snapshot print_snap;
 
 /************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API creates the context the print APIs collect through.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void create_print_context(void)
+{
+	print_ctx = ps_context_create();
+}
+
+/*****************************************************************************/
+/*
+*
+* This API returns the context the print APIs collect through, creating it
+* on first use.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static struct ps_context *get_print_context(void)
+{
+	pthread_once(&print_ctx_once, create_print_context);
+	if(print_ctx == NULL)
+	{
+		printf("Unable to allocate a platformstats context\n");
+	}
+
+	return(print_ctx);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API prints why a value of an hwmon backed snapshot group is missing.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void print_sensor_status(const char *device, const char *attr, int status)
+{
+	if(status == ENOENT)
+	{
+		printf("unable to find %s/%s_input\n", device, attr);
+	}
+	else
+	{
+		printf("unable to read %s/%s_input. Returned error: %d\n", device, attr,
+			status);
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API formats a CLOCK_REALTIME timestamp of a snapshot as local time.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void format_time_ns(long long time_ns, char *buf, size_t len)
+{
+	time_t sec = time_ns / 1000000000LL;
+	struct tm tm;
+
+	localtime_r(&sec, &tm);
+	strftime(buf, len, "%Y-%m-%d %H:%M:%S", &tm);
+}
+
 /*****************************************************************************/
 /*
 *
@@ -123,6 +234,11 @@ double calculate_load(struct cpustat *prev, struct cpustat *curr)
     	total_delta = (double) total_curr - (double) total_prev;
     	idle_delta = (double) idle_curr - (double) idle_prev;
 
+	if(total_delta <= 0)
+	{
+		return(0);
+	}
+
 	cpu_util = (1000 * (total_delta - idle_delta) / total_delta + 1) / 10;
 	
 	return (cpu_util);
@@ -131,9 +247,9 @@ double calculate_load(struct cpustat *prev, struct cpustat *curr)
 /*****************************************************************************/
 /*
 *
-* This API identifies the number of configured CPUs in the system. For each
-* active CPU it reads the CPU stats by calling get_stats and then calculates
-* load.
+* This API collects the CPU counters of every configured CPU twice, 1s
+* apart, and prints the load of each CPU over that second. CPUs that are
+* offline are skipped.
 *
 * @param	verbose_flag: Enable verbose prints on stdout
 *
@@ -144,45 +260,44 @@ double calculate_load(struct cpustat *prev, struct cpustat *curr)
 ******************************************************************************/
 int print_cpu_utilization(int verbose_flag)
 {
-	int num_cpus_conf, cpu_id;
-	struct cpustat *st0_0, *st0_1;
-
-	num_cpus_conf= get_nprocs_conf();
-	cpu_id=0;
+	struct ps_snapshot *st0 = &util_snap[0], *st1 = &util_snap[1];
+	struct ps_context *ctx;
+	int cpu_id;
 
-	st0_0 = malloc(num_cpus_conf * sizeof (struct cpustat));
-	st0_1 = malloc(num_cpus_conf * sizeof (struct cpustat));
-	
-	if(!st0_0 || !st0_1)
+	ctx = get_print_context();
+	if(ctx == NULL)
 	{
-		printf("Unable to allocate memory, malloc failed");
-		return(errno);
+		return(ENOMEM);
 	}
 
+	ps_snapshot_collect(ctx, st0, PS_SNAP_CPU_UTIL);
+	sleep(1);
+	ps_snapshot_collect(ctx, st1, PS_SNAP_CPU_UTIL);
+
 	printf("\nCPU Utilization\n");
-	for(; cpu_id < num_cpus_conf; cpu_id++)
+	for(cpu_id = 0; cpu_id < st1->num_cpus; cpu_id++)
 	{
-		st0_0[cpu_id].total_util = 0;
-		st0_1[cpu_id].total_util = 0;
+		if(st1->cpus[cpu_id].stat_status)
+		{
+			if(st1->cpus[cpu_id].stat_status != ENOENT)
+			{
+				printf("Unable to read /proc/stat. Returned errono: %d\n",
+					st1->cpus[cpu_id].stat_status);
+				return(st1->cpus[cpu_id].stat_status);
+			}
+			continue;
+		}
 
-		get_stats(&st0_0[cpu_id],cpu_id);
-	        sleep(1);
-		get_stats(&st0_1[cpu_id],cpu_id);
-		st0_1[cpu_id].total_util = calculate_load(&st0_0[cpu_id],&st0_1[cpu_id]);
-	
 		if(verbose_flag)
 		{
 			printf("cpu_id=%d\nStats at t0\n",cpu_id);
-			print_cpu_stats(&st0_0[cpu_id],cpu_id);
+			print_cpu_stats(&st0->cpus[cpu_id].stat,cpu_id);
 			printf("Stats at t1 after 1s\n");
-			print_cpu_stats(&st0_1[cpu_id],cpu_id);
+			print_cpu_stats(&st1->cpus[cpu_id].stat,cpu_id);
 		}
-		printf("CPU%d\t:     %lf%%\n",cpu_id,st0_1[cpu_id].total_util);
+		printf("CPU%d\t:     %lf%%\n",cpu_id,st1->cpus[cpu_id].stat.total_util);
 	}
 
-	free(st0_0);
-	free(st0_1);
-
 	return(0);
 }
 /*****************************************************************************/
@@ -242,8 +357,8 @@ int get_cpu_frequency(int cpu_id, float* cpu_freq)
 /*****************************************************************************/
 /*
 *
-* This API identifies the number of configured CPUs in the system. For each
-* active CPU it reads the CPU frequency by calling get_cpu_freq and prints it.
+* This API prints the current frequency of every configured CPU, taken from
+* cpufreq or, without it, from /proc/cpuinfo.
 *
 * @param	verbose_flag: Enable verbose prints on stdout
 *
@@ -254,17 +369,281 @@ int get_cpu_frequency(int cpu_id, float* cpu_freq)
 ******************************************************************************/
 int print_cpu_frequency(int verbose_flag)
 {
-	int num_cpus_conf, cpu_id;
-	float cpu_freq;
+	struct ps_context *ctx;
+	int cpu_id;
 
-	num_cpus_conf= get_nprocs_conf();
-	cpu_id=0;
+	ctx = get_print_context();
+	if(ctx == NULL)
+	{
+		return(ENOMEM);
+	}
+
+	ps_snapshot_collect(ctx, &print_snap, PS_SNAP_CPU_FREQ);
 
 	printf("\nCPU Frequency\n");
-	for(; cpu_id < num_cpus_conf; cpu_id++)
+	for(cpu_id = 0; cpu_id < print_snap.num_cpus; cpu_id++)
+	{
+		if(print_snap.cpus[cpu_id].freq_status)
+		{
+			printf("CPU%d\t:    unable to read frequency\n",cpu_id);
+			continue;
+		}
+		printf("CPU%d\t:    %f MHz\n",cpu_id,print_snap.cpus[cpu_id].freq_mhz);
+	}
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API prints the current frequency of every devfreq device (DDR
+* controller, GPU, interconnect, ...) and, where the kernel provides
+* trans_stat, the share of time spent at each frequency since the previous
+* call along with the number of frequency transitions.
+*
+* @param	verbose_flag: Enable verbose prints on stdout
+*
+* @return	Error code.
+*
+* @note		None.
+*
+******************************************************************************/
+int print_devfreq_info(int verbose_flag)
+{
+	struct ps_context *ctx;
+	int i, j;
+
+	ctx = get_print_context();
+	if(ctx == NULL)
+	{
+		return(ENOMEM);
+	}
+
+	ps_snapshot_collect(ctx, &print_snap, PS_SNAP_DEVFREQ);
+
+	printf("\nDevice Frequency\n");
+	if(print_snap.num_devfreq == 0)
+	{
+		printf("no devfreq device found under %s\n", DEVFREQ_CLASS_PATH);
+		return(0);
+	}
+
+	for(i = 0; i < print_snap.num_devfreq; i++)
+	{
+		struct ps_devfreq *dev = &print_snap.devfreq[i];
+
+		if(dev->status)
+		{
+			printf("%s\t:    unable to read cur_freq\n", dev->name);
+			continue;
+		}
+
+		printf("%s\t:    %.1f MHz", dev->name, dev->cur_freq / 1e6);
+		if(dev->governor[0])
+		{
+			printf(" (%s)", dev->governor);
+		}
+		printf("\n");
+
+		if(dev->window_ms == 0)
+		{
+			continue;
+		}
+
+		printf("\tresidency over %llu ms, %lu transitions:", dev->window_ms,
+			dev->transitions);
+		for(j = 0; j < dev->num_states; j++)
+		{
+			struct ps_devfreq_state *state = &dev->states[j];
+
+			if(state->delta_ms == 0 && !verbose_flag)
+			{
+				continue;
+			}
+
+			printf(" %.0f MHz %.1f%%", state->freq / 1e6,
+				100.0 * state->delta_ms / dev->window_ms);
+		}
+		printf("\n");
+	}
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API prints the temperature of every thermal zone with its headroom to
+* the nearest passive, hot or critical trip point, i.e. how far the zone is
+* from being throttled, followed by the state of every cooling device.
+* Verbose mode lists every trip point.
+*
+* @param	verbose_flag: Enable verbose prints on stdout
+*
+* @return	Error code.
+*
+* @note		None.
+*
+******************************************************************************/
+int print_thermal_info(int verbose_flag)
+{
+	struct ps_context *ctx;
+	int i, j;
+
+	ctx = get_print_context();
+	if(ctx == NULL)
+	{
+		return(ENOMEM);
+	}
+
+	ps_snapshot_collect(ctx, &print_snap, PS_SNAP_THERMAL);
+
+	printf("\nThermal Zones\n");
+	if(print_snap.num_zones == 0)
+	{
+		printf("no thermal zone found under %s\n", THERMAL_CLASS_PATH);
+	}
+
+	for(i = 0; i < print_snap.num_zones; i++)
+	{
+		struct ps_thermal_zone *zone = &print_snap.zones[i];
+
+		if(zone->status)
+		{
+			printf("thermal_zone%d %s\t:    unable to read temp\n",
+				zone->id, zone->type);
+			continue;
+		}
+
+		printf("thermal_zone%d %s\t:    %.1f C", zone->id, zone->type,
+			zone->temp / 1000.0);
+		if(zone->has_trip)
+		{
+			struct ps_trip *trip = &zone->trips[zone->nearest];
+
+			printf(", headroom %.1f C to %s trip at %.1f C%s",
+				zone->headroom / 1000.0, trip->type,
+				trip->temp / 1000.0,
+				zone->headroom < 0 ? " (CROSSED)" : "");
+		}
+		printf("\n");
+
+		if(!verbose_flag)
+		{
+			continue;
+		}
+
+		for(j = 0; j < zone->num_trips; j++)
+		{
+			printf("\ttrip_point_%d\t:    %.1f C %s\n", j,
+				zone->trips[j].temp / 1000.0, zone->trips[j].type);
+		}
+	}
+
+	if(print_snap.num_cooling)
+	{
+		printf("\nCooling Devices\n");
+	}
+
+	for(i = 0; i < print_snap.num_cooling; i++)
+	{
+		struct ps_cooling_device *cdev = &print_snap.cooling[i];
+
+		if(cdev->status)
+		{
+			printf("cooling_device%d %s\t:    unable to read cur_state\n",
+				cdev->id, cdev->type);
+			continue;
+		}
+
+		printf("cooling_device%d %s\t:    state %ld of %ld\n", cdev->id,
+			cdev->type, cdev->cur_state, cdev->max_state);
+	}
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API samples CPU frequency and thermal state, then prints the thermal
+* throttling episodes that ended since the previous call with their start
+* time, duration and the frequency lost to them, followed by the episode in
+* progress if any. It must be called periodically; each call is one sample.
+*
+* @param	verbose_flag: Enable verbose prints on stdout
+*
+* @return	Error code.
+*
+* @note		None.
+*
+******************************************************************************/
+int print_throttle_info(int verbose_flag)
+{
+	struct ps_throttle *thr = &print_snap.throttle;
+	struct ps_context *ctx;
+	int i;
+
+	ctx = get_print_context();
+	if(ctx == NULL)
+	{
+		return(ENOMEM);
+	}
+
+	ps_snapshot_collect(ctx, &print_snap, PS_SNAP_THROTTLE);
+
+	printf("\nThrottling\n");
+	if(thr->status)
+	{
+		printf("no cpufreq policy found under %s\n", CPUFREQ_PATH);
+		return(0);
+	}
+
+	if(verbose_flag)
+	{
+		for(i = 0; i < thr->num_policies; i++)
+		{
+			struct ps_cpufreq_policy *policy = &thr->policies[i];
+
+			if(policy->status)
+			{
+				printf("policy%d\t:    unable to read frequency\n", policy->id);
+				continue;
+			}
+			printf("policy%d\t:    %ld MHz, limit %ld MHz, user limit %ld MHz, max %ld MHz\n",
+				policy->id, policy->cur_khz / 1000, policy->cap_khz / 1000,
+				policy->user_khz / 1000, policy->max_khz / 1000);
+		}
+	}
+
+	for(i = 0; i < thr->num_episodes; i++)
+	{
+		struct ps_throttle_episode *ep = &thr->episodes[i];
+		char timestr[32];
+
+		format_time_ns(ep->start_ns, timestr, sizeof(timestr));
+
+		printf("%s throttled for %.1f s, lost %.2f GHz*s, down to %ld MHz (%s)\n",
+			timestr, ep->duration, ep->lost_ghz_s, ep->min_khz / 1000,
+			ep->cause);
+	}
+
+	if(thr->active)
+	{
+		printf("throttling for %.1f s, lost %.2f GHz*s, down to %ld MHz (%s)\n",
+			thr->current.duration, thr->current.lost_ghz_s,
+			thr->current.min_khz / 1000, thr->current.cause);
+	}
+	else if(thr->num_episodes == 0)
+	{
+		printf("not throttled\n");
+	}
+
+	if(verbose_flag)
 	{
-		get_cpu_frequency(cpu_id,&cpu_freq);
-		printf("CPU%d\t:    %f MHz\n",cpu_id,cpu_freq);
+		printf("%lu episodes, %.2f GHz*s lost in total\n",
+			thr->total_episodes, thr->total_lost_ghz_s);
 	}
 
 	return(0);
@@ -345,19 +724,23 @@ int get_ram_memory_utilization(unsigned long* MemTotal, unsigned long* MemFree,
 ******************************************************************************/
 int print_ram_memory_utilization(int verbose_flag)
 {
-	unsigned long MemTotal=0, MemFree=0, MemAvailable=0;
-	int mem_util_ret;
+	struct ps_memory *mem = &print_snap.mem;
+	struct ps_context *ctx;
 
-	mem_util_ret = 0;
+	ctx = get_print_context();
+	if(ctx == NULL)
+	{
+		return(ENOMEM);
+	}
 
-	mem_util_ret = get_ram_memory_utilization(&MemTotal, &MemFree, &MemAvailable);
+	ps_snapshot_collect(ctx, &print_snap, PS_SNAP_MEMORY);
 
 	printf("\nRAM Utilization\n");
-	printf("MemTotal      :     %ld kB\n",MemTotal);
-	printf("MemFree	      :     %ld kB\n", MemFree);
-	printf("MemAvailable  :     %ld kB\n\n", MemAvailable);
+	printf("MemTotal      :     %ld kB\n",mem->mem_total);
+	printf("MemFree	      :     %ld kB\n", mem->mem_free);
+	printf("MemAvailable  :     %ld kB\n\n", mem->mem_available);
 
-	return(mem_util_ret);
+	return(mem->mem_status);
 
 }
 
@@ -419,18 +802,22 @@ int get_cma_utilization(unsigned long* CmaTotal, unsigned long* CmaFree)
 ******************************************************************************/
 int print_cma_utilization(int verbose_flag)
 {
-	unsigned long CmaTotal=0, CmaFree=0;
-	int cma_util_ret;
+	struct ps_memory *mem = &print_snap.mem;
+	struct ps_context *ctx;
 
-	cma_util_ret = 0;
+	ctx = get_print_context();
+	if(ctx == NULL)
+	{
+		return(ENOMEM);
+	}
 
-	cma_util_ret = get_cma_utilization(&CmaTotal, &CmaFree);
+	ps_snapshot_collect(ctx, &print_snap, PS_SNAP_MEMORY);
 
 	printf("\nCMA Mem Utilization\n");
-	printf("CmaTotal   :     %ld kB\n",CmaTotal);
-	printf("CmaFree    :     %ld kB\n", CmaFree);
+	printf("CmaTotal   :     %ld kB\n",mem->cma_total);
+	printf("CmaFree    :     %ld kB\n", mem->cma_free);
 
-	return(cma_util_ret);
+	return(mem->cma_status);
 
 }
 
@@ -495,18 +882,22 @@ int get_swap_memory_utilization(unsigned long* SwapTotal, unsigned long* SwapFre
 ******************************************************************************/
 int print_swap_memory_utilization(int verbose_flag)
 {
-	unsigned long SwapTotal=0, SwapFree=0;
-	int mem_util_ret;
+	struct ps_memory *mem = &print_snap.mem;
+	struct ps_context *ctx;
 
-	mem_util_ret = 0;
+	ctx = get_print_context();
+	if(ctx == NULL)
+	{
+		return(ENOMEM);
+	}
 
-	mem_util_ret = get_swap_memory_utilization(&SwapTotal, &SwapFree);
+	ps_snapshot_collect(ctx, &print_snap, PS_SNAP_MEMORY);
 
 	printf("\nSwap Mem Utilization\n");
-	printf("SwapTotal    :    %ld kB\n",SwapTotal);
-	printf("SwapFree     :    %ld kB\n\n",SwapFree);
+	printf("SwapTotal    :    %ld kB\n",mem->swap_total);
+	printf("SwapFree     :    %ld kB\n\n",mem->swap_free);
 
-	return(mem_util_ret);
+	return(mem->swap_status);
 
 }
 
@@ -537,6 +928,7 @@ int read_sysfs_entry(char* filename, char* value)
 	}
 
 	fscanf(fp,"%s",value);
+	fclose(fp);
 
 	return(0);
 
@@ -584,8 +976,11 @@ int count_hwmon_reg_devices()
 /*****************************************************************************/
 /*
 *
-* This API returns hwmon_id of the specified device:
+* This API returns hwmon_id of the specified device. The lookup is served from
+* the hwmon index of the print context, which is only rebuilt when an hwmon
+* device is added or removed.
 *
+* @param        verbose_flag: Enable verbose prints
 * @param        name: device name for which hwmon_id needs to be identified
 *
 * @return       hwmon_id
@@ -595,43 +990,79 @@ int count_hwmon_reg_devices()
 ******************************************************************************/
 int get_device_hwmon_id(int verbose_flag, char* name)
 {
-	//find number of hwmon devices listed under
-	int num_hwmon_devices,hwmon_id;
-	char hwmon_id_str[50];
-	char *device_name;
-	char *filename;
+	struct hwmon_index *idx;
+	struct hwmon_device *dev;
+	struct ps_context *ctx;
+	int i;
 
-	filename = malloc(255);
-	device_name = malloc(255);
+	ctx = get_print_context();
+	if(ctx == NULL)
+	{
+		return(-1);
+	}
 
-	hwmon_id=-1;
+	idx = &ctx->hwmon;
+	dev = hwmon_index_lookup(idx, name);
 
-	num_hwmon_devices = count_hwmon_reg_devices();
+	if(verbose_flag)
+	{
+		for(i = 0; i < idx->num_devices; i++)
+		{
+			printf("hwmon%d device_name = %s\n",idx->devices[i].id,
+				idx->devices[i].name);
+		}
+	}
 
-	for(hwmon_id = 0; hwmon_id < num_hwmon_devices; hwmon_id++)
+	if(dev == NULL)
 	{
-		sprintf(hwmon_id_str,"%d",hwmon_id);
-		strcpy(filename,"/sys/class/hwmon/hwmon");
-		strcat(filename,hwmon_id_str);
-		strcat(filename,"/name");
+		return(-1);
+	}
 
-		read_sysfs_entry(filename,device_name);
+	return(dev->id);
+}
 
-		if(!strcmp(name,device_name))
-		{
-			return(hwmon_id);
-		}
+/*****************************************************************************/
+/*
+*
+* This API opens the SOM power monitor directly on its I2C bus, so that
+* print_ina260_power_info reads its registers in one I2C transaction instead
+* of going through the hwmon driver. The monitor is given as
+*
+*	<i2c-dev node>,<address>[,ina260]
+*	<i2c-dev node>,<address>,ina226,<shunt uOhm>
+*
+* e.g. /dev/i2c-1,0x40.
+*
+* @param        spec: monitor specification
+*
+* @return       Error code.
+*
+* @note         None.
+*
+******************************************************************************/
+int open_ina_i2c(const char *spec)
+{
+	struct ps_context *ctx;
+	int ret;
 
-		if(verbose_flag)
-		{
-			printf("filename %s\n",filename);
-			printf("device_name = %s\n",device_name);
-		}
+	ctx = get_print_context();
+	if(ctx == NULL)
+	{
+		return(ENOMEM);
+	}
+
+	ret = ps_context_open_ina_i2c(ctx, spec);
+	if(ret && ctx->ina.dev_path[0] == '\0')
+	{
+		printf("Invalid INA I2C device %s\n", spec);
+	}
+	else if(ret)
+	{
+		printf("Unable to open %s address 0x%02x. Returned error: %d\n",
+			ctx->ina.dev_path, ctx->ina.addr, ret);
 	}
 
-	free(filename);
-	free(device_name);
-	return(-1);
+	return(ret);
 }
 
 /*****************************************************************************/
@@ -651,83 +1082,1071 @@ int get_device_hwmon_id(int verbose_flag, char* name)
 ******************************************************************************/
 int print_ina260_power_info(int verbose_flag)
 {
-	int hwmon_id;
-	long total_power, total_current, total_voltage;
-	FILE *fp;
-	char filename[255];
-	char hwmon_id_str[255];
+	static const char *const units[PS_SOM_NUM] = { "mW", "mA", "mV" };
+	static const char *const names[PS_SOM_NUM] = {
+		"SOM total power    ", "SOM total current    ", "SOM total voltage\t"
+	};
+	struct ps_context *ctx;
+	int i;
+
+	ctx = get_print_context();
+	if(ctx == NULL)
+	{
+		return(ENOMEM);
+	}
 
-	char base_filepath[] = "/sys/class/hwmon/hwmon";
+	if(verbose_flag && !ctx->ina_active)
+	{
+		get_device_hwmon_id(verbose_flag,PS_SOM_DEVICE);
+	}
 
-	hwmon_id = get_device_hwmon_id(verbose_flag,"ina260_u14");
+	ps_snapshot_collect(ctx, &print_snap, PS_SNAP_SOM_POWER);
 
 	printf("\nPower Utilization\n");
-	if(hwmon_id == -1)
+	if(print_snap.som_status[PS_SOM_POWER] == ENODEV)
 	{
 		printf("no hwmon device found for ina260_u14 under /sys/class/hwmon\n");
 		return(0);
 	}
 
-	//printf("hwmon device found, device_id is %d\n",hwmon_id);
-
-	sprintf(hwmon_id_str,"%d",hwmon_id);
-	strcat(base_filepath,hwmon_id_str);
-
-	//if "power" file exists then read power value
-	strcpy(filename,base_filepath);
-	strcat(filename,"/power1_input");
-
-	fp = fopen(filename,"r");
-	if(fp == NULL)
+	if(ctx->ina_active && print_snap.som_status[PS_SOM_POWER])
 	{
-		printf("unable to open %s\n",filename);
+		printf("unable to read %s address 0x%02x. Returned error: %d\n",
+			ctx->ina.dev_path, ctx->ina.addr,
+			print_snap.som_status[PS_SOM_POWER]);
+		return(print_snap.som_status[PS_SOM_POWER]);
 	}
 
-	fscanf(fp,"%ld",&total_power);
-	fclose(fp);
+	for(i = 0; i < PS_SOM_NUM; i++)
+	{
+		if(print_snap.som_status[i])
+		{
+			print_sensor_status(PS_SOM_DEVICE, ps_som_attrs[i],
+				print_snap.som_status[i]);
+		}
+		printf("%s:     %ld %s\n", names[i], i == PS_SOM_POWER ?
+			print_snap.som[i] / 1000 : print_snap.som[i], units[i]);
+	}
 
-	printf("SOM total power    :     %ld mW\n",(total_power)/1000);
+	return(0);
+}
 
-	//if "curr" file exists then read curr value
-	strcpy(filename,base_filepath);
-	strcat(filename,"/curr1_input");
+/*****************************************************************************/
+/*
+*
+* This API loads an AMS register file and maps the register block, so that
+* print_sysmon_power_info reads the AMS registers directly instead of the
+* ams hwmon device. Each sysmon value is taken from the register named after
+* its hwmon attribute (temp1, in1, ...).
+*
+* @param        path: AMS register file
+*
+* @return       Error code.
+*
+* @note         None.
+*
+******************************************************************************/
+int load_ams_registers(const char *path)
+{
+	struct ps_context *ctx;
+	int ret;
+
+	ctx = get_print_context();
+	if(ctx == NULL)
+	{
+		return(ENOMEM);
+	}
+
+	ret = ps_context_load_ams_registers(ctx, path);
+	if(ret && !ctx->ams.loaded)
+	{
+		printf("Unable to load AMS register map %s. Returned error: %d\n",
+			path, ret);
+	}
+	else if(ret)
+	{
+		printf("Unable to map AMS registers from %s. Returned error: %d\n",
+			ctx->ams.dev_path, ret);
+	}
+
+	return(ret);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API prints the following information from sysmon driver:
+* in1_input: Voltage input value.
+* curr1_input: Current input value.
+* power1_input: Instantaneous power use
+*
+* @param        verbose_flag: Enable verbose prints
+*
+* @return       Error code.
+*
+* @note         None.
+*
+******************************************************************************/
+int print_sysmon_power_info(int verbose_flag)
+{
+	long LPD_TEMP, FPD_TEMP, PL_TEMP;
+	long VCC_PSPLL, PL_VCCINT, VOLT_DDRS, VCC_PSINTFP, VCC_PS_FPD;
+	long PS_IO_BANK_500, VCC_PS_GTR, VTT_PS_GTR;
+	long *value = print_snap.sysmon;
+	struct ps_context *ctx;
+	int i;
+
+	ctx = get_print_context();
+	if(ctx == NULL)
+	{
+		return(ENOMEM);
+	}
+
+	if(verbose_flag && !ctx->ams_active)
+	{
+		get_device_hwmon_id(verbose_flag,PS_SYSMON_DEVICE);
+	}
+
+	ps_snapshot_collect(ctx, &print_snap, PS_SNAP_SYSMON);
+
+	if(print_snap.sysmon_status[0] == ENODEV)
+	{
+		printf("no hwmon device found for ams under /sys/class/hwmon\n");
+		return(0);
+	}
+
+	for(i = 0; i < PS_SYSMON_NUM; i++)
+	{
+		if(!print_snap.sysmon_status[i])
+		{
+			continue;
+		}
+		if(ctx->ams_active)
+		{
+			printf("no register %s in the AMS register map\n", ps_sysmon_attrs[i]);
+		}
+		else
+		{
+			print_sensor_status(PS_SYSMON_DEVICE, ps_sysmon_attrs[i],
+				print_snap.sysmon_status[i]);
+		}
+	}
+
+	LPD_TEMP = value[PS_SYSMON_LPD_TEMP];
+	FPD_TEMP = value[PS_SYSMON_FPD_TEMP];
+	PL_TEMP = value[PS_SYSMON_PL_TEMP];
+	VCC_PSPLL = value[PS_SYSMON_VCC_PSPLL];
+	PL_VCCINT = value[PS_SYSMON_PL_VCCINT];
+	VOLT_DDRS = value[PS_SYSMON_VOLT_DDRS];
+	VCC_PSINTFP = value[PS_SYSMON_VCC_PSINTFP];
+	VCC_PS_FPD = value[PS_SYSMON_VCC_PS_FPD];
+	PS_IO_BANK_500 = value[PS_SYSMON_PS_IO_BANK_500];
+	VCC_PS_GTR = value[PS_SYSMON_VCC_PS_GTR];
+	VTT_PS_GTR = value[PS_SYSMON_VTT_PS_GTR];
+
+	printf("AMS CTRL\n");
+	printf("System PLLs voltage measurement, VCC_PSLL   		:     %ld mV\n",VCC_PSPLL);
+	printf("PL internal voltage measurement, VCC_PSBATT 		:     %ld mV\n",PL_VCCINT);
+	printf("Voltage measurement for six DDR I/O PLLs, VCC_PSDDR_PLL :     %ld mV\n",VOLT_DDRS);
+	printf("VCC_PSINTFP_DDR voltage measurement         		:     %ld mV\n\n",VCC_PSINTFP);
+
+	printf("PS Sysmon\n");
+	printf("LPD temperature measurement 		    		:     %ld C\n",(LPD_TEMP)/1000);
+	printf("FPD temperature measurement (REMOTE)  		    		:     %ld C\n",(FPD_TEMP)/1000);
+	printf("VCC PS FPD voltage measurement (supply 2)   		:     %ld mV\n",VCC_PS_FPD);
+	printf("PS IO Bank 500 voltage measurement (supply 6)		:     %ld mV\n",PS_IO_BANK_500);
+	printf("VCC PS GTR voltage   					:     %ld mV\n",VCC_PS_GTR);
+	printf("VTT PS GTR voltage    					:     %ld mV\n\n",VTT_PS_GTR);
+
+	printf("PL Sysmon\n");
+	printf("PL temperature    					:     %ld C\n",(PL_TEMP)/1000);
+
+	return(0);
+}
+/*****************************************************************************/
+/*
+*
+* This API prints every *_input sensor of every hwmon device registered under
+* /sys/class/hwmon. Sensors are enumerated once and read in a single pass, so
+* no board specific attribute names are required. Sensors whose chip has not
+* refreshed yet are reported with their cached value; verbose mode prints the
+* age of each value.
+*
+* @param        verbose_flag: Enable verbose prints
+*
+* @return       Error code.
+*
+* @note         None.
+*
+******************************************************************************/
+int print_hwmon_sensor_info(int verbose_flag)
+{
+	struct ps_context *ctx;
+	int i;
+
+	ctx = get_print_context();
+	if(ctx == NULL)
+	{
+		return(ENOMEM);
+	}
+
+	ps_snapshot_collect(ctx, &print_snap, PS_SNAP_HWMON);
+
+	printf("\nHwmon Sensors\n");
+	if(print_snap.num_sensors == 0)
+	{
+		printf("no hwmon sensors found under /sys/class/hwmon\n");
+		return(0);
+	}
+
+	for(i = 0; i < print_snap.num_sensors; i++)
+	{
+		struct ps_hwmon_sensor *sensor = &print_snap.sensors[i];
+
+		if(verbose_flag)
+		{
+			printf("hwmon%d/%s_input (age %ld ms)\t", sensor->hwmon_id,
+				sensor->attr, sensor->age_ms);
+		}
+
+		if(sensor->status)
+		{
+			printf("%-16s %-24s:     unavailable (%d)\n", sensor->device,
+				sensor->label, sensor->status);
+			continue;
+		}
+
+		printf("%-16s %-24s:     %ld %s%s\n", sensor->device, sensor->label,
+			sensor->value, sensor->unit, sensor->stale ? " (stale)" : "");
+	}
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API returns the elapsed time between two monotonic timestamps in ns.
+*
+* @note         Internal API only.
+*
+******************************************************************************/
+static double elapsed_ns(struct timespec *t0, struct timespec *t1)
+{
+	return((t1->tv_sec - t0->tv_sec) * 1e9 + (t1->tv_nsec - t0->tv_nsec));
+}
+
+/*****************************************************************************/
+/*
+*
+* This API measures the per tick cost of reading every hwmon sensor. It times
+* num_ticks passes of one pread per pre-opened sensor and, for reference, the
+* same number of passes using the path formatting and fopen/fscanf/fclose
+* sequence the power APIs used before sensors were kept open. Passes through
+* the sensor table, which serves sensors from cache within their refresh
+* period, are timed separately along with the number of reads they made.
+*
+* @param        num_ticks: number of passes to time
+*
+* @return       Error code.
+*
+* @note         None.
+*
+******************************************************************************/
+int benchmark_sensor_reads(int num_ticks)
+{
+	struct hwmon_sensor_table *tbl;
+	struct ps_context *ctx;
+	struct timespec t0, t1;
+	double fetch_ns, table_ns, legacy_ns;
+	long table_reads;
+	int tick, i;
+
+	ctx = get_print_context();
+	if(ctx == NULL)
+	{
+		return(ENOMEM);
+	}
+
+	tbl = &ctx->sensors;
+	hwmon_sensors_read_all(tbl);
+
+	printf("\nSensor Read Benchmark\n");
+	if(tbl->num_sensors == 0 || num_ticks <= 0)
+	{
+		printf("no hwmon sensors found under /sys/class/hwmon\n");
+		return(0);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(tick = 0; tick < num_ticks; tick++)
+	{
+		for(i = 0; i < tbl->num_sensors; i++)
+		{
+			long value;
+
+			hwmon_sensor_fetch(tbl->sensors[i].fd, &value);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	fetch_ns = elapsed_ns(&t0, &t1) / num_ticks;
+
+	table_reads = 0;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(tick = 0; tick < num_ticks; tick++)
+	{
+		table_reads += hwmon_sensors_read_all(tbl);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	table_ns = elapsed_ns(&t0, &t1) / num_ticks;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(tick = 0; tick < num_ticks; tick++)
+	{
+		for(i = 0; i < tbl->num_sensors; i++)
+		{
+			char filename[255];
+			char hwmon_id_str[50];
+			long value;
+			FILE *fp;
+
+			sprintf(hwmon_id_str,"%d",tbl->sensors[i].hwmon_id);
+			strcpy(filename,"/sys/class/hwmon/hwmon");
+			strcat(filename,hwmon_id_str);
+			strcat(filename,"/");
+			strcat(filename,tbl->sensors[i].attr);
+			strcat(filename,"_input");
+
+			fp = fopen(filename,"r");
+			if(fp == NULL)
+			{
+				continue;
+			}
+			if(fscanf(fp,"%ld",&value) != 1)
+			{
+				value = 0;
+			}
+			fclose(fp);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	legacy_ns = elapsed_ns(&t0, &t1) / num_ticks;
+
+	printf("Sensors per tick        :     %d\n",tbl->num_sensors);
+	printf("Ticks                   :     %d\n",num_ticks);
+	printf("pread per tick          :     %.0f ns (%.0f ns/sensor)\n",
+		fetch_ns, fetch_ns / tbl->num_sensors);
+	printf("cached table per tick   :     %.0f ns (%.1f reads, rest from cache)\n",
+		table_ns, (double)table_reads / num_ticks);
+	printf("fopen/fscanf per tick   :     %.0f ns (%.0f ns/sensor)\n",
+		legacy_ns, legacy_ns / tbl->num_sensors);
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API prints the energy report of one hwmon power sensor or powercap
+* domain of a snapshot.
+*
+* @param        energy: energy of the sensor or domain
+* @param        verbose_flag: Enable verbose prints
+*
+* @return       None.
+*
+* @note         Internal API only.
+*
+******************************************************************************/
+static void print_energy_report(struct ps_energy *energy, int verbose_flag)
+{
+	const char *device = energy->device;
+	const char *label = energy->label;
+
+	printf("%s %s window energy    :     %.3f J over %.3f s\n",
+		device, label, energy->window_joules, energy->window_seconds);
+	printf("%s %s total energy     :     %.3f J over %.3f s\n",
+		device, label, energy->total_joules, energy->total_seconds);
+	printf("%s %s average power    :     %.3f W\n",
+		device, label, energy->avg_watts);
+	printf("%s %s peak power       :     %.3f W\n",
+		device, label, energy->peak_watts);
+
+	if(verbose_flag)
+	{
+		printf("%s %s samples          :     %d\n",
+			device, label, energy->num_samples);
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API prints the energy integrated from every hwmon power sensor since
+* the previous call (the reporting window) and since the first sample, along
+* with the average and peak power of the window. Energy counters of powercap
+* zones (RAPL on x86 hosts) are reported the same way.
+*
+* @param        verbose_flag: Enable verbose prints
+*
+* @return       Error code.
+*
+* @note         None.
+*
+******************************************************************************/
+int print_energy_utilization(int verbose_flag)
+{
+	struct ps_context *ctx;
+	int i;
+
+	ctx = get_print_context();
+	if(ctx == NULL)
+	{
+		return(ENOMEM);
+	}
+
+	ps_snapshot_collect(ctx, &print_snap, PS_SNAP_ENERGY);
+
+	printf("\nEnergy Utilization\n");
+	for(i = 0; i < print_snap.num_energy; i++)
+	{
+		struct ps_energy *energy = &print_snap.energy[i];
+
+		if(!energy->powercap)
+		{
+			print_energy_report(energy, verbose_flag);
+			continue;
+		}
+
+		if(energy->status)
+		{
+			printf("unable to read %s/%s/energy_uj\n", POWERCAP_CLASS_PATH,
+				energy->device);
+			continue;
+		}
+
+		print_energy_report(energy, verbose_flag);
+
+		if(verbose_flag)
+		{
+			printf("%s %s counter wraps    :     %lu\n", energy->device,
+				energy->label, energy->wraps);
+		}
+	}
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API adds the sensors matching one entry of the sampling selection.
+* An entry is either "device", for every power and current sensor of the
+* device, or "device/attr" for one sensor of any type.
+*
+* @param        sampler: power sampler
+* @param        tbl: hwmon sensor table
+* @param        entry: selection entry
+*
+* @return       Error code.
+*
+* @note         Internal API only.
+*
+******************************************************************************/
+static int add_sampled_sensors(struct power_sampler *sampler,
+		struct hwmon_sensor_table *tbl, const char *entry)
+{
+	const char *attr = strchr(entry, '/');
+	size_t len = attr ? (size_t)(attr - entry) : strlen(entry);
+	int i, ret, matched = 0;
+
+	for(i = 0; i < tbl->num_sensors; i++)
+	{
+		struct hwmon_sensor *sensor = &tbl->sensors[i];
+
+		if(strlen(sensor->device) != len || strncmp(sensor->device, entry, len))
+		{
+			continue;
+		}
+		if(attr ? strcmp(sensor->attr, attr + 1) :
+			(sensor->type != HWMON_SENSOR_POWER &&
+			 sensor->type != HWMON_SENSOR_CURR))
+		{
+			continue;
+		}
+
+		matched++;
+		ret = power_sampler_add(sampler, sensor);
+		if(ret)
+		{
+			printf("Unable to sample %s %s. Returned error: %d\n",
+				sensor->device, sensor->attr, ret);
+			return(ret);
+		}
+	}
+
+	if(!matched)
+	{
+		printf("No hwmon sensor matches %s\n", entry);
+		return(ENOENT);
+	}
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API starts the high rate power sampling mode. A dedicated thread,
+* optionally pinned to one CPU, samples the selected hwmon sensors at up to
+* 1 kHz and reduces the samples to per window aggregates. At most
+* SAMPLER_MAX_CHANNELS sensors are sampled; any sensor that cannot be added
+* is reported and sampling does not start.
+*
+* @param        rate_hz: sampling rate in Hz, at most 1000
+* @param        cpu: CPU to pin the sampling thread to, -1 for none
+* @param        sensors: comma separated "device" or "device/attr" entries,
+*               NULL for every power and current sensor
+*
+* @return       Error code.
+*
+* @note         None.
+*
+******************************************************************************/
+int start_power_sampling(int rate_hz, int cpu, const char *sensors)
+{
+	struct power_sampler *sampler;
+	struct hwmon_sensor_table *tbl;
+	struct ps_context *ctx;
+	int i, ret = 0;
+
+	ctx = get_print_context();
+	if(ctx == NULL)
+	{
+		return(ENOMEM);
+	}
+
+	sampler = ctx->sampler;
+	if(sampler->running)
+	{
+		return(EBUSY);
+	}
+
+	tbl = &ctx->sensors;
+	hwmon_sensors_sync(tbl);
+	power_sampler_stop(sampler);
+
+	if(sensors == NULL)
+	{
+		for(i = 0; i < tbl->num_sensors && !ret; i++)
+		{
+			if(tbl->sensors[i].type == HWMON_SENSOR_POWER ||
+				tbl->sensors[i].type == HWMON_SENSOR_CURR)
+			{
+				ret = power_sampler_add(sampler, &tbl->sensors[i]);
+				if(ret)
+				{
+					printf("Unable to sample %s %s. Returned error: %d\n",
+						tbl->sensors[i].device, tbl->sensors[i].attr, ret);
+				}
+			}
+		}
+	}
+	else
+	{
+		char list[SAMPLER_MAX_CHANNELS * (HWMON_NAME_LEN + HWMON_ATTR_LEN)];
+		char *entry, *save;
+
+		snprintf(list, sizeof(list), "%s", sensors);
+		for(entry = strtok_r(list, ",", &save); entry != NULL && !ret;
+			entry = strtok_r(NULL, ",", &save))
+		{
+			ret = add_sampled_sensors(sampler, tbl, entry);
+		}
+	}
+
+	if(!ret)
+	{
+		ret = power_sampler_start(sampler, rate_hz, cpu);
+	}
+	if(ret)
+	{
+		printf("Unable to start power sampling. Returned error: %d\n",ret);
+		power_sampler_stop(sampler);
+	}
+
+	return(ret);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API prints min, max, mean, p99 and spike count of every sampled power
+* and current sensor since the previous call, then starts a new window.
+*
+* @param        verbose_flag: Enable verbose prints
+*
+* @return       Error code.
+*
+* @note         None.
+*
+******************************************************************************/
+int print_power_sampling_stats(int verbose_flag)
+{
+	struct sampler_report reports[SAMPLER_MAX_CHANNELS];
+	struct ps_context *ctx;
+	int i, num_reports;
+
+	ctx = get_print_context();
+	if(ctx == NULL)
+	{
+		return(ENOMEM);
+	}
+
+	printf("\nHigh Rate Power Sampling\n");
+	if(!ctx->sampler->running)
+	{
+		printf("power sampling is not running\n");
+		return(0);
+	}
+
+	num_reports = power_sampler_report(ctx->sampler, reports,
+				SAMPLER_MAX_CHANNELS);
+
+	for(i = 0; i < num_reports; i++)
+	{
+		struct sampler_report *rep = &reports[i];
+		const char *unit = rep->type == HWMON_SENSOR_POWER ? "uW" : "mA";
+
+		printf("%s %s min/mean/max  :     %ld / %.0f / %ld %s\n",
+			rep->device, rep->label, rep->min, rep->mean, rep->max, unit);
+		printf("%s %s p99           :     %.0f %s\n",
+			rep->device, rep->label, rep->p99, unit);
+		printf("%s %s spikes        :     %ld\n",
+			rep->device, rep->label, rep->spikes);
+
+		if(verbose_flag)
+		{
+			printf("%s %s samples       :     %ld (%ld overruns)\n",
+				rep->device, rep->label, rep->count, rep->overruns);
+		}
+	}
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API stops the high rate power sampling mode.
+*
+* @return       None.
+*
+* @note         None.
+*
+******************************************************************************/
+void stop_power_sampling(void)
+{
+	struct ps_context *ctx = get_print_context();
+
+	if(ctx != NULL)
+	{
+		power_sampler_stop(ctx->sampler);
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API captures frames from the AMS through IIO triggered buffered
+* capture and prints min, mean and max of every enabled channel along with
+* the time span covered by the frame timestamps. Frames are read in bulk
+* from the IIO character device instead of one sysfs attribute per value.
+*
+* @param        verbose_flag: Enable verbose prints of every frame
+* @param        sysfs_dir: IIO device directory, NULL to look up the AMS
+* @param        dev_path: IIO character device or stand-in file of frames,
+*               used when sysfs_dir is given
+* @param        trigger: trigger to capture with, NULL to keep the one set
+* @param        num_frames: number of frames to capture
+*
+* @return       Error code.
+*
+* @note         None.
+*
+******************************************************************************/
+int print_iio_capture(int verbose_flag, const char *sysfs_dir, const char *dev_path,
+		const char *trigger, int num_frames)
+{
+	char found_dir[IIO_PATH_LEN], found_dev[IIO_PATH_LEN];
+	double min[IIO_MAX_CHANNELS], max[IIO_MAX_CHANNELS], sum[IIO_MAX_CHANNELS];
+	int64_t first_ts, last_ts;
+	int ret, i, f, captured, num_reads;
+
+	printf("\nAMS IIO Capture\n");
+
+	if(sysfs_dir == NULL)
+	{
+		if(iio_find_device(IIO_AMS_NAME, found_dir, found_dev))
+		{
+			printf("no iio device found for %s under %s\n", IIO_AMS_NAME,
+				IIO_DEVICES_PATH);
+			return(0);
+		}
+		sysfs_dir = found_dir;
+		dev_path = found_dev;
+	}
+
+	ret = iio_capture_open(&ams_capture, sysfs_dir, dev_path, trigger, NULL, 0);
+	if(ret)
+	{
+		printf("Unable to start capture on %s. Returned error: %d\n",sysfs_dir,ret);
+		return(ret);
+	}
+
+	captured = 0;
+	num_reads = 0;
+	first_ts = 0;
+	last_ts = 0;
+
+	while(captured < num_frames)
+	{
+		int n = iio_capture_read(&ams_capture, ams_samples,
+				num_frames - captured);
+		if(n <= 0)
+		{
+			break;
+		}
+		num_reads++;
+
+		for(f = 0; f < n; f++)
+		{
+			struct iio_sample *sample = &ams_samples[f];
+
+			if(captured == 0)
+			{
+				first_ts = sample->timestamp;
+			}
+			last_ts = sample->timestamp;
+
+			for(i = 0; i < ams_capture.num_channels; i++)
+			{
+				double v = sample->values[i];
+
+				if(captured == 0 || v < min[i])
+				{
+					min[i] = v;
+				}
+				if(captured == 0 || v > max[i])
+				{
+					max[i] = v;
+				}
+				sum[i] = (captured == 0 ? 0 : sum[i]) + v;
+			}
+
+			if(verbose_flag)
+			{
+				printf("%lld", (long long)sample->timestamp);
+				for(i = 0; i < ams_capture.num_channels; i++)
+				{
+					if(i != ams_capture.timestamp_channel)
+					{
+						printf(" %.3f", sample->values[i]);
+					}
+				}
+				printf("\n");
+			}
+
+			captured++;
+		}
+	}
+
+	printf("Frames captured    :     %d in %d reads (%d bytes/frame)\n",
+		captured, num_reads, ams_capture.frame_size);
+	if(ams_capture.timestamp_channel >= 0 && captured > 1)
+	{
+		printf("Capture span       :     %.6f s\n", (last_ts - first_ts) / 1e9);
+	}
+
+	for(i = 0; i < ams_capture.num_channels && captured > 0; i++)
+	{
+		if(i == ams_capture.timestamp_channel)
+		{
+			continue;
+		}
+		printf("%-32s:     min %.3f mean %.3f max %.3f\n",
+			ams_capture.channels[i].name, min[i], sum[i] / captured, max[i]);
+	}
+
+	iio_capture_close(&ams_capture);
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API starts watching the alarm attributes of all hwmon sensors from a
+* background thread. The thread is only started here, never implicitly by
+* the print APIs, so callers that do not ask for alarms pay nothing for it.
+*
+* @return       Error code.
+*
+* @note         None.
+*
+******************************************************************************/
+int start_alarm_monitoring(void)
+{
+	struct ps_context *ctx;
+	int ret;
+
+	ctx = get_print_context();
+	if(ctx == NULL)
+	{
+		return(ENOMEM);
+	}
+
+	ret = ps_context_start_alarms(ctx);
+	if(ret)
+	{
+		printf("Unable to monitor hwmon alarms. Returned error: %d\n",ret);
+	}
+
+	return(ret);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API stops the alarm monitoring started by start_alarm_monitoring.
+*
+* @return       None.
+*
+* @note         None.
+*
+******************************************************************************/
+void stop_alarm_monitoring(void)
+{
+	struct ps_context *ctx = get_print_context();
+
+	if(ctx != NULL)
+	{
+		ps_context_stop_alarms(ctx);
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API prints hwmon alarm transitions (over/under voltage, over
+* temperature, ...) recorded since the previous call, with the time at which
+* each one happened, followed by the alarms that are currently raised. The
+* alarms are watched by the thread of start_alarm_monitoring, so transitions
+* between two calls are not missed whatever the polling interval.
+*
+* @param        verbose_flag: Enable verbose prints
+*
+* @return       Error code.
+*
+* @note         None.
+*
+******************************************************************************/
+int print_alarm_events(int verbose_flag)
+{
+	struct ps_alarms *alarms = &print_snap.alarms;
+	struct ps_context *ctx;
+	int i;
+
+	ctx = get_print_context();
+	if(ctx == NULL)
+	{
+		return(ENOMEM);
+	}
+
+	ps_snapshot_collect(ctx, &print_snap, PS_SNAP_ALARMS);
+
+	printf("\nHwmon Alarms\n");
+
+	if(alarms->status)
+	{
+		printf("alarm monitoring not started\n");
+		return(alarms->status);
+	}
+
+	if(verbose_flag)
+	{
+		printf("watching %d alarm attributes\n",alarms->num_watched);
+	}
+
+	for(i = 0; i < alarms->num_events; i++)
+	{
+		struct ps_alarm *ev = &alarms->events[i];
+		char timestr[32];
+
+		format_time_ns(ev->time_ns, timestr, sizeof(timestr));
+
+		printf("%s.%03lld %s %s %s %s\n", timestr,
+			ev->time_ns / 1000000 % 1000, ev->device, ev->label, ev->attr,
+			ev->state ? "raised" : "cleared");
+	}
+
+	for(i = 0; i < alarms->num_active; i++)
+	{
+		printf("active: %s %s %s\n", alarms->active[i].device,
+			alarms->active[i].label, alarms->active[i].attr);
+	}
+
+	if(alarms->num_events == 0 && alarms->num_active == 0)
+	{
+		printf("no alarms\n");
+	}
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API prints the power_supply or regulator class devices of a
+* snapshot. Power is derived from voltage and current where the device does
+* not report it.
+*
+* @param        title: section title
+* @param        path: class directory, printed in verbose mode
+* @param        supplies: devices of the class
+* @param        num_supplies: number of devices
+* @param        verbose_flag: Enable verbose prints
+*
+* @return       None.
+*
+* @note         Internal API only.
+*
+******************************************************************************/
+static void print_supplies(const char *title, const char *path,
+		struct ps_supply *supplies, int num_supplies, int verbose_flag)
+{
+	int i;
+
+	if(num_supplies || verbose_flag)
+	{
+		printf("\n%s\n", title);
+	}
+	for(i = 0; i < num_supplies; i++)
+	{
+		struct ps_supply *dev = &supplies[i];
+		int *st = dev->status;
+		long *val = dev->value;
+
+		printf("%s", dev->name);
+		if(!st[PS_SUPPLY_VOLTAGE])
+		{
+			printf("  voltage: %ld mV", val[PS_SUPPLY_VOLTAGE] / 1000);
+		}
+		if(!st[PS_SUPPLY_CURRENT])
+		{
+			printf("  current: %ld mA", val[PS_SUPPLY_CURRENT] / 1000);
+		}
+		if(!st[PS_SUPPLY_POWER])
+		{
+			printf("  power: %ld mW", val[PS_SUPPLY_POWER] / 1000);
+		}
+		else if(!st[PS_SUPPLY_VOLTAGE] && !st[PS_SUPPLY_CURRENT])
+		{
+			printf("  power: %.0f mW", (double)val[PS_SUPPLY_VOLTAGE] *
+				val[PS_SUPPLY_CURRENT] / 1e9);
+		}
+		if(!st[PS_SUPPLY_ENERGY])
+		{
+			printf("  energy: %ld mWh", val[PS_SUPPLY_ENERGY] / 1000);
+		}
+		if(verbose_flag)
+		{
+			printf("  (%s/%s)", path, dev->dir);
+		}
+		printf("\n");
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API prints the voltage, current, power and energy of every device
+* registered under /sys/class/power_supply, and the output voltage and
+* current of every regulator under /sys/class/regulator that reports them.
+* On boards where rail power is only visible through a PMIC this is the
+* only power information available. Power is derived from voltage and
+* current where the device does not report it.
+*
+* @param        verbose_flag: Enable verbose prints
+*
+* @return       Error code.
+*
+* @note         None.
+*
+******************************************************************************/
+int print_supply_power_info(int verbose_flag)
+{
+	struct ps_context *ctx;
 
-	fp = fopen(filename,"r");
-	if(fp == NULL)
+	ctx = get_print_context();
+	if(ctx == NULL)
 	{
-		printf("unable to open %s\n",filename);
+		return(ENOMEM);
 	}
 
-	fscanf(fp,"%ld",&total_current);
-	fclose(fp);
-	printf("SOM total current    :     %ld mA\n",total_current);
+	ps_snapshot_collect(ctx, &print_snap, PS_SNAP_SUPPLY);
 
+	print_supplies("Power Supplies", POWER_SUPPLY_CLASS_PATH,
+		print_snap.supplies, print_snap.num_supplies, verbose_flag);
+	print_supplies("Regulators", REGULATOR_CLASS_PATH,
+		print_snap.regulators, print_snap.num_regulators, verbose_flag);
 
-	//if "voltage" file exists then read voltage value
-	strcpy(filename,base_filepath);
-	strcat(filename,"/in1_input");
+	return(0);
+}
 
-	fp = fopen(filename,"r");
-	if(fp == NULL)
+/*****************************************************************************/
+/*
+*
+* This API loads the rail model used by print_rail_budget, replacing the one
+* loaded so far. The file maps power monitor sensors to named rails and rail
+* groups with an optional power budget per group, see rail_model_load.
+*
+* @param        path: rail file, NULL for RAIL_CONFIG_PATH
+*
+* @return       Error code.
+*
+* @note         None.
+*
+******************************************************************************/
+int load_rail_model(const char *path)
+{
+	struct ps_context *ctx;
+	int ret;
+
+	ctx = get_print_context();
+	if(ctx == NULL)
 	{
-		printf("unable to open %s\n",filename);
+		return(ENOMEM);
 	}
 
-	fscanf(fp,"%ld",&total_voltage);
-	fclose(fp);
-	printf("SOM total voltage\t:     %ld mV\n",total_voltage);
-
+	ret = ps_context_load_rail_model(ctx, path ? path : RAIL_CONFIG_PATH);
+	if(ret)
+	{
+		printf("Unable to load rail model %s. Returned error: %d\n",
+			path ? path : RAIL_CONFIG_PATH, ret);
+	}
 
-	return(0);
+	return(ret);
 }
 
 /*****************************************************************************/
 /*
 *
-* This API prints the following information from sysmon driver:
-* in1_input: Voltage input value.
-* curr1_input: Current input value.
-* power1_input: Instantaneous power use
+* This API reads every rail of the rail model and prints, per rail group, the
+* total power and the headroom left against the group budget, followed by the
+* share of the total power drawn by the group. Verbose mode also prints every
+* rail. RAIL_CONFIG_PATH is loaded on first use if no model was loaded; the
+* API prints nothing if there is none.
 *
 * @param        verbose_flag: Enable verbose prints
 *
@@ -736,193 +2155,479 @@ int print_ina260_power_info(int verbose_flag)
 * @note         None.
 *
 ******************************************************************************/
-int print_sysmon_power_info(int verbose_flag)
+int print_rail_budget(int verbose_flag)
 {
-	int hwmon_id;
-	FILE *fp;
-	char filename[255];
-	char hwmon_id_str[255];
-	long LPD_TEMP, FPD_TEMP, PL_TEMP;
-	long VCC_PSPLL, PL_VCCINT, VOLT_DDRS, VCC_PSINTFP, VCC_PS_FPD;
-	long PS_IO_BANK_500, VCC_PS_GTR, VTT_PS_GTR;
+	struct ps_rails *rails = &print_snap.rails;
+	struct ps_context *ctx;
+	int i, j;
 
-	char base_filepath[] = "/sys/class/hwmon/hwmon";
-
-	hwmon_id = get_device_hwmon_id(verbose_flag,"ams");
+	ctx = get_print_context();
+	if(ctx == NULL)
+	{
+		return(ENOMEM);
+	}
 
-	if(hwmon_id == -1)
+	ps_snapshot_collect(ctx, &print_snap, PS_SNAP_RAILS);
+	if(rails->status)
 	{
-		printf("no hwmon device found for ams under /sys/class/hwmon\n");
 		return(0);
 	}
 
-	//printf("hwmon device found, device_id is %d \n",hwmon_id);
+	printf("\nRail Power Budget\n");
+	for(i = 0; i < rails->num_groups; i++)
+	{
+		struct ps_rail_group *group = &rails->groups[i];
+		double share;
 
-	sprintf(hwmon_id_str,"%d",hwmon_id);
-	strcat(base_filepath,hwmon_id_str);
+		share = rails->total_watts > 0 ?
+			100 * group->total_watts / rails->total_watts : 0;
 
-	//Print temperature values
-	strcpy(filename,base_filepath);
-	strcat(filename,"/temp1_input");
+		printf("%-16s:     %.3f W (%.1f%% of total)", group->name,
+			group->total_watts, share);
+		if(group->budget_watts > 0)
+		{
+			printf(", budget %.3f W, headroom %.3f W%s",
+				group->budget_watts, group->headroom_watts,
+				group->headroom_watts < 0 ? " OVER BUDGET" : "");
+		}
+		if(group->num_valid < group->num_rails)
+		{
+			printf(", %d of %d rails missing",
+				group->num_rails - group->num_valid, group->num_rails);
+		}
+		printf("\n");
 
-	fp = fopen(filename,"r");
-	if(fp == NULL)
-	{
-		printf("unable to open %s\n",filename);
+		if(!verbose_flag)
+		{
+			continue;
+		}
+
+		for(j = 0; j < rails->num_rails; j++)
+		{
+			struct ps_rail *rail = &rails->rails[j];
+
+			if(rail->group != i)
+			{
+				continue;
+			}
+
+			if(!rail->status)
+			{
+				printf("    %-12s:     %.3f W (%s)\n", rail->name,
+					rail->watts, rail->device);
+			}
+			else
+			{
+				printf("    %-12s:     unable to read %s %s\n", rail->name,
+					rail->device, rail->attr);
+			}
+		}
+
+		if(group->peak_watts > 0)
+		{
+			printf("    %-12s:     %.3f W\n", "peak", group->peak_watts);
+		}
 	}
+	printf("%-16s:     %.3f W\n", "total", rails->total_watts);
 
-	fscanf(fp,"%ld",&LPD_TEMP);
-	fclose(fp);
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API estimates the power drawn by each CPU cluster over the interval
+* since the previous call from its frequency residency, its idle residency
+* and per OPP power coefficients, see cpu_power_update. The coefficients are
+* taken from CPU_POWER_MODEL_PATH, as written by calibrate_cpu_power, or else
+* from the kernel energy model. The first call only starts the interval.
+*
+* @param        verbose_flag: Enable verbose prints
+*
+* @return       Error code.
+*
+* @note         Nothing is printed without coefficients unless verbose_flag
+*		is set.
+*
+******************************************************************************/
+int print_cpu_power_estimate(int verbose_flag)
+{
+	struct ps_cpu_power *model = &print_snap.cpu_power;
+	struct ps_context *ctx;
+	int i, j;
 
-	//FPD temp
-	strcpy(filename,base_filepath);
-	strcat(filename,"/temp2_input");
+	ctx = get_print_context();
+	if(ctx == NULL)
+	{
+		return(ENOMEM);
+	}
 
-	fp = fopen(filename,"r");
-	if(fp == NULL)
+	ps_snapshot_collect(ctx, &print_snap, PS_SNAP_CPU_POWER);
+	if(model->status == ENOENT)
+	{
+		if(verbose_flag)
+		{
+			printf("\nCPU Power Estimate\n");
+			printf("no CPU power coefficients in %s or %s\n",
+				CPU_POWER_MODEL_PATH, ENERGY_MODEL_PATH);
+		}
+		return(0);
+	}
+
+	if(model->status)
 	{
-		printf("unable to open %s\n",filename);
+		return(0);
 	}
 
-	fscanf(fp,"%ld",&FPD_TEMP);
-	fclose(fp);
+	printf("\nCPU Power Estimate\n");
+	for(i = 0; i < model->num_clusters; i++)
+	{
+		struct ps_cpu_cluster *cl = &model->clusters[i];
 
-	//PL temp
-	strcpy(filename,base_filepath);
-	strcat(filename,"/temp3_input");
+		printf("policy%d\t:     %.3f W, %.2f of %d CPUs busy\n", cl->policy,
+			cl->watts, cl->busy_s / model->window_s, cl->num_cpus);
 
-	fp = fopen(filename,"r");
-	if(fp == NULL)
+		if(!verbose_flag)
+		{
+			continue;
+		}
+
+		for(j = 0; j < cl->num_opps; j++)
+		{
+			struct ps_cpu_opp *opp = &cl->opps[j];
+
+			if(opp->delta_s <= 0)
+			{
+				continue;
+			}
+			printf("    %5ld MHz:     %.1f%% of time, %.1f mW per busy CPU\n",
+				opp->khz / 1000, 100 * opp->delta_s / model->window_s,
+				opp->power_mw);
+		}
+	}
+	printf("%-8s:     %.3f W (base %.3f W)\n", "total", model->total_watts,
+		model->base_mw / 1000);
+	if(verbose_flag)
 	{
-		printf("unable to open %s\n",filename);
+		printf("coefficients from %s\n", model->source);
 	}
 
-	fscanf(fp,"%ld",&PL_TEMP);
-	fclose(fp);
+	return(0);
+}
 
-	//VCC_PSPLL
-	strcpy(filename,base_filepath);
-	strcat(filename,"/in1_input");
+/*****************************************************************************/
+/*
+*
+* This API calibrates the CPU power estimate against the INA260 SOM power
+* monitor. Once a second for num_ticks seconds it pairs the average power
+* of the second, integrated by the energy accumulator of the INA260 from
+* CPU_POWER_CALIB_READS reads, with the load of every CPU cluster over the
+* same second, then fits a base power
+* and one coefficient per cluster by least squares and writes the per OPP
+* coefficients to path. The load should be varied across the clusters and
+* frequencies during calibration, or the fit fails.
+*
+* @param        path: calibration file, NULL for CPU_POWER_MODEL_PATH
+* @param        num_ticks: number of one second samples
+*
+* @return       Error code.
+*
+* @note         None.
+*
+******************************************************************************/
+int calibrate_cpu_power(const char *path, int num_ticks)
+{
+	struct cpu_power_model *model;
+	struct hwmon_sensor_set *set;
+	struct hwmon_sensor *sensor;
+	struct energy_report rep;
+	struct ps_context *ctx;
+	int i, j, ret;
+
+	if(path == NULL)
+	{
+		path = CPU_POWER_MODEL_PATH;
+	}
 
-	fp = fopen(filename,"r");
-	if(fp == NULL)
+	ctx = get_print_context();
+	if(ctx == NULL)
 	{
-		printf("unable to open %s\n",filename);
+		return(ENOMEM);
 	}
 
-	fscanf(fp,"%ld",&VCC_PSPLL);
-	fclose(fp);
+	ps_context_probe(ctx, PS_PROBE_CPU_POWER);
+	model = ctx->cpu_power;
+	set = &ctx->som_set;
+	if(!model->valid || model->num_clusters == 0)
+	{
+		printf("no cpufreq policy found under %s/cpufreq\n", CPU_SYSFS_PATH);
+		return(ENODEV);
+	}
 
-	//PL_VCCINT
-	strcpy(filename,base_filepath);
-	strcat(filename,"/in3_input");
+	hwmon_sensor_set_read(&ctx->sensors, set);
+	if(set->sensors[PS_SOM_POWER] == NULL)
+	{
+		printf("no hwmon device found for ina260_u14 under /sys/class/hwmon\n");
+		return(ENODEV);
+	}
 
-	fp = fopen(filename,"r");
-	if(fp == NULL)
+	/* the first window of the accumulator starts with the CPU window */
+	cpu_power_update(model);
+	energy_accum_report(&set->sensors[PS_SOM_POWER]->energy, &rep);
+
+	for(i = 0; i < num_ticks; i++)
+	{
+		for(j = 0; j < CPU_POWER_CALIB_READS; j++)
+		{
+			usleep(1000000 / CPU_POWER_CALIB_READS);
+			hwmon_sensor_set_read(&ctx->sensors, set);
+		}
+
+		cpu_power_update(model);
+		sensor = set->sensors[PS_SOM_POWER];
+		if(sensor == NULL)
+		{
+			continue;
+		}
+
+		energy_accum_report(&sensor->energy, &rep);
+		if(rep.window_seconds <= 0)
+		{
+			continue;
+		}
+
+		cpu_power_calib_add(model, rep.avg_watts);
+	}
+
+	ret = cpu_power_calib_solve(model);
+	if(ret)
 	{
-		printf("unable to open %s\n",filename);
+		printf("Unable to fit CPU power model from %d samples. Returned error: %d\n",
+			model->num_samples, ret);
+		return(ret);
 	}
 
-	fscanf(fp,"%ld",&PL_VCCINT);
-	fclose(fp);
+	ret = cpu_power_save(model, path);
+	if(ret)
+	{
+		printf("Unable to write %s. Returned error: %d\n", path, ret);
+		return(ret);
+	}
 
-	//VOLT_DDRS
-	strcpy(filename,base_filepath);
-	strcat(filename,"/in6_input");
+	printf("CPU power model fitted from %d samples, written to %s\n",
+		model->num_samples, path);
 
-	fp = fopen(filename,"r");
-	if(fp == NULL)
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API attributes the SOM energy measured by the INA260 over the
+* interval since the previous call to processes, in proportion to their CPU
+* time weighted by the frequency they ran at, see proc_power_update. The
+* energy is the growth of the energy accumulator of the sensor, so the power
+* is the average of the interval rather than the last reading. It prints
+* the PROC_POWER_TOP processes drawing the most power with the energy
+* attributed to them in the interval and so far; verbose mode prints the
+* PS_MAX_PROCS processes that drew the most power in the interval and the
+* totals per cgroup. The first call only starts the interval.
+*
+* @param        verbose_flag: Enable verbose prints
+*
+* @return       Error code.
+*
+* @note         None.
+*
+******************************************************************************/
+int print_process_power(int verbose_flag)
+{
+	struct ps_proc_power *tab = &print_snap.proc_power;
+	struct ps_context *ctx;
+	int i, num_shown;
+
+	ctx = get_print_context();
+	if(ctx == NULL)
 	{
-		printf("unable to open %s\n",filename);
+		return(ENOMEM);
 	}
 
-	fscanf(fp,"%ld",&VOLT_DDRS);
-	fclose(fp);
+	ps_snapshot_collect(ctx, &print_snap, PS_SNAP_PROC_POWER);
+	if(tab->som_status)
+	{
+		printf("\nProcess Power\n");
+		printf("no hwmon device found for ina260_u14 under /sys/class/hwmon\n");
+		return(0);
+	}
 
-	//VCC_PSINTFP
-	strcpy(filename,base_filepath);
-	strcat(filename,"/in7_input");
+	if(tab->status == ENOENT)
+	{
+		printf("\nProcess Power\n");
+		printf("unable to open %s\n", PROC_PATH);
+		return(0);
+	}
 
-	fp = fopen(filename,"r");
-	if(fp == NULL)
+	if(tab->status)
 	{
-		printf("unable to open %s\n",filename);
+		return(0);
 	}
 
-	fscanf(fp,"%ld",&VCC_PSINTFP);
-	fclose(fp);
+	printf("\nProcess Power\n");
+	printf("measured %.3f W over %.1f s, base %.3f W%s, %d processes\n",
+		tab->measured_watts, tab->window_s, tab->base_watts,
+		tab->fitting ? " (fitting)" : "", tab->num_entries);
+
+	num_shown = verbose_flag ? tab->num_procs : PROC_POWER_TOP;
+	for(i = 0; i < num_shown && i < tab->num_procs; i++)
+	{
+		struct ps_process *e = &tab->procs[i];
 
-	//VCC_PS_FPD
-	strcpy(filename,base_filepath);
-	strcat(filename,"/in9_input");
+		printf("%7d %-16s:     %8.1f mW, %.3f J (%.3f J total), %.2f s CPU\n",
+			e->pid, e->comm, e->watts * 1000, e->watts * tab->window_s,
+			e->joules, e->cpu_s);
+	}
 
-	fp = fopen(filename,"r");
-	if(fp == NULL)
+	if(!verbose_flag)
 	{
-		printf("unable to open %s\n",filename);
+		return(0);
 	}
 
-	fscanf(fp,"%ld",&VCC_PS_FPD);
-	fclose(fp);
+	for(i = 0; i < tab->num_cgroups; i++)
+	{
+		struct ps_cgroup *cg = &tab->cgroups[i];
+
+		printf("cgroup %s:     %.1f mW, %.3f J (%.3f J total)\n", cg->name,
+			cg->watts * 1000, cg->watts * tab->window_s, cg->joules);
+	}
+	printf("%lu processes started, %lu exited\n", tab->new_procs, tab->exited_procs);
 
-	// PS_IO_BANK_500
-	strcpy(filename,base_filepath);
-	strcat(filename,"/in13_input");
+	return(0);
+}
 
-	fp = fopen(filename,"r");
-	if(fp == NULL)
+/*****************************************************************************/
+/*
+*
+* This API prints the runtime PM activity of devices over the interval since
+* the previous call. Devices that stayed active for the whole interval are
+* the ones to look at when idle power is too high; the RPM_TOP of them
+* active longest are printed, marked when user space blocks runtime PM
+* through power/control. Verbose mode prints the PS_MAX_RPM_DEVICES devices
+* active longest with their active share. The first call only starts the interval.
+*
+* @param        verbose_flag: Enable verbose prints
+*
+* @return       Error code.
+*
+* @note         None.
+*
+******************************************************************************/
+int print_runtime_pm_info(int verbose_flag)
+{
+	struct ps_runtime_pm *rpm = &print_snap.rpm;
+	struct ps_context *ctx;
+	int i, num_shown;
+
+	ctx = get_print_context();
+	if(ctx == NULL)
 	{
-		printf("unable to open %s\n",filename);
+		return(ENOMEM);
 	}
 
-	fscanf(fp,"%ld",&PS_IO_BANK_500);
-	fclose(fp);
+	ps_snapshot_collect(ctx, &print_snap, PS_SNAP_RUNTIME_PM);
+	if(rpm->status == ENODATA)
+	{
+		return(0);
+	}
+
+	printf("\nRuntime PM\n");
+	if(rpm->status)
+	{
+		printf("no device with runtime PM support under %s\n", DEVICES_PATH);
+		return(0);
+	}
 
-	//VCC_PS_GTR
-	strcpy(filename,base_filepath);
-	strcat(filename,"/in16_input");
+	printf("%d devices, %d active, %d never suspended in the interval%s\n",
+		rpm->num_devices, rpm->num_active, rpm->num_awake,
+		rpm->truncated ? " (device list truncated)" : "");
 
-	fp = fopen(filename,"r");
-	if(fp == NULL)
+	num_shown = 0;
+	for(i = 0; i < rpm->num_shown; i++)
 	{
-		printf("unable to open %s\n",filename);
+		struct ps_rpm_device *dev = &rpm->devices[i];
+		double share;
+
+		if(!verbose_flag && (dev->suspended_ms > 0 || num_shown == RPM_TOP))
+		{
+			continue;
+		}
+
+		share = 100.0 * dev->active_ms / (dev->active_ms + dev->suspended_ms);
+		printf("%-48s:     active %5.1f%%%s\n", dev->path, share,
+			dev->forced_on ? ", runtime PM blocked by power/control" : "");
+		num_shown++;
 	}
 
-	fscanf(fp,"%ld",&VCC_PS_GTR);
-	fclose(fp);
+	return(0);
+}
 
-	//VTT_PS_GTR
-	strcpy(filename,base_filepath);
-	strcat(filename,"/in17_input");
+/*****************************************************************************/
+/*
+*
+* This API prints the wakeup sources most active over the interval since the
+* previous call, with their events, wakeups that aborted a suspend, active
+* time and time they prevented suspend. WAKEUP_TOP sources are printed,
+* verbose mode prints up to PS_MAX_WAKEUP_SOURCES. The first call only
+* starts the interval.
+*
+* @param        verbose_flag: Enable verbose prints
+*
+* @return       Error code.
+*
+* @note         None.
+*
+******************************************************************************/
+int print_wakeup_info(int verbose_flag)
+{
+	struct ps_wakeup *wakeup = &print_snap.wakeup;
+	struct ps_context *ctx;
+	int i, num_top;
 
-	fp = fopen(filename,"r");
-	if(fp == NULL)
+	ctx = get_print_context();
+	if(ctx == NULL)
 	{
-		printf("unable to open %s\n",filename);
+		return(ENOMEM);
 	}
 
-	fscanf(fp,"%ld",&VTT_PS_GTR);
-	fclose(fp);
+	ps_snapshot_collect(ctx, &print_snap, PS_SNAP_WAKEUP);
+	if(wakeup->status == ENODATA)
+	{
+		return(0);
+	}
 
-	printf("AMS CTRL\n");
-	printf("System PLLs voltage measurement, VCC_PSLL   		:     %ld mV\n",VCC_PSPLL);
-	printf("PL internal voltage measurement, VCC_PSBATT 		:     %ld mV\n",PL_VCCINT);
-	printf("Voltage measurement for six DDR I/O PLLs, VCC_PSDDR_PLL :     %ld mV\n",VOLT_DDRS);
-	printf("VCC_PSINTFP_DDR voltage measurement         		:     %ld mV\n\n",VCC_PSINTFP);
+	printf("\nWakeup Sources\n");
+	if(wakeup->status)
+	{
+		printf("no wakeup sources in %s or %s\n", WAKEUP_CLASS_PATH,
+			WAKEUP_DEBUGFS_PATH);
+		return(0);
+	}
 
-	printf("PS Sysmon\n");
-	printf("LPD temperature measurement 		    		:     %ld C\n",(LPD_TEMP)/1000);
-	printf("FPD temperature measurement (REMOTE)  		    		:     %ld C\n",(FPD_TEMP)/1000);
-	printf("VCC PS FPD voltage measurement (supply 2)   		:     %ld mV\n",VCC_PS_FPD);
-	printf("PS IO Bank 500 voltage measurement (supply 6)		:     %ld mV\n",PS_IO_BANK_500);
-	printf("VCC PS GTR voltage   					:     %ld mV\n",VCC_PS_GTR);
-	printf("VTT PS GTR voltage    					:     %ld mV\n\n",VTT_PS_GTR);
+	printf("%d sources%s\n", wakeup->num_sources,
+		wakeup->truncated ? " (source list truncated)" : "");
 
-	printf("PL Sysmon\n");
-	printf("PL temperature    					:     %ld C\n",(PL_TEMP)/1000);
+	num_top = verbose_flag ? wakeup->num_top : WAKEUP_TOP;
+	for(i = 0; i < num_top && i < wakeup->num_top; i++)
+	{
+		struct ps_wakeup_source *src = &wakeup->top[i];
+
+		printf("%-32s:     %6llu events %6llu wakeups %8llu ms active %8llu ms prevented suspend\n",
+			src->name, src->events, src->wakeups, src->active_ms,
+			src->prevent_ms);
+	}
 
 	return(0);
 }
+
 /*****************************************************************************/
 /*
 *
@@ -939,6 +2644,15 @@ int print_power_utilization(int verbose_flag)
 {
 	print_ina260_power_info(verbose_flag);
 	print_sysmon_power_info(verbose_flag);
+	print_supply_power_info(verbose_flag);
+	print_rail_budget(verbose_flag);
+	print_cpu_power_estimate(verbose_flag);
+	print_energy_utilization(verbose_flag);
+
+	if(print_ctx != NULL && print_ctx->alarms->running)
+	{
+		print_alarm_events(verbose_flag);
+	}
 
 	return(0);
 }
@@ -971,4 +2685,10 @@ void print_all_stats(int verbose_flag)
 	print_cma_utilization(verbose_flag);
 
 	print_cpu_frequency(verbose_flag);
+
+	print_devfreq_info(verbose_flag);
+
+	print_thermal_info(verbose_flag);
+
+	print_throttle_info(verbose_flag);
 }
@@ -3,6 +3,78 @@
 * SPDX-License-Identifier: MIT
 ******************************************************************************/
 
+#ifndef _PLATFORMSTATS_H_
+#define _PLATFORMSTATS_H_
+
+/************************** Constant Definitions *****************************/
+#define PS_MAX_CPUS		64
+#define PS_MAX_THERMAL_ZONES	32
+#define PS_MAX_TRIPS		12
+#define PS_MAX_COOLING		32
+#define PS_MAX_DEVFREQ		16
+#define PS_MAX_DEVFREQ_STATES	32
+#define PS_MAX_ENERGY		32	/* hwmon power sensors and powercap domains */
+#define PS_MAX_SUPPLIES		32	/* power supplies, and regulators */
+#define PS_MAX_RAILS		32
+#define PS_MAX_RAIL_GROUPS	16
+#define PS_MAX_POLICIES		16
+#define PS_MAX_EPISODES		32
+#define PS_MAX_CLUSTERS		8
+#define PS_MAX_OPPS		32
+#define PS_MAX_PROCS		32
+#define PS_MAX_CGROUPS		16
+#define PS_MAX_RPM_DEVICES	32
+#define PS_MAX_WAKEUP_SOURCES	32
+#define PS_MAX_ALARM_EVENTS	32
+#define PS_MAX_ALARMS		32
+#define PS_MAX_SENSORS		128
+#define PS_NAME_LEN		64
+#define PS_TRIP_TYPE_LEN	32
+#define PS_ATTR_LEN		32
+#define PS_RAIL_NAME_LEN	32
+#define PS_COMM_LEN		32
+#define PS_PATH_LEN		256
+#define PS_UNIT_LEN		8
+
+/* Metric groups collected by ps_snapshot_collect */
+#define PS_SNAP_CPU_UTIL	(1 << 0)
+#define PS_SNAP_CPU_FREQ	(1 << 1)
+#define PS_SNAP_MEMORY		(1 << 2)
+#define PS_SNAP_SOM_POWER	(1 << 3)
+#define PS_SNAP_SYSMON		(1 << 4)
+#define PS_SNAP_THERMAL		(1 << 5)
+#define PS_SNAP_DEVFREQ		(1 << 6)
+#define PS_SNAP_ENERGY		(1 << 7)
+#define PS_SNAP_SUPPLY		(1 << 8)
+#define PS_SNAP_RAILS		(1 << 9)
+#define PS_SNAP_THROTTLE	(1 << 10)
+#define PS_SNAP_CPU_POWER	(1 << 11)
+#define PS_SNAP_PROC_POWER	(1 << 12)
+#define PS_SNAP_RUNTIME_PM	(1 << 13)
+#define PS_SNAP_WAKEUP		(1 << 14)
+#define PS_SNAP_ALARMS		(1 << 15)
+#define PS_SNAP_HWMON		(1 << 16)
+#define PS_SNAP_ALL		((1 << 17) - 1)
+
+/**************************** Type Definitions *******************************/
+/* Collection state, see ps_context_create */
+struct ps_context;
+
+enum ps_som_value { PS_SOM_POWER, PS_SOM_CURRENT, PS_SOM_VOLTAGE, PS_SOM_NUM };
+
+enum ps_sysmon_value {
+	PS_SYSMON_LPD_TEMP, PS_SYSMON_FPD_TEMP, PS_SYSMON_PL_TEMP,
+	PS_SYSMON_VCC_PSPLL, PS_SYSMON_PL_VCCINT, PS_SYSMON_VOLT_DDRS,
+	PS_SYSMON_VCC_PSINTFP, PS_SYSMON_VCC_PS_FPD, PS_SYSMON_PS_IO_BANK_500,
+	PS_SYSMON_VCC_PS_GTR, PS_SYSMON_VTT_PS_GTR, PS_SYSMON_NUM
+};
+
+/* Regulators only report voltage and current */
+enum ps_supply_value {
+	PS_SUPPLY_VOLTAGE, PS_SUPPLY_CURRENT, PS_SUPPLY_POWER, PS_SUPPLY_ENERGY,
+	PS_SUPPLY_NUM
+};
+
 struct cpustat {
         unsigned long user;
         unsigned long nice;
@@ -14,7 +86,364 @@ struct cpustat {
         double total_util;
 };
 
+/*
+ * Every status field is 0 when the value next to it is valid and an errno
+ * otherwise: ENOENT when the source does not exist on this platform, ENODEV
+ * when its device is missing, or the error of the failed read.
+ */
+struct ps_cpu {
+	struct cpustat stat;		/* counters, total_util over the window */
+	int stat_status;
+	float freq_mhz;
+	int freq_status;
+};
+
+struct ps_memory {
+	unsigned long mem_total;	/* kB */
+	unsigned long mem_free;
+	unsigned long mem_available;
+	int mem_status;
+	unsigned long swap_total;
+	unsigned long swap_free;
+	int swap_status;
+	unsigned long cma_total;
+	unsigned long cma_free;
+	int cma_status;
+};
+
+struct ps_trip {
+	long temp;			/* m°C */
+	char type[PS_TRIP_TYPE_LEN];	/* active, passive, hot or critical */
+};
+
+struct ps_thermal_zone {
+	int id;				/* N of thermal_zoneN */
+	char type[PS_NAME_LEN];
+	long temp;			/* m°C */
+	long headroom;			/* m°C to the nearest trip point */
+	int has_trip;			/* headroom and nearest are valid */
+	int nearest;			/* index in trips of the nearest trip point */
+	int status;
+	int num_trips;
+	struct ps_trip trips[PS_MAX_TRIPS];
+};
+
+struct ps_cooling_device {
+	int id;				/* N of cooling_deviceN */
+	char type[PS_NAME_LEN];
+	long cur_state;
+	long max_state;
+	int status;			/* of cur_state */
+};
+
+struct ps_devfreq_state {
+	unsigned long freq;		/* Hz */
+	unsigned long long delta_ms;	/* residency over the window */
+};
+
+/*
+ * The residency covers the window since the previous snapshot of the same
+ * context that collected PS_SNAP_DEVFREQ; window_ms is 0 on the first, or
+ * without trans_stat.
+ */
+struct ps_devfreq {
+	char name[PS_NAME_LEN];
+	char governor[PS_NAME_LEN];	/* empty if unknown */
+	long cur_freq;			/* Hz */
+	int status;
+	unsigned long long window_ms;
+	unsigned long transitions;	/* over the window */
+	int num_states;
+	struct ps_devfreq_state states[PS_MAX_DEVFREQ_STATES];
+};
+
+/*
+ * The windows of the sections below cover the time since the previous
+ * snapshot of the same context that collected the same group. CPU power,
+ * process power, runtime PM and wakeup need two snapshots: the first only
+ * starts the window and its status is ENODATA. Lists are capped at their
+ * PS_MAX_* size.
+ */
+
+/* Energy of one hwmon power sensor or powercap domain */
+struct ps_energy {
+	char device[PS_NAME_LEN];	/* hwmon device or powercap zone */
+	char label[PS_NAME_LEN];	/* sensor label or domain name */
+	int powercap;			/* 1 for a powercap domain */
+	int status;
+	double window_joules;
+	double window_seconds;
+	double total_joules;		/* since the first sample */
+	double total_seconds;
+	double avg_watts;		/* over the window */
+	double peak_watts;
+	int num_samples;
+	unsigned long wraps;		/* of the powercap counter */
+};
+
+/* A power_supply or regulator class device, see enum ps_supply_value */
+struct ps_supply {
+	char name[PS_NAME_LEN];
+	char dir[PS_NAME_LEN];		/* directory under the class */
+	long value[PS_SUPPLY_NUM];	/* uV, uA, uW, uWh */
+	int status[PS_SUPPLY_NUM];
+};
+
+struct ps_rail {
+	char name[PS_RAIL_NAME_LEN];
+	int group;			/* index in ps_rails.groups */
+	char device[PS_NAME_LEN + 32];	/* name@parent */
+	char attr[PS_ATTR_LEN];		/* power attribute, or current without */
+	int status;
+	double watts;
+};
+
+struct ps_rail_group {
+	char name[PS_RAIL_NAME_LEN];
+	double budget_watts;		/* 0 without budget */
+	double total_watts;		/* of the rails read */
+	double headroom_watts;
+	double peak_watts;		/* highest total since the model was loaded */
+	int num_rails;
+	int num_valid;
+};
+
+/* status is ENOENT when no rail model is loaded */
+struct ps_rails {
+	int status;
+	double total_watts;
+	int num_rails;
+	struct ps_rail rails[PS_MAX_RAILS];
+	int num_groups;
+	struct ps_rail_group groups[PS_MAX_RAIL_GROUPS];
+};
+
+struct ps_cpufreq_policy {
+	int id;				/* N of policyN */
+	int status;
+	long cur_khz;
+	long cap_khz;			/* current limit */
+	long user_khz;			/* limit set by the user */
+	long max_khz;			/* hardware maximum */
+};
+
+struct ps_throttle_episode {
+	long long start_ns;		/* CLOCK_REALTIME */
+	double duration;		/* seconds */
+	double lost_ghz_s;
+	long min_khz;
+	char cause[PS_NAME_LEN];
+};
+
+/*
+ * status is ENOENT without cpufreq. episodes ended in the window, oldest
+ * first; current is valid while active.
+ */
+struct ps_throttle {
+	int status;
+	int num_policies;
+	struct ps_cpufreq_policy policies[PS_MAX_POLICIES];
+	int num_episodes;
+	struct ps_throttle_episode episodes[PS_MAX_EPISODES];
+	int active;
+	struct ps_throttle_episode current;
+	unsigned long total_episodes;
+	double total_lost_ghz_s;
+};
+
+struct ps_cpu_opp {
+	long khz;
+	double delta_s;			/* residency in the window */
+	double power_mw;		/* of one busy CPU, < 0 if unknown */
+};
+
+struct ps_cpu_cluster {
+	int policy;
+	int num_cpus;
+	double busy_s;			/* busy CPU-seconds in the window */
+	double watts;
+	int num_opps;
+	struct ps_cpu_opp opps[PS_MAX_OPPS];
+};
+
+/* status is ENOENT without power coefficients */
+struct ps_cpu_power {
+	int status;
+	double window_s;
+	double base_mw;
+	double total_watts;
+	char source[PS_PATH_LEN];	/* of the coefficients */
+	int num_clusters;
+	struct ps_cpu_cluster clusters[PS_MAX_CLUSTERS];
+};
+
+struct ps_process {
+	int pid;
+	char comm[PS_COMM_LEN];
+	char cgroup[PS_NAME_LEN];
+	double watts;			/* over the window */
+	double joules;			/* since the process was first seen */
+	double cpu_s;			/* CPU time in the window */
+};
+
+struct ps_cgroup {
+	char name[PS_NAME_LEN];
+	double watts;
+	double joules;
+};
+
+/*
+ * som_status is that of the SOM power the energy is taken from. status is
+ * ENOENT when /proc cannot be read. procs holds the processes that drew
+ * power in the window, most first, and cgroups their totals over every
+ * process in the order of their top process.
+ */
+struct ps_proc_power {
+	int som_status;
+	int status;
+	double measured_watts;
+	double window_s;
+	double base_watts;
+	int fitting;			/* base power fit not trusted yet */
+	int num_entries;		/* processes seen */
+	unsigned long new_procs;	/* since the first snapshot */
+	unsigned long exited_procs;
+	int num_procs;
+	struct ps_process procs[PS_MAX_PROCS];
+	int num_cgroups;
+	struct ps_cgroup cgroups[PS_MAX_CGROUPS];
+};
+
+struct ps_rpm_device {
+	char path[PS_PATH_LEN];		/* under /sys/devices */
+	int forced_on;			/* runtime PM blocked by power/control */
+	unsigned long long active_ms;	/* in the window */
+	unsigned long long suspended_ms;
+};
+
+/*
+ * status is ENOENT without devices with runtime PM support. devices holds
+ * those active in the window, longest first.
+ */
+struct ps_runtime_pm {
+	int status;
+	int num_devices;		/* with runtime PM support */
+	int num_active;
+	int num_awake;			/* never suspended in the window */
+	int truncated;			/* more devices than could be indexed */
+	int num_shown;
+	struct ps_rpm_device devices[PS_MAX_RPM_DEVICES];
+};
+
+struct ps_wakeup_source {
+	char name[PS_NAME_LEN];
+	unsigned long long events;	/* in the window */
+	unsigned long long wakeups;	/* events that aborted a suspend */
+	unsigned long long active_ms;
+	unsigned long long prevent_ms;	/* time suspend was prevented */
+};
+
+/* status is ENOENT without wakeup sources. top is the most active first */
+struct ps_wakeup {
+	int status;
+	int num_sources;
+	int truncated;
+	int num_top;
+	struct ps_wakeup_source top[PS_MAX_WAKEUP_SOURCES];
+};
+
+struct ps_alarm {
+	long long time_ns;		/* CLOCK_REALTIME of the transition */
+	int state;			/* 1 raised, 0 cleared */
+	char device[PS_NAME_LEN];
+	char attr[PS_ATTR_LEN];
+	char label[PS_NAME_LEN];
+};
+
+/*
+ * status is ESRCH until ps_context_start_alarms. events are the transitions
+ * since the previous snapshot, oldest first; those past PS_MAX_ALARM_EVENTS
+ * are left for the next one. active lists the alarms raised now.
+ */
+struct ps_alarms {
+	int status;
+	int num_watched;
+	int num_events;
+	struct ps_alarm events[PS_MAX_ALARM_EVENTS];
+	int num_active;
+	struct ps_alarm active[PS_MAX_ALARMS];
+};
+
+struct ps_hwmon_sensor {
+	int hwmon_id;
+	char device[PS_NAME_LEN];
+	char attr[PS_ATTR_LEN];
+	char label[PS_NAME_LEN];
+	char unit[PS_UNIT_LEN];
+	long value;			/* hwmon ABI units */
+	int status;
+	int stale;			/* the chip has not refreshed it in time */
+	long age_ms;
+};
+
+/*
+ * The metrics of one collection, in caller provided storage. Only the
+ * groups set in collected were filled in. CPU utilization covers the
+ * window since the previous snapshot that collected it; util_window_ns is 0
+ * on the first.
+ */
+struct ps_snapshot {
+	unsigned int collected;		/* PS_SNAP_* */
+	long long timestamp_ns;		/* CLOCK_MONOTONIC */
+	long long util_window_ns;
+	int num_cpus;
+	struct ps_cpu cpus[PS_MAX_CPUS];
+	struct ps_memory mem;
+	long som[PS_SOM_NUM];		/* uW, mA, mV */
+	int som_status[PS_SOM_NUM];
+	long sysmon[PS_SYSMON_NUM];	/* m°C or mV */
+	int sysmon_status[PS_SYSMON_NUM];
+	int num_zones;
+	struct ps_thermal_zone zones[PS_MAX_THERMAL_ZONES];
+	int num_cooling;
+	struct ps_cooling_device cooling[PS_MAX_COOLING];
+	int num_devfreq;
+	struct ps_devfreq devfreq[PS_MAX_DEVFREQ];
+	int num_energy;
+	struct ps_energy energy[PS_MAX_ENERGY];
+	int num_supplies;
+	struct ps_supply supplies[PS_MAX_SUPPLIES];
+	int num_regulators;
+	struct ps_supply regulators[PS_MAX_SUPPLIES];
+	struct ps_rails rails;
+	struct ps_throttle throttle;
+	struct ps_cpu_power cpu_power;
+	struct ps_proc_power proc_power;
+	struct ps_runtime_pm rpm;
+	struct ps_wakeup wakeup;
+	struct ps_alarms alarms;
+	int num_sensors;
+	struct ps_hwmon_sensor sensors[PS_MAX_SENSORS];
+};
+
 /************************** Function Prototypes  *****************************/
+struct ps_context *ps_context_create(void);
+void ps_context_destroy(struct ps_context *ctx);
+int ps_context_open_ina_i2c(struct ps_context *ctx, const char *spec);
+int ps_context_load_ams_registers(struct ps_context *ctx, const char *path);
+int ps_context_load_rail_model(struct ps_context *ctx, const char *path);
+int ps_context_start_alarms(struct ps_context *ctx);
+void ps_context_stop_alarms(struct ps_context *ctx);
+int ps_snapshot_collect(struct ps_context *ctx, struct ps_snapshot *snap, unsigned int what);
+int ps_context_publish(struct ps_context *ctx, unsigned int what);
+int ps_snapshot_latest(struct ps_context *ctx, struct ps_snapshot *snap);
+
+/*
+ * The print, load, start and stop APIs below share one context and are
+ * called from one thread, see platformstats.c. The get_* and calculate_*
+ * APIs keep no state. Threads collecting concurrently use the context APIs
+ * above, one context per thread or a published one.
+ */
 void print_all_stats(int verbose_flag);
 int print_cpu_utilization(int verbose_flag);
 double calculate_load(struct cpustat *prev, struct cpustat *curr);
@@ -29,12 +458,39 @@ int get_swap_memory_utilization(unsigned long* SwapTotal, unsigned long* SwapFre
 
 int print_power_utilization(int verbose_flag);
 int print_ina260_power_info(int verbose_flag);
+int open_ina_i2c(const char *spec);
+int print_sysmon_power_info(int verbose_flag);
+int load_ams_registers(const char *path);
+int print_supply_power_info(int verbose_flag);
+int print_energy_utilization(int verbose_flag);
+int load_rail_model(const char *path);
+int print_rail_budget(int verbose_flag);
+int print_cpu_power_estimate(int verbose_flag);
+int calibrate_cpu_power(const char *path, int num_ticks);
+int print_process_power(int verbose_flag);
+int print_runtime_pm_info(int verbose_flag);
+int print_wakeup_info(int verbose_flag);
+int start_alarm_monitoring(void);
+int print_alarm_events(int verbose_flag);
+void stop_alarm_monitoring(void);
+int start_power_sampling(int rate_hz, int cpu, const char *sensors);
+int print_power_sampling_stats(int verbose_flag);
+void stop_power_sampling(void);
+int print_iio_capture(int verbose_flag, const char *sysfs_dir, const char *dev_path,
+		const char *trigger, int num_frames);
 int count_hwmon_reg_devices();
 int get_device_hwmon_id(int verbose_flag, char* name);
 int read_sysfs_entry(char* filename, char* entry);
+int print_hwmon_sensor_info(int verbose_flag);
+int benchmark_sensor_reads(int num_ticks);
 
 int print_cma_utilization(int verbose_flag);
 int get_cma_utilization(unsigned long* CmaTotal, unsigned long* CmaFree);
 
 int print_cpu_frequency(int verbose_flag);
+int print_devfreq_info(int verbose_flag);
+int print_thermal_info(int verbose_flag);
+int print_throttle_info(int verbose_flag);
 int get_cpu_frequency(int cpu_id, float* cpu_freq);
+
+#endif /* _PLATFORMSTATS_H_ */
@@ -0,0 +1,556 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "power_sampler.h"
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API initializes a P-square quantile estimator. The estimator keeps
+* five markers and needs constant memory regardless of the number of
+* samples, so p99 can be tracked at kHz rates without storing samples.
+*
+* @param	pq: quantile estimator
+* @param	p: quantile to estimate, e.g. 0.99
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void p2_quantile_init(struct p2_quantile *pq, double p)
+{
+	memset(pq, 0, sizeof(*pq));
+
+	pq->p = p;
+	pq->dn[0] = 0;
+	pq->dn[1] = p / 2;
+	pq->dn[2] = p;
+	pq->dn[3] = (1 + p) / 2;
+	pq->dn[4] = 1;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API compares two doubles for qsort.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int compare_double(const void *a, const void *b)
+{
+	double da = *(const double *)a, db = *(const double *)b;
+
+	return((da > db) - (da < db));
+}
+
+/*****************************************************************************/
+/*
+*
+* This API adds one observation to a P-square quantile estimator.
+*
+* @param	pq: quantile estimator
+* @param	x: observation
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void p2_quantile_add(struct p2_quantile *pq, double x)
+{
+	int i, k;
+
+	if(pq->count < 5)
+	{
+		pq->q[pq->count++] = x;
+
+		if(pq->count == 5)
+		{
+			qsort(pq->q, 5, sizeof(double), compare_double);
+			for(i = 0; i < 5; i++)
+			{
+				pq->n[i] = i + 1;
+			}
+			pq->np[0] = 1;
+			pq->np[1] = 1 + 2 * pq->p;
+			pq->np[2] = 1 + 4 * pq->p;
+			pq->np[3] = 3 + 2 * pq->p;
+			pq->np[4] = 5;
+		}
+		return;
+	}
+
+	if(x < pq->q[0])
+	{
+		pq->q[0] = x;
+		k = 0;
+	}
+	else if(x >= pq->q[4])
+	{
+		pq->q[4] = x;
+		k = 3;
+	}
+	else
+	{
+		for(k = 0; k < 3 && x >= pq->q[k+1]; k++)
+			;
+	}
+
+	for(i = k + 1; i < 5; i++)
+	{
+		pq->n[i]++;
+	}
+	for(i = 0; i < 5; i++)
+	{
+		pq->np[i] += pq->dn[i];
+	}
+	pq->count++;
+
+	for(i = 1; i < 4; i++)
+	{
+		double d = pq->np[i] - pq->n[i];
+
+		if((d >= 1 && pq->n[i+1] - pq->n[i] > 1) ||
+			(d <= -1 && pq->n[i-1] - pq->n[i] < -1))
+		{
+			int ds = d > 0 ? 1 : -1;
+			double qp;
+
+			/* piecewise parabolic prediction */
+			qp = pq->q[i] + ds / (pq->n[i+1] - pq->n[i-1]) *
+				((pq->n[i] - pq->n[i-1] + ds) *
+				 (pq->q[i+1] - pq->q[i]) / (pq->n[i+1] - pq->n[i]) +
+				 (pq->n[i+1] - pq->n[i] - ds) *
+				 (pq->q[i] - pq->q[i-1]) / (pq->n[i] - pq->n[i-1]));
+
+			if(pq->q[i-1] < qp && qp < pq->q[i+1])
+			{
+				pq->q[i] = qp;
+			}
+			else
+			{
+				/* fall back to linear prediction */
+				pq->q[i] += ds * (pq->q[i+ds] - pq->q[i]) /
+					(pq->n[i+ds] - pq->n[i]);
+			}
+			pq->n[i] += ds;
+		}
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API returns the current quantile estimate.
+*
+* @param	pq: quantile estimator
+*
+* @return	quantile estimate, 0 if no observation was added.
+*
+* @note		None.
+*
+******************************************************************************/
+double p2_quantile_value(struct p2_quantile *pq)
+{
+	double sorted[5];
+	int i;
+
+	if(pq->count == 0)
+	{
+		return(0);
+	}
+
+	if(pq->count >= 5)
+	{
+		return(pq->q[2]);
+	}
+
+	memcpy(sorted, pq->q, pq->count * sizeof(double));
+	qsort(sorted, pq->count, sizeof(double), compare_double);
+
+	i = (int)(pq->p * pq->count + 0.5) - 1;
+	if(i < 0)
+	{
+		i = 0;
+	}
+
+	return(sorted[i < pq->count ? i : pq->count - 1]);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API starts a new aggregation window for a channel.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void sampler_window_reset(struct sampler_window *window)
+{
+	memset(window, 0, sizeof(*window));
+	p2_quantile_init(&window->quantile, SAMPLER_QUANTILE);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API folds one sample into the window of a channel. A spike is counted
+* once each time the sample rises more than SAMPLER_SPIKE_RATIO above the
+* running baseline, so a long excursion counts as a single spike.
+*
+* @note		Internal API only. Called with the sampler lock held.
+*
+******************************************************************************/
+static void sampler_channel_add(struct sampler_channel *ch, long value)
+{
+	struct sampler_window *window = &ch->window;
+
+	if(window->count == 0 || value < window->min)
+	{
+		window->min = value;
+	}
+	if(window->count == 0 || value > window->max)
+	{
+		window->max = value;
+	}
+	window->count++;
+	window->sum += value;
+	p2_quantile_add(&window->quantile, value);
+
+	if(ch->baseline == 0)
+	{
+		ch->baseline = value;
+	}
+
+	if(value > ch->baseline * (1 + SAMPLER_SPIKE_RATIO))
+	{
+		if(!ch->in_spike)
+		{
+			window->spikes++;
+		}
+		ch->in_spike = 1;
+	}
+	else
+	{
+		ch->in_spike = 0;
+	}
+
+	ch->baseline += SAMPLER_BASELINE_ALPHA * (value - ch->baseline);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API is the body of the sampling thread. It wakes up on an absolute
+* CLOCK_MONOTONIC schedule, reads every channel and reduces the samples on
+* the fly. Periods missed because reads took too long are counted as
+* overruns and skipped rather than caught up.
+*
+* @param	arg: power sampler
+*
+* @return	NULL.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void *power_sampler_thread(void *arg)
+{
+	struct power_sampler *sampler = arg;
+	struct timespec next, now;
+	long period_ns;
+	long values[SAMPLER_MAX_CHANNELS];
+	int status[SAMPLER_MAX_CHANNELS];
+	int i, running;
+
+	period_ns = 1000000000L / sampler->rate_hz;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+
+	do
+	{
+		long overruns = 0;
+
+		for(i = 0; i < sampler->num_channels; i++)
+		{
+			status[i] = hwmon_sensor_fetch(sampler->channels[i].fd, &values[i]);
+		}
+
+		next.tv_nsec += period_ns;
+		if(next.tv_nsec >= 1000000000L)
+		{
+			next.tv_sec++;
+			next.tv_nsec -= 1000000000L;
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		while(now.tv_sec > next.tv_sec ||
+			(now.tv_sec == next.tv_sec && now.tv_nsec > next.tv_nsec))
+		{
+			next.tv_nsec += period_ns;
+			if(next.tv_nsec >= 1000000000L)
+			{
+				next.tv_sec++;
+				next.tv_nsec -= 1000000000L;
+			}
+			overruns++;
+		}
+
+		pthread_mutex_lock(&sampler->lock);
+		for(i = 0; i < sampler->num_channels; i++)
+		{
+			if(status[i] == 0)
+			{
+				sampler_channel_add(&sampler->channels[i], values[i]);
+			}
+			sampler->channels[i].window.overruns += overruns;
+		}
+		running = sampler->running;
+		pthread_mutex_unlock(&sampler->lock);
+
+		if(running)
+		{
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+		}
+	} while(running);
+
+	return(NULL);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API initializes an idle power sampler without channels.
+*
+* @param	sampler: power sampler
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void power_sampler_init(struct power_sampler *sampler)
+{
+	memset(sampler, 0, sizeof(*sampler));
+	pthread_mutex_init(&sampler->lock, NULL);
+	sampler->cpu = -1;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API adds an hwmon sensor to the sampler. The sampler reads through a
+* private duplicate of the sensor fd, so it is not affected by the sensor
+* table being rebuilt while it runs.
+*
+* @param	sampler: power sampler, not running
+* @param	sensor: hwmon sensor to sample
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int power_sampler_add(struct power_sampler *sampler, struct hwmon_sensor *sensor)
+{
+	struct sampler_channel *ch;
+
+	if(sampler->running)
+	{
+		return(EBUSY);
+	}
+
+	if(sampler->num_channels == SAMPLER_MAX_CHANNELS)
+	{
+		return(ENOSPC);
+	}
+
+	ch = &sampler->channels[sampler->num_channels];
+	memset(ch, 0, sizeof(*ch));
+
+	ch->fd = dup(sensor->fd);
+	if(ch->fd < 0)
+	{
+		return(errno);
+	}
+
+	strcpy(ch->device, sensor->device);
+	strcpy(ch->attr, sensor->attr);
+	strcpy(ch->label, sensor->label);
+	ch->type = sensor->type;
+	sampler_window_reset(&ch->window);
+
+	sampler->num_channels++;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API starts the sampling thread pinned to the given CPU. The affinity
+* is set through the thread attributes, so a CPU that is offline or outside
+* the allowed set makes the start fail instead of leaving the thread
+* unpinned.
+*
+* @param	sampler: power sampler with at least one channel
+* @param	rate_hz: sampling rate, capped to SAMPLER_MAX_RATE_HZ
+* @param	cpu: CPU to pin the thread to, -1 to leave it unpinned
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int power_sampler_start(struct power_sampler *sampler, int rate_hz, int cpu)
+{
+	pthread_attr_t attr;
+	int ret;
+
+	if(sampler->running)
+	{
+		return(EBUSY);
+	}
+
+	if(sampler->num_channels == 0 || rate_hz <= 0)
+	{
+		return(EINVAL);
+	}
+
+	if(cpu >= CPU_SETSIZE)
+	{
+		return(EINVAL);
+	}
+
+	ret = pthread_attr_init(&attr);
+	if(ret)
+	{
+		return(ret);
+	}
+
+	/* pinned from its first instruction, not after it started running */
+	if(cpu >= 0)
+	{
+		cpu_set_t set;
+
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		ret = pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+		if(ret)
+		{
+			pthread_attr_destroy(&attr);
+			return(ret);
+		}
+	}
+
+	sampler->rate_hz = rate_hz > SAMPLER_MAX_RATE_HZ ? SAMPLER_MAX_RATE_HZ : rate_hz;
+	sampler->cpu = cpu;
+	sampler->running = 1;
+
+	ret = pthread_create(&sampler->thread, &attr, power_sampler_thread, sampler);
+	pthread_attr_destroy(&attr);
+	if(ret)
+	{
+		sampler->running = 0;
+		return(ret);
+	}
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API stops the sampling thread and closes the channel fds.
+*
+* @param	sampler: power sampler
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void power_sampler_stop(struct power_sampler *sampler)
+{
+	int i;
+
+	pthread_mutex_lock(&sampler->lock);
+	if(sampler->running)
+	{
+		sampler->running = 0;
+		pthread_mutex_unlock(&sampler->lock);
+		pthread_join(sampler->thread, NULL);
+	}
+	else
+	{
+		pthread_mutex_unlock(&sampler->lock);
+	}
+
+	for(i = 0; i < sampler->num_channels; i++)
+	{
+		close(sampler->channels[i].fd);
+	}
+	sampler->num_channels = 0;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API returns the aggregates of the current window of every channel and
+* starts a new window. Only these aggregates leave the sampler, so the
+* output volume does not depend on the sampling rate.
+*
+* @param	sampler: power sampler
+* @param	reports: array filled with one report per channel
+* @param	max_reports: size of the reports array
+*
+* @return	number of reports filled.
+*
+* @note		None.
+*
+******************************************************************************/
+int power_sampler_report(struct power_sampler *sampler, struct sampler_report *reports,
+		int max_reports)
+{
+	int i;
+
+	pthread_mutex_lock(&sampler->lock);
+
+	for(i = 0; i < sampler->num_channels && i < max_reports; i++)
+	{
+		struct sampler_channel *ch = &sampler->channels[i];
+		struct sampler_report *rep = &reports[i];
+
+		strcpy(rep->device, ch->device);
+		strcpy(rep->label, ch->label);
+		rep->type = ch->type;
+		rep->count = ch->window.count;
+		rep->min = ch->window.min;
+		rep->max = ch->window.max;
+		rep->mean = ch->window.count ? ch->window.sum / ch->window.count : 0;
+		rep->p99 = p2_quantile_value(&ch->window.quantile);
+		rep->spikes = ch->window.spikes;
+		rep->overruns = ch->window.overruns;
+
+		sampler_window_reset(&ch->window);
+	}
+
+	pthread_mutex_unlock(&sampler->lock);
+
+	return(i);
+}
@@ -0,0 +1,87 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+#ifndef _PLATFORMSTATS_POWER_SAMPLER_H_
+#define _PLATFORMSTATS_POWER_SAMPLER_H_
+
+#include <pthread.h>
+
+#include "hwmon.h"
+
+/************************** Constant Definitions *****************************/
+#define SAMPLER_MAX_CHANNELS	16
+#define SAMPLER_MAX_RATE_HZ	1000
+#define SAMPLER_QUANTILE	0.99
+#define SAMPLER_SPIKE_RATIO	0.20	/* spike: 20% above the running baseline */
+#define SAMPLER_BASELINE_ALPHA	0.01	/* weight of a sample in the baseline */
+
+/**************************** Type Definitions *******************************/
+/* P-square streaming quantile estimator (Jain and Chlamtac, 1985) */
+struct p2_quantile {
+	double p;
+	int count;
+	double q[5];			/* marker heights */
+	double n[5];			/* marker positions */
+	double np[5];			/* desired marker positions */
+	double dn[5];			/* desired position increments */
+};
+
+struct sampler_window {
+	long count;
+	long min;
+	long max;
+	double sum;
+	long spikes;
+	long overruns;			/* periods missed because a read ran late */
+	struct p2_quantile quantile;
+};
+
+struct sampler_channel {
+	char device[HWMON_NAME_LEN];
+	char attr[HWMON_ATTR_LEN];
+	char label[HWMON_LABEL_LEN];
+	enum hwmon_sensor_type type;
+	int fd;				/* private dup of the sensor fd */
+	double baseline;		/* exponential moving average */
+	int in_spike;
+	struct sampler_window window;
+};
+
+struct sampler_report {
+	char device[HWMON_NAME_LEN];
+	char label[HWMON_LABEL_LEN];
+	enum hwmon_sensor_type type;
+	long count;
+	long min;
+	long max;
+	double mean;
+	double p99;
+	long spikes;
+	long overruns;
+};
+
+struct power_sampler {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	int running;
+	int rate_hz;
+	int cpu;			/* CPU the thread is pinned to, -1 for none */
+	int num_channels;
+	struct sampler_channel channels[SAMPLER_MAX_CHANNELS];
+};
+
+/************************** Function Prototypes  *****************************/
+void p2_quantile_init(struct p2_quantile *pq, double p);
+void p2_quantile_add(struct p2_quantile *pq, double x);
+double p2_quantile_value(struct p2_quantile *pq);
+
+void power_sampler_init(struct power_sampler *sampler);
+int power_sampler_add(struct power_sampler *sampler, struct hwmon_sensor *sensor);
+int power_sampler_start(struct power_sampler *sampler, int rate_hz, int cpu);
+void power_sampler_stop(struct power_sampler *sampler);
+int power_sampler_report(struct power_sampler *sampler, struct sampler_report *reports,
+		int max_reports);
+
+#endif /* _PLATFORMSTATS_POWER_SAMPLER_H_ */
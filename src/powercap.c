@@ -0,0 +1,213 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+
+#include "powercap.h"
+#include "utils.h"
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API reads an unsigned counter with pread from offset 0 of an open
+* attribute.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int powercap_fetch(int fd, unsigned long long *value)
+{
+	char buf[32];
+	ssize_t len;
+
+	len = pread(fd, buf, sizeof(buf) - 1, 0);
+	if(len < 0)
+	{
+		return(errno);
+	}
+
+	return(parse_ulonglong(buf, len, value));
+}
+
+/*****************************************************************************/
+/*
+*
+* This API scans /sys/class/powercap once and opens energy_uj of every zone
+* that has one. The fds stay open, so each later read is a single pread.
+* Zones whose counter is not readable (energy_uj is root only on recent
+* kernels) are skipped.
+*
+* @param	pc: powercap index to populate
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int powercap_init(struct powercap_index *pc)
+{
+	DIR *d;
+	struct dirent *dir;
+	int class_fd;
+
+	powercap_release(pc);
+
+	d = opendir(POWERCAP_CLASS_PATH);
+	if(!d)
+	{
+		return(errno);
+	}
+
+	class_fd = dirfd(d);
+
+	while((dir = readdir(d)) != NULL && pc->num_domains < MAX_POWERCAP_DOMAINS)
+	{
+		struct powercap_domain *dom = &pc->domains[pc->num_domains];
+		char buf[32];
+		int zone_fd;
+
+		if(dir->d_name[0] == '.')
+		{
+			continue;
+		}
+
+		zone_fd = openat(class_fd, dir->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if(zone_fd < 0)
+		{
+			continue;
+		}
+
+		memset(dom, 0, sizeof(*dom));
+		dom->fd = openat(zone_fd, "energy_uj", O_RDONLY | O_CLOEXEC);
+		if(dom->fd < 0)
+		{
+			close(zone_fd);
+			continue;
+		}
+
+		snprintf(dom->zone, sizeof(dom->zone), "%.63s", dir->d_name);
+		if(read_sysfs_string(zone_fd, "name", dom->name, sizeof(dom->name)))
+		{
+			snprintf(dom->name, sizeof(dom->name), "%.63s", dir->d_name);
+		}
+
+		if(read_sysfs_string(zone_fd, "max_energy_range_uj", buf, sizeof(buf)) ||
+			parse_ulonglong(buf, strlen(buf), &dom->max_range_uj))
+		{
+			dom->max_range_uj = 0;
+		}
+
+		close(zone_fd);
+		pc->num_domains++;
+	}
+
+	closedir(d);
+
+	pc->valid = 1;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API closes all energy counter fds held by the index.
+*
+* @param	pc: powercap index
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void powercap_release(struct powercap_index *pc)
+{
+	int i;
+
+	for(i = 0; i < pc->num_domains; i++)
+	{
+		close(pc->domains[i].fd);
+	}
+
+	pc->num_domains = 0;
+	pc->valid = 0;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads the energy counter of every domain and adds the energy since
+* the previous reading to the domain accumulator. A counter lower than its
+* previous reading has wrapped past max_energy_range_uj, so the distance to
+* the end of the range is added back. Without a known range the interval is
+* dropped and the counter is re-primed.
+*
+* @param	pc: powercap index
+*
+* @return	number of domains read successfully.
+*
+* @note		None.
+*
+******************************************************************************/
+int powercap_read(struct powercap_index *pc)
+{
+	struct timespec now;
+	int i, num_read;
+
+	num_read = 0;
+
+	for(i = 0; i < pc->num_domains; i++)
+	{
+		struct powercap_domain *dom = &pc->domains[i];
+		unsigned long long uj, delta;
+
+		dom->status = powercap_fetch(dom->fd, &uj);
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if(dom->status)
+		{
+			continue;
+		}
+		num_read++;
+
+		if(!dom->primed)
+		{
+			/* first reading only sets the reference point */
+			energy_accum_add_energy(&dom->energy, 0, &now);
+			dom->last_uj = uj;
+			dom->primed = 1;
+			continue;
+		}
+
+		if(uj >= dom->last_uj)
+		{
+			delta = uj - dom->last_uj;
+		}
+		else if(dom->max_range_uj >= dom->last_uj)
+		{
+			delta = dom->max_range_uj - dom->last_uj + uj;
+			dom->wraps++;
+		}
+		else
+		{
+			dom->energy.last_time = now;
+			dom->last_uj = uj;
+			continue;
+		}
+
+		energy_accum_add_energy(&dom->energy, delta / 1e6, &now);
+		dom->last_uj = uj;
+	}
+
+	return(num_read);
+}
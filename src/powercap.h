@@ -0,0 +1,47 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+#ifndef _PLATFORMSTATS_POWERCAP_H_
+#define _PLATFORMSTATS_POWERCAP_H_
+
+#include <time.h>
+
+#include "energy.h"
+
+/************************** Constant Definitions *****************************/
+#define POWERCAP_CLASS_PATH	"/sys/class/powercap"
+#define MAX_POWERCAP_DOMAINS	32
+#define POWERCAP_NAME_LEN	64
+
+/**************************** Type Definitions *******************************/
+/*
+ * One powercap zone with an energy counter, e.g. intel-rapl:0 (package-0) or
+ * intel-rapl:0:1 (dram). The counter counts up in uJ and wraps to 0 past
+ * max_energy_range_uj.
+ */
+struct powercap_domain {
+	char zone[POWERCAP_NAME_LEN];	/* directory name under powercap */
+	char name[POWERCAP_NAME_LEN];	/* contents of <zone>/name */
+	int fd;				/* open fd of <zone>/energy_uj */
+	unsigned long long max_range_uj;	/* 0 if unknown */
+	unsigned long long last_uj;	/* previous counter reading */
+	int primed;			/* last_uj holds a valid reading */
+	int status;			/* 0 if the last read succeeded, errno otherwise */
+	unsigned long wraps;		/* number of wraparounds seen */
+	struct energy_accum energy;
+};
+
+struct powercap_index {
+	int valid;
+	int num_domains;
+	struct powercap_domain domains[MAX_POWERCAP_DOMAINS];
+};
+
+/************************** Function Prototypes  *****************************/
+int powercap_init(struct powercap_index *pc);
+void powercap_release(struct powercap_index *pc);
+int powercap_read(struct powercap_index *pc);
+
+#endif /* _PLATFORMSTATS_POWERCAP_H_ */
@@ -0,0 +1,569 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include "proc_power.h"
+#include "utils.h"
+
+/************************** Constant Definitions *****************************/
+#define PROC_STAT_LEN		1024
+#define PROC_STAT_UTIME		14	/* field numbers as in proc(5) */
+#define PROC_STAT_STIME		15
+#define PROC_STAT_STARTTIME	22
+#define PROC_STAT_PROCESSOR	39
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API compares two pids for qsort.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int pid_compare(const void *a, const void *b)
+{
+	return(*(const int *)a - *(const int *)b);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads /proc/<pid>/stat of a process through its cached fd, or
+* by opening it when the fd is not cached, and extracts the CPU time, start
+* time and last CPU. The comm is copied out if comm is not NULL.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int proc_read_stat(struct proc_power_table *tab, struct proc_power_entry *e,
+		unsigned long long *ticks, unsigned long long *starttime, char *comm)
+{
+	char buf[PROC_STAT_LEN + 1], path[32];
+	char *open_paren, *close_paren, *tok, *save;
+	unsigned long long utime = 0, stime = 0;
+	ssize_t len;
+	int fd, field;
+
+	if(e->fd >= 0)
+	{
+		len = pread(e->fd, buf, PROC_STAT_LEN, 0);
+	}
+	else
+	{
+		snprintf(path, sizeof(path), "%d/stat", e->pid);
+		fd = openat(dirfd(tab->proc_dir), path, O_RDONLY | O_CLOEXEC);
+		if(fd < 0)
+		{
+			return(errno);
+		}
+		len = pread(fd, buf, PROC_STAT_LEN, 0);
+		close(fd);
+	}
+
+	if(len <= 0)
+	{
+		return(len < 0 ? errno : ESRCH);
+	}
+	buf[len] = '\0';
+
+	/* comm may itself contain spaces and parentheses */
+	open_paren = strchr(buf, '(');
+	close_paren = strrchr(buf, ')');
+	if(open_paren == NULL || close_paren == NULL || close_paren < open_paren)
+	{
+		return(EINVAL);
+	}
+
+	if(comm != NULL)
+	{
+		snprintf(comm, PROC_COMM_LEN, "%.*s", (int)(close_paren - open_paren - 1),
+			open_paren + 1);
+	}
+
+	field = 3;
+	for(tok = strtok_r(close_paren + 1, " ", &save); tok != NULL;
+		tok = strtok_r(NULL, " ", &save), field++)
+	{
+		if(field == PROC_STAT_UTIME)
+		{
+			utime = strtoull(tok, NULL, 10);
+		}
+		else if(field == PROC_STAT_STIME)
+		{
+			stime = strtoull(tok, NULL, 10);
+		}
+		else if(field == PROC_STAT_STARTTIME)
+		{
+			*starttime = strtoull(tok, NULL, 10);
+		}
+		else if(field == PROC_STAT_PROCESSOR)
+		{
+			e->cpu = atoi(tok);
+			break;
+		}
+	}
+
+	if(field < PROC_STAT_STARTTIME)
+	{
+		return(EINVAL);
+	}
+
+	*ticks = utime + stime;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API records the cgroup of a process from /proc/<pid>/cgroup: the
+* unified hierarchy if present, otherwise the first one listed.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void proc_read_cgroup(struct proc_power_table *tab, struct proc_power_entry *e)
+{
+	char buf[512], path[32];
+	char *line, *save, *cgroup = NULL;
+	ssize_t len;
+	int fd;
+
+	e->cgroup[0] = '\0';
+
+	snprintf(path, sizeof(path), "%d/cgroup", e->pid);
+	fd = openat(dirfd(tab->proc_dir), path, O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+	{
+		return;
+	}
+	len = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if(len <= 0)
+	{
+		return;
+	}
+	buf[len] = '\0';
+
+	for(line = strtok_r(buf, "\n", &save); line != NULL;
+		line = strtok_r(NULL, "\n", &save))
+	{
+		char *path_start = strrchr(line, ':');
+
+		if(path_start == NULL)
+		{
+			continue;
+		}
+		if(cgroup == NULL || !strncmp(line, "0::", 3))
+		{
+			cgroup = path_start + 1;
+		}
+	}
+
+	if(cgroup)
+	{
+		snprintf(e->cgroup, sizeof(e->cgroup), "%s", cgroup);
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API starts tracking a process: it caches the fd of its stat file if
+* the fd budget allows, and records its comm and cgroup.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int proc_entry_open(struct proc_power_table *tab, struct proc_power_entry *e,
+		int pid)
+{
+	char path[32];
+	int ret;
+
+	memset(e, 0, sizeof(*e));
+	e->pid = pid;
+	e->fd = -1;
+
+	if(tab->num_fds < MAX_PROC_FDS)
+	{
+		snprintf(path, sizeof(path), "%d/stat", pid);
+		e->fd = openat(dirfd(tab->proc_dir), path, O_RDONLY | O_CLOEXEC);
+		if(e->fd < 0)
+		{
+			return(errno);
+		}
+		tab->num_fds++;
+	}
+
+	ret = proc_read_stat(tab, e, &e->ticks, &e->starttime, e->comm);
+	if(ret)
+	{
+		return(ret);
+	}
+
+	proc_read_cgroup(tab, e);
+	tab->new_procs++;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API stops tracking a process.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void proc_entry_close(struct proc_power_table *tab, struct proc_power_entry *e)
+{
+	if(e->fd >= 0)
+	{
+		close(e->fd);
+		tab->num_fds--;
+		e->fd = -1;
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API opens /proc for the process table and the cpufreq statistics
+* used to weight CPU time by frequency.
+*
+* @param	tab: process power table to initialize
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int proc_power_init(struct proc_power_table *tab)
+{
+	proc_power_release(tab);
+	memset(tab, 0, sizeof(*tab));
+
+	tab->proc_dir = opendir(PROC_PATH);
+	if(tab->proc_dir == NULL)
+	{
+		return(errno);
+	}
+
+	tab->clk_tck = sysconf(_SC_CLK_TCK);
+	if(tab->clk_tck <= 0)
+	{
+		tab->clk_tck = 100;
+	}
+
+	cpu_power_init(&tab->freq);
+
+	tab->rls_p[0][0] = tab->rls_p[1][1] = 1e3;
+	tab->valid = 1;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API closes all fds held by the process power table.
+*
+* @param	tab: process power table
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void proc_power_release(struct proc_power_table *tab)
+{
+	int i;
+
+	for(i = 0; i < tab->num_entries; i++)
+	{
+		proc_entry_close(tab, &tab->entries[tab->cur][i]);
+	}
+	tab->num_entries = 0;
+
+	if(tab->proc_dir)
+	{
+		closedir(tab->proc_dir);
+		tab->proc_dir = NULL;
+	}
+
+	cpu_power_release(&tab->freq);
+	tab->valid = 0;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API returns the frequency of the cluster of a CPU over the window
+* relative to its maximum, 1 if unknown.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static double proc_power_freq_ratio(struct cpu_power_model *freq, int cpu)
+{
+	int i, j;
+
+	for(i = 0; i < freq->num_clusters; i++)
+	{
+		struct cpu_cluster *cl = &freq->clusters[i];
+		double residency = 0, khz = 0, max_khz = 0;
+		int found = 0;
+
+		for(j = 0; j < cl->num_cpus; j++)
+		{
+			if(cl->cpus[j] == cpu)
+			{
+				found = 1;
+			}
+		}
+		if(!found)
+		{
+			continue;
+		}
+
+		for(j = 0; j < cl->num_opps; j++)
+		{
+			residency += cl->opps[j].delta_s;
+			khz += cl->opps[j].delta_s * cl->opps[j].khz;
+			if(cl->opps[j].khz > max_khz)
+			{
+				max_khz = cl->opps[j].khz;
+			}
+		}
+
+		return(residency > 0 && max_khz > 0 ? khz / residency / max_khz : 1);
+	}
+
+	return(1);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API updates the online fit of P = base + k * load with one sample,
+* by recursive least squares with exponential forgetting so that the fit
+* follows slow drifts such as temperature.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void proc_power_fit(struct proc_power_table *tab, double load, double watts)
+{
+	double x[2] = { 1, load };
+	double px[2], gain[2], denom, err;
+	int i, j;
+
+	for(i = 0; i < 2; i++)
+	{
+		px[i] = tab->rls_p[i][0] * x[0] + tab->rls_p[i][1] * x[1];
+	}
+
+	denom = PROC_POWER_FORGET + x[0] * px[0] + x[1] * px[1];
+	err = watts - (tab->rls_theta[0] * x[0] + tab->rls_theta[1] * x[1]);
+
+	for(i = 0; i < 2; i++)
+	{
+		gain[i] = px[i] / denom;
+		tab->rls_theta[i] += gain[i] * err;
+	}
+
+	for(i = 0; i < 2; i++)
+	{
+		for(j = 0; j < 2; j++)
+		{
+			tab->rls_p[i][j] = (tab->rls_p[i][j] - gain[i] * px[j]) /
+				PROC_POWER_FORGET;
+		}
+	}
+
+	tab->rls_samples++;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API advances the process table by one window and attributes the
+* measured power over it. The pids in /proc are merged with the sorted
+* table: known processes are carried over with their counters, new ones
+* are opened and exited ones are closed, so each update costs one stat read
+* per live process. A process first seen in a window, including one that
+* reused a pid, is charged all of its CPU time.
+*
+* Each process is weighted by its CPU time in the window times the cube of
+* the relative frequency of its cluster. Once the online fit is trusted, the
+* base power it estimates is set aside and the rest is split by weight;
+* until then all measured power is split by weight.
+*
+* @param	tab: process power table
+* @param	measured_joules: energy measured over the window, the power
+*		attributed is its average over the window
+*
+* @return	1 if a window was attributed, 0 on the first call.
+*
+* @note		None.
+*
+******************************************************************************/
+int proc_power_update(struct proc_power_table *tab, double measured_joules)
+{
+	struct proc_power_entry *old, *new;
+	struct dirent *dir;
+	struct timespec now;
+	double measured_watts, dyn_watts;
+	int num_pids, num_new, i, j, primed;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	primed = tab->primed;
+	tab->window_s = primed ? (now.tv_sec - tab->last.tv_sec) +
+		(now.tv_nsec - tab->last.tv_nsec) / 1e9 : 0;
+	tab->last = now;
+	tab->primed = 1;
+
+	cpu_power_update(&tab->freq);
+
+	num_pids = 0;
+	rewinddir(tab->proc_dir);
+	while((dir = readdir(tab->proc_dir)) != NULL && num_pids < MAX_PROC_ENTRIES)
+	{
+		char *end;
+		long pid = strtol(dir->d_name, &end, 10);
+
+		if(*end == '\0' && pid > 0)
+		{
+			tab->pids[num_pids++] = pid;
+		}
+	}
+	qsort(tab->pids, num_pids, sizeof(tab->pids[0]), pid_compare);
+
+	old = tab->entries[tab->cur];
+	new = tab->entries[!tab->cur];
+	num_new = 0;
+	tab->total_weight = 0;
+
+	for(i = 0, j = 0; j < num_pids; j++)
+	{
+		struct proc_power_entry *e = &new[num_new];
+		unsigned long long ticks, starttime;
+
+		for(; i < tab->num_entries && old[i].pid < tab->pids[j]; i++)
+		{
+			proc_entry_close(tab, &old[i]);
+			tab->exited_procs++;
+		}
+
+		if(i < tab->num_entries && old[i].pid == tab->pids[j])
+		{
+			*e = old[i++];
+			if(proc_read_stat(tab, e, &ticks, &starttime, NULL))
+			{
+				proc_entry_close(tab, e);
+				tab->exited_procs++;
+				continue;
+			}
+
+			if(starttime != e->starttime)
+			{
+				/* pid reused by a new process */
+				proc_entry_close(tab, e);
+				tab->exited_procs++;
+				if(proc_entry_open(tab, e, tab->pids[j]))
+				{
+					proc_entry_close(tab, e);
+					continue;
+				}
+				ticks = e->ticks;
+				e->ticks = 0;
+			}
+		}
+		else
+		{
+			if(proc_entry_open(tab, e, tab->pids[j]))
+			{
+				proc_entry_close(tab, e);
+				continue;
+			}
+			/* started in the window, so all its CPU time was spent in it */
+			ticks = e->ticks;
+			e->ticks = 0;
+		}
+
+		e->cpu_s = ticks >= e->ticks ? (double)(ticks - e->ticks) / tab->clk_tck : 0;
+		e->ticks = ticks;
+		e->weight = e->cpu_s;
+		if(e->cpu_s > 0)
+		{
+			double r = proc_power_freq_ratio(&tab->freq, e->cpu);
+
+			e->weight = e->cpu_s * r * r * r;
+		}
+		tab->total_weight += e->weight;
+		num_new++;
+	}
+
+	for(; i < tab->num_entries; i++)
+	{
+		proc_entry_close(tab, &old[i]);
+		tab->exited_procs++;
+	}
+
+	tab->cur = !tab->cur;
+	tab->num_entries = num_new;
+
+	if(!primed || tab->window_s <= 0)
+	{
+		return(0);
+	}
+
+	measured_watts = measured_joules / tab->window_s;
+	tab->measured_watts = measured_watts;
+	proc_power_fit(tab, tab->total_weight / tab->window_s, measured_watts);
+
+	tab->base_watts = 0;
+	if(tab->rls_samples >= PROC_POWER_MIN_SAMPLES && tab->rls_theta[1] > 0)
+	{
+		tab->base_watts = tab->rls_theta[0];
+		if(tab->base_watts < 0)
+		{
+			tab->base_watts = 0;
+		}
+		else if(tab->base_watts > measured_watts)
+		{
+			tab->base_watts = measured_watts;
+		}
+	}
+
+	dyn_watts = measured_watts - tab->base_watts;
+	if(tab->total_weight <= 0)
+	{
+		tab->base_watts = measured_watts;
+		dyn_watts = 0;
+	}
+
+	for(i = 0; i < tab->num_entries; i++)
+	{
+		struct proc_power_entry *e = &tab->entries[tab->cur][i];
+
+		e->watts = tab->total_weight > 0 ?
+			dyn_watts * e->weight / tab->total_weight : 0;
+		e->joules += e->watts * tab->window_s;
+	}
+
+	return(1);
+}
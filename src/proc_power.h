@@ -0,0 +1,79 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+#ifndef _PLATFORMSTATS_PROC_POWER_H_
+#define _PLATFORMSTATS_PROC_POWER_H_
+
+#include <dirent.h>
+#include <time.h>
+
+#include "cpu_power.h"
+
+/************************** Constant Definitions *****************************/
+#define PROC_PATH		"/proc"
+#define MAX_PROC_ENTRIES	2048
+#define MAX_PROC_FDS		256	/* stat files kept open, the rest reopened each tick */
+#define PROC_COMM_LEN		32
+#define PROC_CGROUP_LEN		64
+#define PROC_POWER_FORGET	0.98	/* regression forgetting factor per update */
+#define PROC_POWER_MIN_SAMPLES	10	/* updates before the regression is trusted */
+#define PROC_POWER_TOP		10	/* processes printed without verbose */
+
+/**************************** Type Definitions *******************************/
+/*
+ * Counters of one process, carried from one update to the next so that each
+ * update only reads /proc/<pid>/stat once per process.
+ */
+struct proc_power_entry {
+	int pid;
+	int fd;				/* open fd of /proc/<pid>/stat, -1 if not cached */
+	unsigned long long starttime;	/* tells a reused pid apart */
+	char comm[PROC_COMM_LEN];
+	char cgroup[PROC_CGROUP_LEN];	/* cgroup v2 path, or first hierarchy */
+	unsigned long long ticks;	/* utime + stime */
+	int cpu;			/* CPU the process last ran on */
+	double cpu_s;			/* CPU time in the window */
+	double weight;			/* cpu_s scaled by the cube of the relative frequency */
+	double watts;			/* power attributed in the window */
+	double joules;			/* energy attributed since the process was first seen */
+};
+
+/*
+ * Attributes measured power to processes in proportion to their frequency
+ * weighted CPU time. The power not explained by CPU activity is estimated
+ * by an online least squares fit P = base + k * sum(weight) / window and is
+ * reported separately as base power.
+ */
+struct proc_power_table {
+	int valid;
+	int primed;
+	DIR *proc_dir;
+	long clk_tck;
+	struct timespec last;		/* CLOCK_MONOTONIC time of previous update */
+	double window_s;
+	struct cpu_power_model freq;	/* frequency residency of the clusters */
+	int cur;			/* entries[cur] holds the live processes */
+	int num_entries;
+	struct proc_power_entry entries[2][MAX_PROC_ENTRIES];
+	int pids[MAX_PROC_ENTRIES];
+	int num_fds;
+	unsigned long new_procs;
+	unsigned long exited_procs;
+	double measured_watts;		/* average over the window */
+	double base_watts;
+	double total_weight;
+
+	/* recursive least squares state of the base power fit */
+	int rls_samples;
+	double rls_p[2][2];
+	double rls_theta[2];
+};
+
+/************************** Function Prototypes  *****************************/
+int proc_power_init(struct proc_power_table *tab);
+void proc_power_release(struct proc_power_table *tab);
+int proc_power_update(struct proc_power_table *tab, double measured_joules);
+
+#endif /* _PLATFORMSTATS_PROC_POWER_H_ */
@@ -0,0 +1,256 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "procfs.h"
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API reads a proc or sysfs file from its start through an fd kept
+* open between reads, and NUL terminates it. Text that does not fit is cut.
+*
+* @param	fd: open fd of the file
+* @param	buf: buffer to hold the text
+* @param	size: size of buf
+* @param	len: number of bytes read
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int procfs_read(int fd, char *buf, size_t size, size_t *len)
+{
+	ssize_t bytes_read;
+
+	bytes_read = pread(fd, buf, size - 1, 0);
+	if(bytes_read < 0)
+	{
+		return(errno);
+	}
+
+	buf[bytes_read] = '\0';
+	*len = bytes_read;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API parses an unsigned decimal field and advances past it.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static unsigned long procfs_next_ulong(const char **p)
+{
+	const char *s = *p;
+	unsigned long value = 0;
+
+	while(*s == ' ' || *s == '\t')
+	{
+		s++;
+	}
+	for(; *s >= '0' && *s <= '9'; s++)
+	{
+		value = value * 10 + (*s - '0');
+	}
+
+	*p = s;
+
+	return(value);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API parses the per CPU lines of /proc/stat into cpus, indexed by CPU
+* id. The aggregate "cpu" line is skipped and parsing stops at the first line
+* that is not a CPU line. CPUs absent from the text, offline ones included,
+* get ENOENT in status.
+*
+* @param	buf: NUL terminated text of /proc/stat
+* @param	cpus: counters, max_cpus entries
+* @param	status: per CPU status, max_cpus entries
+* @param	max_cpus: number of CPUs that fit in cpus
+*
+* @return	number of CPUs parsed.
+*
+* @note		None.
+*
+******************************************************************************/
+int procfs_parse_stat(const char *buf, struct cpustat *cpus, int *status, int max_cpus)
+{
+	const char *p;
+	int i, num_cpus = 0;
+
+	for(i = 0; i < max_cpus; i++)
+	{
+		status[i] = ENOENT;
+	}
+
+	for(p = buf; !strncmp(p, "cpu", 3); p = strchr(p, '\n') + 1)
+	{
+		struct cpustat *st;
+		int id;
+
+		if(p[3] >= '0' && p[3] <= '9')
+		{
+			p += 3;
+			id = (int)procfs_next_ulong(&p);
+			if(id < max_cpus)
+			{
+				st = &cpus[id];
+				st->user = procfs_next_ulong(&p);
+				st->nice = procfs_next_ulong(&p);
+				st->system = procfs_next_ulong(&p);
+				st->idle = procfs_next_ulong(&p);
+				st->iowait = procfs_next_ulong(&p);
+				st->irq = procfs_next_ulong(&p);
+				st->softirq = procfs_next_ulong(&p);
+				status[id] = 0;
+				num_cpus++;
+			}
+		}
+
+		if(strchr(p, '\n') == NULL)
+		{
+			break;
+		}
+	}
+
+	return(num_cpus);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API looks up "Key: value kB" lines of /proc/meminfo by key, so the
+* values do not depend on the position of the lines, which varies with the
+* kernel configuration. Keys absent from the text get ENOENT in status.
+*
+* @param	buf: NUL terminated text of /proc/meminfo
+* @param	keys: keys without the colon, e.g. "MemTotal"
+* @param	values: values in kB, num_keys entries
+* @param	status: per key status, num_keys entries
+* @param	num_keys: number of keys
+*
+* @return	number of keys found.
+*
+* @note		None.
+*
+******************************************************************************/
+int procfs_parse_meminfo(const char *buf, const char *const *keys,
+		unsigned long *values, int *status, int num_keys)
+{
+	const char *p;
+	int i, found = 0;
+
+	for(i = 0; i < num_keys; i++)
+	{
+		status[i] = ENOENT;
+	}
+
+	for(p = buf; *p; p++)
+	{
+		const char *colon = strchr(p, ':');
+		const char *eol;
+
+		if(colon == NULL)
+		{
+			break;
+		}
+
+		for(i = 0; i < num_keys; i++)
+		{
+			size_t key_len = strlen(keys[i]);
+
+			if(status[i] && (size_t)(colon - p) == key_len &&
+				!strncmp(p, keys[i], key_len))
+			{
+				const char *v = colon + 1;
+
+				values[i] = procfs_next_ulong(&v);
+				status[i] = 0;
+				found++;
+				break;
+			}
+		}
+
+		eol = strchr(colon, '\n');
+		if(eol == NULL || found == num_keys)
+		{
+			break;
+		}
+		p = eol;
+	}
+
+	return(found);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API parses the "cpu MHz" field of every processor block of
+* /proc/cpuinfo. Architectures that do not report it, such as arm64, leave
+* ENOENT in status.
+*
+* @param	buf: NUL terminated text of /proc/cpuinfo
+* @param	mhz: frequencies, max_cpus entries
+* @param	status: per CPU status, max_cpus entries
+* @param	max_cpus: number of CPUs that fit in mhz
+*
+* @return	number of CPUs parsed.
+*
+* @note		None.
+*
+******************************************************************************/
+int procfs_parse_cpuinfo_mhz(const char *buf, float *mhz, int *status, int max_cpus)
+{
+	const char *p;
+	int i, cpu = -1, found = 0;
+
+	for(i = 0; i < max_cpus; i++)
+	{
+		status[i] = ENOENT;
+	}
+
+	for(p = buf; p != NULL && *p; p = strchr(p, '\n'), p = p ? p + 1 : NULL)
+	{
+		const char *colon;
+
+		if(!strncmp(p, "processor", 9))
+		{
+			colon = strchr(p, ':');
+			if(colon != NULL)
+			{
+				const char *v = colon + 1;
+
+				cpu = (int)procfs_next_ulong(&v);
+			}
+		}
+		else if(!strncmp(p, "cpu MHz", 7) && cpu >= 0 && cpu < max_cpus)
+		{
+			colon = strchr(p, ':');
+			if(colon != NULL)
+			{
+				mhz[cpu] = strtof(colon + 1, NULL);
+				status[cpu] = 0;
+				found++;
+			}
+		}
+	}
+
+	return(found);
+}
@@ -0,0 +1,31 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+#ifndef _PLATFORMSTATS_PROCFS_H_
+#define _PLATFORMSTATS_PROCFS_H_
+
+#include <stddef.h>
+
+#include "platformstats.h"
+
+/************************** Constant Definitions *****************************/
+#define PROC_STAT_PATH		"/proc/stat"
+#define PROC_MEMINFO_PATH	"/proc/meminfo"
+#define PROC_CPUINFO_PATH	"/proc/cpuinfo"
+#define CPUFREQ_CUR_FMT		"/sys/devices/system/cpu/cpu%d/cpufreq/scaling_cur_freq"
+
+/* Text read per file for n CPUs. Only the cpuN lines of /proc/stat are needed */
+#define PROC_STAT_BUF_LEN(n)	(128 + (n) * 128)
+#define PROC_MEMINFO_BUF_LEN	4096
+#define PROC_CPUINFO_BUF_LEN(n)	((n) * 4096)
+
+/************************** Function Prototypes  *****************************/
+int procfs_read(int fd, char *buf, size_t size, size_t *len);
+int procfs_parse_stat(const char *buf, struct cpustat *cpus, int *status, int max_cpus);
+int procfs_parse_meminfo(const char *buf, const char *const *keys,
+		unsigned long *values, int *status, int num_keys);
+int procfs_parse_cpuinfo_mhz(const char *buf, float *mhz, int *status, int max_cpus);
+
+#endif /* _PLATFORMSTATS_PROCFS_H_ */
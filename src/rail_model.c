@@ -0,0 +1,337 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rail_model.h"
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API returns the index of a rail group, adding the group if it does not
+* exist yet.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int rail_model_group(struct rail_model *model, const char *name)
+{
+	struct rail_group *group;
+	int i;
+
+	for(i = 0; i < model->num_groups; i++)
+	{
+		if(!strcmp(model->groups[i].name, name))
+		{
+			return(i);
+		}
+	}
+
+	if(model->num_groups == MAX_RAIL_GROUPS)
+	{
+		return(-1);
+	}
+
+	group = &model->groups[model->num_groups];
+	memset(group, 0, sizeof(*group));
+	snprintf(group->name, sizeof(group->name), "%s", name);
+
+	return(model->num_groups++);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API parses one line of a rail file into the model.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int rail_model_parse_line(struct rail_model *model, char *line)
+{
+	char *tok[7];
+	char *save;
+	int num_tok, group;
+
+	num_tok = 0;
+	for(tok[0] = strtok_r(line, " \t\r\n", &save); tok[num_tok] != NULL;
+		tok[num_tok] = strtok_r(NULL, " \t\r\n", &save))
+	{
+		if(tok[num_tok][0] == '#' || ++num_tok == 7)
+		{
+			break;
+		}
+	}
+
+	if(num_tok == 0)
+	{
+		return(0);
+	}
+
+	if(!strcmp(tok[0], "group") && (num_tok == 2 || num_tok == 3))
+	{
+		group = rail_model_group(model, tok[1]);
+		if(group < 0)
+		{
+			return(ENOSPC);
+		}
+
+		if(num_tok == 3)
+		{
+			char *end;
+
+			model->groups[group].budget_watts = strtod(tok[2], &end);
+			if(*end != '\0' || model->groups[group].budget_watts < 0)
+			{
+				return(EINVAL);
+			}
+		}
+		return(0);
+	}
+
+	if(!strcmp(tok[0], "rail") && (num_tok == 5 || num_tok == 6))
+	{
+		struct rail *rail;
+
+		if(model->num_rails == MAX_RAILS)
+		{
+			return(ENOSPC);
+		}
+
+		group = rail_model_group(model, tok[2]);
+		if(group < 0)
+		{
+			return(ENOSPC);
+		}
+
+		rail = &model->rails[model->num_rails];
+		memset(rail, 0, sizeof(*rail));
+		snprintf(rail->name, sizeof(rail->name), "%s", tok[1]);
+		snprintf(rail->device, sizeof(rail->device), "%s", tok[3]);
+		rail->group = group;
+
+		if(num_tok == 5)
+		{
+			snprintf(rail->power_attr, sizeof(rail->power_attr), "%s", tok[4]);
+		}
+		else
+		{
+			snprintf(rail->curr_attr, sizeof(rail->curr_attr), "%s", tok[4]);
+			snprintf(rail->volt_attr, sizeof(rail->volt_attr), "%s", tok[5]);
+		}
+
+		model->groups[group].num_rails++;
+		model->num_rails++;
+		return(0);
+	}
+
+	return(EINVAL);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API loads a rail model from a text file. Each line is one of
+*
+*	group <group> [<budget W>]
+*	rail <rail> <group> <device> <power attr>
+*	rail <rail> <group> <device> <current attr> <voltage attr>
+*
+* where <device> is an hwmon device name, name@parent (e.g. ina226@1-0040)
+* when several chips share a driver, or hwmonN. Groups referenced by a rail
+* are created on the fly; a group line sets the budget of the group. Text
+* after '#' is ignored.
+*
+* @param	model: rail model to fill
+* @param	path: rail file
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int rail_model_load(struct rail_model *model, const char *path)
+{
+	FILE *fp;
+	char line[256];
+	int line_no, ret;
+
+	memset(model, 0, sizeof(*model));
+
+	fp = fopen(path, "r");
+	if(fp == NULL)
+	{
+		return(errno);
+	}
+
+	line_no = 0;
+	ret = 0;
+
+	while(fgets(line, sizeof(line), fp) != NULL)
+	{
+		line_no++;
+
+		ret = rail_model_parse_line(model, line);
+		if(ret)
+		{
+			printf("%s:%d: invalid rail definition\n", path, line_no);
+			break;
+		}
+	}
+
+	fclose(fp);
+
+	if(ret)
+	{
+		memset(model, 0, sizeof(*model));
+		return(ret);
+	}
+
+	model->loaded = 1;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API resolves the sensors of every rail against the sensor table.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void rail_model_bind(struct rail_model *model, struct hwmon_sensor_table *tbl)
+{
+	int i;
+
+	for(i = 0; i < model->num_rails; i++)
+	{
+		struct rail *rail = &model->rails[i];
+
+		rail->power = NULL;
+		rail->curr = NULL;
+		rail->volt = NULL;
+
+		if(rail->power_attr[0])
+		{
+			rail->power = hwmon_sensor_lookup(tbl, rail->device, rail->power_attr);
+		}
+		else
+		{
+			rail->curr = hwmon_sensor_lookup(tbl, rail->device, rail->curr_attr);
+			rail->volt = hwmon_sensor_lookup(tbl, rail->device, rail->volt_attr);
+		}
+	}
+
+	model->generation = tbl->generation;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads every rail of the model in a single pass and recomputes the
+* per group totals and the headroom against the group budgets. The sensors
+* of all rails are read together, so monitors on slow buses are read
+* concurrently by the reader pool of the table.
+*
+* Power attributes are in uW; current (mA) times voltage (mV) is used for
+* rails without one. A rail whose sensors are missing or failed to read is
+* left out of the totals for this tick.
+*
+* @param	model: loaded rail model
+* @param	tbl: sensor table
+*
+* @return	number of rails with a valid reading.
+*
+* @note		None.
+*
+******************************************************************************/
+int rail_model_update(struct rail_model *model, struct hwmon_sensor_table *tbl)
+{
+	struct hwmon_sensor *sensors[MAX_RAILS * 2];
+	int i, num_sensors, num_valid;
+
+	hwmon_sensors_sync(tbl);
+
+	if(model->generation != tbl->generation)
+	{
+		rail_model_bind(model, tbl);
+	}
+
+	num_sensors = 0;
+
+	for(i = 0; i < model->num_rails; i++)
+	{
+		struct rail *rail = &model->rails[i];
+
+		if(rail->power)
+		{
+			sensors[num_sensors++] = rail->power;
+		}
+		if(rail->curr && rail->volt)
+		{
+			sensors[num_sensors++] = rail->curr;
+			sensors[num_sensors++] = rail->volt;
+		}
+	}
+
+	hwmon_sensors_read_list(tbl, sensors, num_sensors);
+
+	for(i = 0; i < model->num_groups; i++)
+	{
+		model->groups[i].num_valid = 0;
+		model->groups[i].total_watts = 0;
+	}
+	model->total_watts = 0;
+	num_valid = 0;
+
+	for(i = 0; i < model->num_rails; i++)
+	{
+		struct rail *rail = &model->rails[i];
+		struct rail_group *group = &model->groups[rail->group];
+
+		if(rail->power && rail->power->status == 0)
+		{
+			rail->watts = rail->power->value / 1e6;
+			rail->valid = 1;
+		}
+		else if(rail->curr && rail->volt && rail->curr->status == 0 &&
+			rail->volt->status == 0)
+		{
+			rail->watts = rail->curr->value * (double)rail->volt->value / 1e6;
+			rail->valid = 1;
+		}
+		else
+		{
+			rail->valid = 0;
+			continue;
+		}
+
+		group->total_watts += rail->watts;
+		group->num_valid++;
+		model->total_watts += rail->watts;
+		num_valid++;
+	}
+
+	for(i = 0; i < model->num_groups; i++)
+	{
+		struct rail_group *group = &model->groups[i];
+
+		group->headroom_watts = group->budget_watts > 0 ?
+			group->budget_watts - group->total_watts : 0;
+		if(group->total_watts > group->peak_watts)
+		{
+			group->peak_watts = group->total_watts;
+		}
+	}
+
+	return(num_valid);
+}
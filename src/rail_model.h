@@ -0,0 +1,62 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+#ifndef _PLATFORMSTATS_RAIL_MODEL_H_
+#define _PLATFORMSTATS_RAIL_MODEL_H_
+
+#include "hwmon.h"
+
+/************************** Constant Definitions *****************************/
+#define RAIL_CONFIG_PATH	"/etc/platformstats/rails.conf"
+#define MAX_RAILS		32
+#define MAX_RAIL_GROUPS		16
+#define RAIL_NAME_LEN		32
+#define RAIL_DEVICE_LEN		(HWMON_NAME_LEN + 32)	/* name@parent */
+
+/**************************** Type Definitions *******************************/
+/*
+ * One supply rail measured by a power monitor. Power is taken from a power
+ * attribute when the chip has one, otherwise from a current and a voltage
+ * attribute of the same chip.
+ */
+struct rail {
+	char name[RAIL_NAME_LEN];
+	int group;			/* index in rail_model.groups */
+	char device[RAIL_DEVICE_LEN];	/* see hwmon_sensor_lookup */
+	char power_attr[HWMON_ATTR_LEN];	/* "" if derived from curr * in */
+	char curr_attr[HWMON_ATTR_LEN];
+	char volt_attr[HWMON_ATTR_LEN];
+	struct hwmon_sensor *power;	/* bound sensors, NULL if absent */
+	struct hwmon_sensor *curr;
+	struct hwmon_sensor *volt;
+	int valid;			/* watts is from this tick */
+	double watts;
+};
+
+struct rail_group {
+	char name[RAIL_NAME_LEN];
+	double budget_watts;		/* 0 if the group has no budget */
+	int num_rails;
+	int num_valid;			/* rails that contributed to total */
+	double total_watts;
+	double headroom_watts;		/* budget - total, 0 without budget */
+	double peak_watts;		/* highest total since load */
+};
+
+struct rail_model {
+	int loaded;
+	unsigned int generation;	/* tbl->generation the rails are bound to */
+	int num_rails;
+	int num_groups;
+	double total_watts;		/* sum over all valid rails */
+	struct rail rails[MAX_RAILS];
+	struct rail_group groups[MAX_RAIL_GROUPS];
+};
+
+/************************** Function Prototypes  *****************************/
+int rail_model_load(struct rail_model *model, const char *path);
+int rail_model_update(struct rail_model *model, struct hwmon_sensor_table *tbl);
+
+#endif /* _PLATFORMSTATS_RAIL_MODEL_H_ */
@@ -0,0 +1,430 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include "runtime_pm.h"
+#include "utils.h"
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API opens a power attribute of an indexed device.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int rpm_open_attr(struct rpm_index *idx, struct rpm_device *dev,
+		const char *attr)
+{
+	char path[RPM_PATH_LEN + 32];
+
+	snprintf(path, sizeof(path), "%s/power/%s", dev->path, attr);
+
+	return(openat(idx->root_fd, path, O_RDONLY | O_CLOEXEC));
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads a cumulative runtime PM time in ms, through fd when it is
+* open or else by opening the attribute for this read.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int rpm_fetch(struct rpm_index *idx, struct rpm_device *dev, int fd,
+		const char *attr, unsigned long long *ms)
+{
+	char buf[32];
+	ssize_t len;
+	int ret;
+
+	if(fd >= 0)
+	{
+		len = pread(fd, buf, sizeof(buf) - 1, 0);
+		return(len < 0 ? errno : parse_ulonglong(buf, len, ms));
+	}
+
+	fd = rpm_open_attr(idx, dev, attr);
+	if(fd < 0)
+	{
+		return(errno);
+	}
+
+	len = pread(fd, buf, sizeof(buf) - 1, 0);
+	ret = len < 0 ? errno : parse_ulonglong(buf, len, ms);
+	close(fd);
+
+	return(ret);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API checks whether a device is runtime active, or resuming.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int rpm_is_active(struct rpm_index *idx, struct rpm_device *dev)
+{
+	char buf[32];
+	ssize_t len;
+	int fd;
+
+	fd = rpm_open_attr(idx, dev, "runtime_status");
+	if(fd < 0)
+	{
+		return(0);
+	}
+
+	len = pread(fd, buf, sizeof(buf) - 1, 0);
+	close(fd);
+
+	return(len > 0 && (!strncmp(buf, "active", 6) || !strncmp(buf, "resuming", 8)));
+}
+
+/*****************************************************************************/
+/*
+*
+* This API keeps the counters of an active device open, as long as fewer
+* than RPM_MAX_OPEN devices have theirs open. Beyond that the counters are
+* opened for every read.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void rpm_open_counters(struct rpm_index *idx, struct rpm_device *dev)
+{
+	if(dev->active_fd >= 0 || idx->num_open == RPM_MAX_OPEN)
+	{
+		return;
+	}
+
+	dev->active_fd = rpm_open_attr(idx, dev, "runtime_active_time");
+	dev->suspended_fd = rpm_open_attr(idx, dev, "runtime_suspended_time");
+	if(dev->active_fd < 0 || dev->suspended_fd < 0)
+	{
+		if(dev->active_fd >= 0)
+		{
+			close(dev->active_fd);
+		}
+		if(dev->suspended_fd >= 0)
+		{
+			close(dev->suspended_fd);
+		}
+		dev->active_fd = dev->suspended_fd = -1;
+		return;
+	}
+
+	idx->num_open++;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API closes the counters of a device that was runtime suspended.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void rpm_close_counters(struct rpm_index *idx, struct rpm_device *dev)
+{
+	if(dev->active_fd < 0)
+	{
+		return;
+	}
+
+	close(dev->active_fd);
+	close(dev->suspended_fd);
+	dev->active_fd = dev->suspended_fd = -1;
+	idx->num_open--;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API adds a device to the index if its power directory reports
+* runtime PM support.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void rpm_add_device(struct rpm_index *idx, int dev_fd, const char *path)
+{
+	struct rpm_device *dev;
+	char buf[32];
+
+	if(read_sysfs_string(dev_fd, "power/runtime_status", buf, sizeof(buf)) ||
+		!strcmp(buf, "unsupported"))
+	{
+		return;
+	}
+
+	if(faccessat(dev_fd, "power/runtime_active_time", R_OK, 0) ||
+		faccessat(dev_fd, "power/runtime_suspended_time", R_OK, 0))
+	{
+		return;
+	}
+
+	if(idx->num_devices == MAX_RPM_DEVICES)
+	{
+		idx->truncated = 1;
+		return;
+	}
+
+	dev = &idx->devices[idx->num_devices];
+	memset(dev, 0, sizeof(*dev));
+	snprintf(dev->path, sizeof(dev->path), "%s", path);
+	dev->active_fd = dev->suspended_fd = -1;
+
+	dev->forced_on = !read_sysfs_string(dev_fd, "power/control", buf, sizeof(buf)) &&
+		!strcmp(buf, "on");
+
+	idx->num_devices++;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API walks the device tree below dir_fd. Symlinks such as subsystem
+* and driver are not followed, so each device is visited once. Devices
+* whose path does not fit in RPM_PATH_LEN are skipped, since their counters
+* are opened by path.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void rpm_walk(struct rpm_index *idx, int dir_fd, const char *path, int depth)
+{
+	DIR *d;
+	struct dirent *dir;
+
+	if(path[0])
+	{
+		rpm_add_device(idx, dir_fd, path);
+	}
+
+	if(depth == RPM_MAX_DEPTH)
+	{
+		close(dir_fd);
+		return;
+	}
+
+	d = fdopendir(dir_fd);
+	if(d == NULL)
+	{
+		close(dir_fd);
+		return;
+	}
+
+	while((dir = readdir(d)) != NULL)
+	{
+		char child[RPM_PATH_LEN];
+		int child_fd;
+
+		if(dir->d_type != DT_DIR || dir->d_name[0] == '.' ||
+			!strcmp(dir->d_name, "power"))
+		{
+			continue;
+		}
+
+		if(snprintf(child, sizeof(child), "%s%s%s", path, path[0] ? "/" : "",
+			dir->d_name) >= (int)sizeof(child))
+		{
+			continue;
+		}
+
+		child_fd = openat(dir_fd, dir->d_name,
+				O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+		if(child_fd < 0)
+		{
+			continue;
+		}
+
+		rpm_walk(idx, child_fd, child, depth + 1);
+	}
+
+	closedir(d);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API compares two runtime PM devices by path for qsort.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int rpm_device_compare(const void *a, const void *b)
+{
+	const struct rpm_device *da = a, *db = b;
+
+	return(strcmp(da->path, db->path));
+}
+
+/*****************************************************************************/
+/*
+*
+* This API walks /sys/devices once and records every device that supports
+* runtime PM. No counter is opened until the first read.
+*
+* @param	idx: runtime PM index to populate
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int rpm_init(struct rpm_index *idx)
+{
+	int fd;
+
+	rpm_release(idx);
+	memset(idx, 0, sizeof(*idx));
+
+	idx->root_fd = open(DEVICES_PATH, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(idx->root_fd < 0)
+	{
+		return(errno);
+	}
+
+	fd = dup(idx->root_fd);
+	if(fd < 0)
+	{
+		int ret = errno;
+
+		close(idx->root_fd);
+		idx->root_fd = -1;
+		return(ret);
+	}
+
+	rpm_walk(idx, fd, "", 0);
+
+	qsort(idx->devices, idx->num_devices, sizeof(idx->devices[0]),
+		rpm_device_compare);
+
+	idx->valid = 1;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API closes all fds held by the runtime PM index.
+*
+* @param	idx: runtime PM index
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void rpm_release(struct rpm_index *idx)
+{
+	int i;
+
+	if(!idx->valid)
+	{
+		return;
+	}
+
+	for(i = 0; i < idx->num_devices; i++)
+	{
+		rpm_close_counters(idx, &idx->devices[i]);
+	}
+
+	close(idx->root_fd);
+	idx->root_fd = -1;
+	idx->num_devices = 0;
+	idx->valid = 0;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads the active and suspended times of the indexed devices and
+* computes how long each was active and suspended since its previous read.
+* Devices whose runtime_status is active are read on every call. Suspended
+* devices only change their suspended time, so they are read every
+* RPM_SLOW_TICKS calls, when their runtime_status is checked again; their
+* deltas are 0 in between and cover all the calls since their previous read
+* when they are read. An active device that spent a whole call suspended
+* goes back to the slow cadence. The deltas are 0 on the first read.
+*
+* @param	idx: runtime PM index
+*
+* @return	number of devices read successfully.
+*
+* @note		None.
+*
+******************************************************************************/
+int rpm_read(struct rpm_index *idx)
+{
+	int i, slow, num_read = 0;
+
+	slow = (idx->ticks++ % RPM_SLOW_TICKS) == 0;
+
+	for(i = 0; i < idx->num_devices; i++)
+	{
+		struct rpm_device *dev = &idx->devices[i];
+		unsigned long long active, suspended;
+
+		if(!dev->active && !slow)
+		{
+			dev->active_delta = dev->suspended_delta = 0;
+			continue;
+		}
+
+		if(!dev->active && rpm_is_active(idx, dev))
+		{
+			dev->active = 1;
+			rpm_open_counters(idx, dev);
+		}
+
+		dev->status = rpm_fetch(idx, dev, dev->active_fd, "runtime_active_time",
+				&active);
+		if(!dev->status)
+		{
+			dev->status = rpm_fetch(idx, dev, dev->suspended_fd,
+					"runtime_suspended_time", &suspended);
+		}
+		if(dev->status)
+		{
+			dev->active_delta = dev->suspended_delta = 0;
+			continue;
+		}
+
+		dev->active_delta = idx->primed && active >= dev->active_ms ?
+			active - dev->active_ms : 0;
+		dev->suspended_delta = idx->primed && suspended >= dev->suspended_ms ?
+			suspended - dev->suspended_ms : 0;
+		dev->active_ms = active;
+		dev->suspended_ms = suspended;
+		num_read++;
+
+		if(dev->active && idx->primed && dev->active_delta == 0 &&
+			dev->suspended_delta > 0)
+		{
+			dev->active = 0;
+			rpm_close_counters(idx, dev);
+		}
+	}
+
+	idx->primed = 1;
+
+	return(num_read);
+}
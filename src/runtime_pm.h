@@ -0,0 +1,60 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+#ifndef _PLATFORMSTATS_RUNTIME_PM_H_
+#define _PLATFORMSTATS_RUNTIME_PM_H_
+
+/************************** Constant Definitions *****************************/
+#define DEVICES_PATH		"/sys/devices"
+#define MAX_RPM_DEVICES		512
+#define RPM_PATH_LEN		256
+#define RPM_MAX_DEPTH		16
+#define RPM_TOP			10	/* devices printed without verbose */
+#define RPM_SLOW_TICKS		10	/* reads between two reads of suspended devices */
+#define RPM_MAX_OPEN		64	/* devices whose counters are kept open */
+
+/**************************** Type Definitions *******************************/
+/*
+ * A device with runtime PM support. Its active and suspended times are
+ * cumulative milliseconds kept by the PM core. The counters of an active
+ * device are read on every update, through fds kept open while it stays
+ * active; those of a suspended device only every RPM_SLOW_TICKS updates,
+ * opened for the read.
+ */
+struct rpm_device {
+	char path[RPM_PATH_LEN];	/* relative to DEVICES_PATH */
+	int forced_on;			/* power/control is "on", runtime PM blocked */
+	int active;			/* runtime_status was active at the last check */
+	int active_fd;			/* power/runtime_active_time, -1 if not open */
+	int suspended_fd;		/* power/runtime_suspended_time, -1 if not open */
+	unsigned long long active_ms;
+	unsigned long long suspended_ms;
+	unsigned long long active_delta;	/* ms active in the window */
+	unsigned long long suspended_delta;	/* ms suspended in the window */
+	int status;			/* 0 if the times are valid, errno otherwise */
+};
+
+/*
+ * The devices of /sys/devices whose runtime_status is not "unsupported",
+ * found by one walk of the device tree. Updates only read their counters.
+ * At most 2 * RPM_MAX_OPEN + 1 fds are held, whatever the number of devices.
+ */
+struct rpm_index {
+	int valid;
+	int primed;
+	int truncated;			/* more than MAX_RPM_DEVICES were found */
+	int root_fd;			/* DEVICES_PATH, device paths are relative to it */
+	unsigned long ticks;		/* number of updates */
+	int num_open;			/* devices with open counters */
+	int num_devices;
+	struct rpm_device devices[MAX_RPM_DEVICES];
+};
+
+/************************** Function Prototypes  *****************************/
+int rpm_init(struct rpm_index *idx);
+void rpm_release(struct rpm_index *idx);
+int rpm_read(struct rpm_index *idx);
+
+#endif /* _PLATFORMSTATS_RUNTIME_PM_H_ */
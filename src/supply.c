@@ -0,0 +1,248 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include "supply.h"
+#include "hwmon.h"
+#include "utils.h"
+
+/************************** Variable Definitions *****************************/
+static const char *const power_supply_attrs[] = {
+	[SUPPLY_VOLTAGE] = "voltage_now",	/* uV */
+	[SUPPLY_CURRENT] = "current_now",	/* uA */
+	[SUPPLY_POWER] = "power_now",		/* uW */
+	[SUPPLY_ENERGY] = "energy_now",		/* uWh */
+};
+
+static const char *const regulator_attrs[] = {
+	[REGULATOR_MICROVOLTS] = "microvolts",
+	[REGULATOR_MICROAMPS] = "microamps",
+};
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API compares two supply devices by name for qsort.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int supply_device_compare(const void *a, const void *b)
+{
+	const struct supply_device *da = a, *db = b;
+
+	return(strcmp(da->name, db->name));
+}
+
+/*****************************************************************************/
+/*
+*
+* This API scans a sysfs class once and opens the given attributes of every
+* device that has at least one of them. The fds stay open, so each later read
+* is a single pread per attribute.
+*
+* @param	cls: supply class to populate
+* @param	path: class directory, e.g. /sys/class/regulator
+* @param	attrs: numeric attribute names
+* @param	num_attrs: number of attributes, at most MAX_SUPPLY_ATTRS
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int supply_class_init(struct supply_class *cls, const char *path,
+		const char *const *attrs, int num_attrs)
+{
+	DIR *d;
+	struct dirent *dir;
+	int class_fd;
+
+	supply_class_release(cls);
+
+	cls->path = path;
+	cls->attrs = attrs;
+	cls->num_attrs = num_attrs < MAX_SUPPLY_ATTRS ? num_attrs : MAX_SUPPLY_ATTRS;
+
+	d = opendir(path);
+	if(!d)
+	{
+		return(errno);
+	}
+
+	class_fd = dirfd(d);
+
+	while((dir = readdir(d)) != NULL && cls->num_devices < MAX_SUPPLY_DEVICES)
+	{
+		struct supply_device *dev = &cls->devices[cls->num_devices];
+		int dev_fd, i, num_open;
+
+		if(dir->d_name[0] == '.')
+		{
+			continue;
+		}
+
+		dev_fd = openat(class_fd, dir->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if(dev_fd < 0)
+		{
+			continue;
+		}
+
+		memset(dev, 0, sizeof(*dev));
+		num_open = 0;
+
+		for(i = 0; i < cls->num_attrs; i++)
+		{
+			dev->fd[i] = openat(dev_fd, attrs[i], O_RDONLY | O_CLOEXEC);
+			dev->status[i] = dev->fd[i] < 0 ? ENOENT : 0;
+			if(dev->fd[i] >= 0)
+			{
+				num_open++;
+			}
+		}
+
+		snprintf(dev->dir, sizeof(dev->dir), "%.63s", dir->d_name);
+		if(read_sysfs_string(dev_fd, "name", dev->name, sizeof(dev->name)) ||
+			dev->name[0] == '\0')
+		{
+			snprintf(dev->name, sizeof(dev->name), "%.63s", dir->d_name);
+		}
+
+		close(dev_fd);
+
+		if(num_open)
+		{
+			cls->num_devices++;
+		}
+	}
+
+	closedir(d);
+
+	qsort(cls->devices, cls->num_devices, sizeof(cls->devices[0]),
+		supply_device_compare);
+
+	cls->valid = 1;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API closes all attribute fds held by a supply class.
+*
+* @param	cls: supply class
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void supply_class_release(struct supply_class *cls)
+{
+	int i, j;
+
+	for(i = 0; i < cls->num_devices; i++)
+	{
+		for(j = 0; j < cls->num_attrs; j++)
+		{
+			if(cls->devices[i].fd[j] >= 0)
+			{
+				close(cls->devices[i].fd[j]);
+			}
+		}
+	}
+
+	cls->num_devices = 0;
+	cls->valid = 0;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads every open attribute of every device of a supply class.
+*
+* @param	cls: supply class
+*
+* @return	number of attributes read successfully.
+*
+* @note		None.
+*
+******************************************************************************/
+int supply_class_read(struct supply_class *cls)
+{
+	int i, j, num_read;
+
+	num_read = 0;
+
+	for(i = 0; i < cls->num_devices; i++)
+	{
+		struct supply_device *dev = &cls->devices[i];
+
+		for(j = 0; j < cls->num_attrs; j++)
+		{
+			if(dev->fd[j] < 0)
+			{
+				continue;
+			}
+
+			dev->status[j] = hwmon_sensor_fetch(dev->fd[j], &dev->value[j]);
+			if(dev->status[j] == 0)
+			{
+				num_read++;
+			}
+		}
+	}
+
+	return(num_read);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API scans the power_supply class for voltage, current, power and
+* energy, see supply_class_init.
+*
+* @param	cls: supply class to populate
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int supply_power_supplies_init(struct supply_class *cls)
+{
+	return(supply_class_init(cls, POWER_SUPPLY_CLASS_PATH, power_supply_attrs,
+		sizeof(power_supply_attrs) / sizeof(power_supply_attrs[0])));
+}
+
+/*****************************************************************************/
+/*
+*
+* This API scans the regulator class for output voltage and current, see
+* supply_class_init.
+*
+* @param	cls: supply class to populate
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int supply_regulators_init(struct supply_class *cls)
+{
+	return(supply_class_init(cls, REGULATOR_CLASS_PATH, regulator_attrs,
+		sizeof(regulator_attrs) / sizeof(regulator_attrs[0])));
+}
@@ -0,0 +1,53 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+#ifndef _PLATFORMSTATS_SUPPLY_H_
+#define _PLATFORMSTATS_SUPPLY_H_
+
+/************************** Constant Definitions *****************************/
+#define POWER_SUPPLY_CLASS_PATH	"/sys/class/power_supply"
+#define REGULATOR_CLASS_PATH	"/sys/class/regulator"
+#define MAX_SUPPLY_DEVICES	64
+#define MAX_SUPPLY_ATTRS	4
+#define SUPPLY_NAME_LEN		64
+
+/**************************** Type Definitions *******************************/
+/*
+ * One device of a power_supply or regulator class with the fds of the
+ * attributes it exposes. Absent attributes have fd -1.
+ */
+struct supply_device {
+	char dir[SUPPLY_NAME_LEN];	/* directory name, e.g. "regulator.4" */
+	char name[SUPPLY_NAME_LEN];	/* <dir>/name if present, dir otherwise */
+	int fd[MAX_SUPPLY_ATTRS];
+	long value[MAX_SUPPLY_ATTRS];	/* last value in class ABI units */
+	int status[MAX_SUPPLY_ATTRS];	/* 0 if value is valid, errno otherwise */
+};
+
+/*
+ * A sysfs class scanned once for a fixed list of numeric attributes. Only
+ * devices exposing at least one of them are kept.
+ */
+struct supply_class {
+	const char *path;
+	const char *const *attrs;
+	int num_attrs;
+	int valid;
+	int num_devices;
+	struct supply_device devices[MAX_SUPPLY_DEVICES];
+};
+
+enum { SUPPLY_VOLTAGE, SUPPLY_CURRENT, SUPPLY_POWER, SUPPLY_ENERGY };
+enum { REGULATOR_MICROVOLTS, REGULATOR_MICROAMPS };
+
+/************************** Function Prototypes  *****************************/
+int supply_class_init(struct supply_class *cls, const char *path,
+		const char *const *attrs, int num_attrs);
+void supply_class_release(struct supply_class *cls);
+int supply_class_read(struct supply_class *cls);
+int supply_power_supplies_init(struct supply_class *cls);
+int supply_regulators_init(struct supply_class *cls);
+
+#endif /* _PLATFORMSTATS_SUPPLY_H_ */
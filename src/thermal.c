@@ -0,0 +1,303 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include "thermal.h"
+#include "hwmon.h"
+#include "utils.h"
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API reads a numeric attribute of a thermal zone or cooling device.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int thermal_read_long(int dirfd, const char *attr, long *value)
+{
+	char buf[32];
+	int ret;
+
+	ret = read_sysfs_string(dirfd, attr, buf, sizeof(buf));
+	if(ret)
+	{
+		return(ret);
+	}
+
+	return(parse_long(buf, strlen(buf), value));
+}
+
+/*****************************************************************************/
+/*
+*
+* This API compares two thermal zones by id for qsort.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int thermal_zone_compare(const void *a, const void *b)
+{
+	const struct thermal_zone *za = a, *zb = b;
+
+	return(za->id - zb->id);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API compares two cooling devices by id for qsort.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int cooling_device_compare(const void *a, const void *b)
+{
+	const struct cooling_device *ca = a, *cb = b;
+
+	return(ca->id - cb->id);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API records the trip points of a thermal zone. Trip points are
+* numbered from 0 without gaps.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void thermal_zone_read_trips(struct thermal_zone *zone, int dirfd)
+{
+	char attr[48];
+	int i;
+
+	for(i = 0; i < MAX_THERMAL_TRIPS; i++)
+	{
+		struct thermal_trip *trip = &zone->trips[zone->num_trips];
+
+		snprintf(attr, sizeof(attr), "trip_point_%d_temp", i);
+		if(thermal_read_long(dirfd, attr, &trip->temp))
+		{
+			break;
+		}
+
+		snprintf(attr, sizeof(attr), "trip_point_%d_type", i);
+		if(read_sysfs_string(dirfd, attr, trip->type, sizeof(trip->type)))
+		{
+			trip->type[0] = '\0';
+		}
+
+		zone->num_trips++;
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API scans /sys/class/thermal once. For every thermal zone it opens
+* temp and records its type and trip points; for every cooling device it
+* opens cur_state and records its type and max_state.
+*
+* @param	th: thermal index to populate
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int thermal_init(struct thermal_index *th)
+{
+	DIR *d;
+	struct dirent *dir;
+	int class_fd;
+
+	thermal_release(th);
+
+	d = opendir(THERMAL_CLASS_PATH);
+	if(!d)
+	{
+		return(errno);
+	}
+
+	class_fd = dirfd(d);
+
+	while((dir = readdir(d)) != NULL)
+	{
+		int id, dev_fd;
+
+		if(sscanf(dir->d_name, "thermal_zone%d", &id) == 1 &&
+			th->num_zones < MAX_THERMAL_ZONES)
+		{
+			struct thermal_zone *zone = &th->zones[th->num_zones];
+
+			dev_fd = openat(class_fd, dir->d_name,
+					O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			if(dev_fd < 0)
+			{
+				continue;
+			}
+
+			memset(zone, 0, sizeof(*zone));
+			zone->id = id;
+			zone->nearest = -1;
+			zone->temp_fd = openat(dev_fd, "temp", O_RDONLY | O_CLOEXEC);
+			if(zone->temp_fd >= 0)
+			{
+				if(read_sysfs_string(dev_fd, "type", zone->type,
+					sizeof(zone->type)))
+				{
+					zone->type[0] = '\0';
+				}
+				thermal_zone_read_trips(zone, dev_fd);
+				th->num_zones++;
+			}
+			close(dev_fd);
+		}
+		else if(sscanf(dir->d_name, "cooling_device%d", &id) == 1 &&
+			th->num_cooling < MAX_COOLING_DEVICES)
+		{
+			struct cooling_device *cdev = &th->cooling[th->num_cooling];
+
+			dev_fd = openat(class_fd, dir->d_name,
+					O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			if(dev_fd < 0)
+			{
+				continue;
+			}
+
+			memset(cdev, 0, sizeof(*cdev));
+			cdev->id = id;
+			cdev->cur_fd = openat(dev_fd, "cur_state", O_RDONLY | O_CLOEXEC);
+			if(cdev->cur_fd >= 0)
+			{
+				if(read_sysfs_string(dev_fd, "type", cdev->type,
+					sizeof(cdev->type)))
+				{
+					cdev->type[0] = '\0';
+				}
+				if(thermal_read_long(dev_fd, "max_state", &cdev->max_state))
+				{
+					cdev->max_state = 0;
+				}
+				th->num_cooling++;
+			}
+			close(dev_fd);
+		}
+	}
+
+	closedir(d);
+
+	qsort(th->zones, th->num_zones, sizeof(th->zones[0]), thermal_zone_compare);
+	qsort(th->cooling, th->num_cooling, sizeof(th->cooling[0]),
+		cooling_device_compare);
+
+	th->valid = 1;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API closes all fds held by the thermal index.
+*
+* @param	th: thermal index
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void thermal_release(struct thermal_index *th)
+{
+	int i;
+
+	for(i = 0; i < th->num_zones; i++)
+	{
+		close(th->zones[i].temp_fd);
+	}
+
+	for(i = 0; i < th->num_cooling; i++)
+	{
+		close(th->cooling[i].cur_fd);
+	}
+
+	th->num_zones = 0;
+	th->num_cooling = 0;
+	th->valid = 0;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads the temperature of every zone and the state of every
+* cooling device. The headroom of a zone is the distance to its lowest
+* passive, hot or critical trip point, i.e. to where the kernel starts
+* throttling or shutting down; active trip points only switch fans. The
+* headroom is negative once that trip point has been crossed.
+*
+* @param	th: thermal index
+*
+* @return	number of zones read successfully.
+*
+* @note		None.
+*
+******************************************************************************/
+int thermal_read(struct thermal_index *th)
+{
+	int i, j, num_read;
+
+	num_read = 0;
+
+	for(i = 0; i < th->num_zones; i++)
+	{
+		struct thermal_zone *zone = &th->zones[i];
+
+		zone->status = hwmon_sensor_fetch(zone->temp_fd, &zone->temp);
+		if(zone->status)
+		{
+			continue;
+		}
+		num_read++;
+
+		zone->nearest = -1;
+		for(j = 0; j < zone->num_trips; j++)
+		{
+			if(!strcmp(zone->trips[j].type, "active"))
+			{
+				continue;
+			}
+
+			if(zone->nearest < 0 ||
+				zone->trips[j].temp < zone->trips[zone->nearest].temp)
+			{
+				zone->nearest = j;
+			}
+		}
+
+		zone->headroom = zone->nearest < 0 ? 0 :
+			zone->trips[zone->nearest].temp - zone->temp;
+	}
+
+	for(i = 0; i < th->num_cooling; i++)
+	{
+		struct cooling_device *cdev = &th->cooling[i];
+
+		cdev->status = hwmon_sensor_fetch(cdev->cur_fd, &cdev->cur_state);
+	}
+
+	return(num_read);
+}
@@ -0,0 +1,56 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+#ifndef _PLATFORMSTATS_THERMAL_H_
+#define _PLATFORMSTATS_THERMAL_H_
+
+/************************** Constant Definitions *****************************/
+#define THERMAL_CLASS_PATH	"/sys/class/thermal"
+#define MAX_THERMAL_ZONES	32
+#define MAX_COOLING_DEVICES	32
+#define MAX_THERMAL_TRIPS	12
+#define THERMAL_NAME_LEN	32
+
+/**************************** Type Definitions *******************************/
+struct thermal_trip {
+	long temp;			/* m°C */
+	char type[THERMAL_NAME_LEN];	/* active, passive, hot or critical */
+};
+
+struct thermal_zone {
+	int id;				/* N of thermal_zoneN */
+	char type[THERMAL_NAME_LEN];	/* e.g. "cpu-thermal" */
+	int temp_fd;			/* open fd of thermal_zoneN/temp */
+	long temp;			/* m°C */
+	int status;			/* 0 if temp is valid, errno otherwise */
+	int num_trips;
+	struct thermal_trip trips[MAX_THERMAL_TRIPS];
+	int nearest;			/* trip used for headroom, -1 if none */
+	long headroom;			/* trip temp - temp in m°C, < 0 once crossed */
+};
+
+struct cooling_device {
+	int id;				/* N of cooling_deviceN */
+	char type[THERMAL_NAME_LEN];	/* e.g. "thermal-cpufreq-0" */
+	int cur_fd;			/* open fd of cooling_deviceN/cur_state */
+	long cur_state;
+	long max_state;
+	int status;			/* 0 if cur_state is valid, errno otherwise */
+};
+
+struct thermal_index {
+	int valid;
+	int num_zones;
+	int num_cooling;
+	struct thermal_zone zones[MAX_THERMAL_ZONES];
+	struct cooling_device cooling[MAX_COOLING_DEVICES];
+};
+
+/************************** Function Prototypes  *****************************/
+int thermal_init(struct thermal_index *th);
+void thermal_release(struct thermal_index *th);
+int thermal_read(struct thermal_index *th);
+
+#endif /* _PLATFORMSTATS_THERMAL_H_ */
@@ -0,0 +1,363 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include "throttle.h"
+#include "hwmon.h"
+#include "utils.h"
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API compares two cpufreq policies by id for qsort.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int cpufreq_policy_compare(const void *a, const void *b)
+{
+	const struct cpufreq_policy *pa = a, *pb = b;
+
+	return(pa->id - pb->id);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API scans the cpufreq policies once, records their hardware maximum
+* frequency and current limit, and opens their current frequency and
+* current limit.
+*
+* @param	det: throttle detector to initialize
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int throttle_init(struct throttle_detector *det)
+{
+	DIR *d;
+	struct dirent *dir;
+	int cpufreq_fd;
+
+	throttle_release(det);
+	memset(det, 0, sizeof(*det));
+
+	d = opendir(CPUFREQ_PATH);
+	if(!d)
+	{
+		return(errno);
+	}
+
+	cpufreq_fd = dirfd(d);
+
+	while((dir = readdir(d)) != NULL && det->num_policies < MAX_CPUFREQ_POLICIES)
+	{
+		struct cpufreq_policy *policy = &det->policies[det->num_policies];
+		char buf[32];
+		int id, policy_fd;
+
+		if(sscanf(dir->d_name, "policy%d", &id) != 1)
+		{
+			continue;
+		}
+
+		policy_fd = openat(cpufreq_fd, dir->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if(policy_fd < 0)
+		{
+			continue;
+		}
+
+		memset(policy, 0, sizeof(*policy));
+		policy->id = id;
+		policy->cur_fd = openat(policy_fd, "scaling_cur_freq", O_RDONLY | O_CLOEXEC);
+		policy->cap_fd = openat(policy_fd, "scaling_max_freq", O_RDONLY | O_CLOEXEC);
+
+		if(read_sysfs_string(policy_fd, "cpuinfo_max_freq", buf, sizeof(buf)) ||
+			parse_long(buf, strlen(buf), &policy->hw_max_khz) ||
+			policy->cur_fd < 0 || policy->cap_fd < 0)
+		{
+			if(policy->cur_fd >= 0)
+			{
+				close(policy->cur_fd);
+			}
+			if(policy->cap_fd >= 0)
+			{
+				close(policy->cap_fd);
+			}
+			close(policy_fd);
+			continue;
+		}
+
+		/* taken as the user limit until a tick without a thermal cause */
+		if(hwmon_sensor_fetch(policy->cap_fd, &policy->user_khz))
+		{
+			policy->user_khz = policy->hw_max_khz;
+		}
+
+		close(policy_fd);
+		det->num_policies++;
+	}
+
+	closedir(d);
+
+	qsort(det->policies, det->num_policies, sizeof(det->policies[0]),
+		cpufreq_policy_compare);
+
+	det->valid = 1;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API closes all fds held by the throttle detector.
+*
+* @param	det: throttle detector
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void throttle_release(struct throttle_detector *det)
+{
+	int i;
+
+	for(i = 0; i < det->num_policies; i++)
+	{
+		close(det->policies[i].cur_fd);
+		close(det->policies[i].cap_fd);
+	}
+
+	det->num_policies = 0;
+	det->valid = 0;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API looks for the thermal reason a CPU may be held below its maximum
+* frequency: an engaged cpufreq cooling device, or else the thermal zone
+* closest to a trip point when it is within THROTTLE_TRIP_MARGIN of it.
+*
+* @param	th: thermal index, already read
+* @param	cause: filled with a description of the cause
+* @param	len: size of cause
+*
+* @return	1 if a thermal cause was found, 0 otherwise.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int throttle_thermal_cause(struct thermal_index *th, char *cause, size_t len)
+{
+	struct thermal_zone *closest = NULL;
+	int i;
+
+	for(i = 0; i < th->num_cooling; i++)
+	{
+		struct cooling_device *cdev = &th->cooling[i];
+
+		if(cdev->status == 0 && cdev->cur_state > 0 &&
+			strstr(cdev->type, "cpufreq") != NULL)
+		{
+			snprintf(cause, len, "%s state %ld", cdev->type, cdev->cur_state);
+			return(1);
+		}
+	}
+
+	for(i = 0; i < th->num_zones; i++)
+	{
+		struct thermal_zone *zone = &th->zones[i];
+
+		if(zone->status || zone->nearest < 0)
+		{
+			continue;
+		}
+
+		if(closest == NULL || zone->headroom < closest->headroom)
+		{
+			closest = zone;
+		}
+	}
+
+	if(closest && closest->headroom < THROTTLE_TRIP_MARGIN)
+	{
+		snprintf(cause, len, "%s at %.1f C", closest->type, closest->temp / 1000.0);
+		return(1);
+	}
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API closes the episode in progress and stores it in the history. The
+* oldest episode is overwritten when the history is full.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void throttle_end_episode(struct throttle_detector *det)
+{
+	if(det->count == THROTTLE_HISTORY)
+	{
+		det->head = (det->head + 1) % THROTTLE_HISTORY;
+		det->count--;
+	}
+
+	det->history[(det->head + det->count) % THROTTLE_HISTORY] = det->current;
+	det->count++;
+	det->total_episodes++;
+	det->active = 0;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API samples the CPU frequencies and the thermal state once and
+* advances the episode tracking. A CPU is throttled when its limit is
+* below the limit set by the user while a thermal cause is present; a CPU
+* slowed down by the governor is not throttling. The user limit is the
+* scaling_max_freq seen at init and at every update without a thermal
+* cause, so a limit lowered by the user is not throttling either. Frequency
+* lost to throttling is accumulated as the shortfall of the limit from the
+* user limit multiplied by the time since the previous update, summed over
+* all throttled policies. The update that opens an episode accounts the
+* interval before it as well.
+*
+* @param	det: throttle detector
+* @param	th: thermal index, read by this call
+*
+* @return	1 while an episode is in progress, 0 otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int throttle_update(struct throttle_detector *det, struct thermal_index *th)
+{
+	struct timespec now;
+	char cause[THROTTLE_CAUSE_LEN];
+	double dt, lost_khz;
+	long min_khz;
+	int i, thermal, throttled;
+
+	thermal_read(th);
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	dt = det->primed ? (now.tv_sec - det->last_tick.tv_sec) +
+		(now.tv_nsec - det->last_tick.tv_nsec) / 1e9 : 0;
+	det->last_tick = now;
+	det->primed = 1;
+
+	cause[0] = '\0';
+	thermal = throttle_thermal_cause(th, cause, sizeof(cause));
+
+	throttled = 0;
+	lost_khz = 0;
+	min_khz = 0;
+
+	for(i = 0; i < det->num_policies; i++)
+	{
+		struct cpufreq_policy *policy = &det->policies[i];
+
+		policy->status = hwmon_sensor_fetch(policy->cur_fd, &policy->cur_khz);
+		if(!policy->status)
+		{
+			policy->status = hwmon_sensor_fetch(policy->cap_fd, &policy->cap_khz);
+		}
+		if(policy->status)
+		{
+			continue;
+		}
+
+		/* the limit is the user's while nothing thermal can explain it */
+		if(!thermal || policy->cap_khz > policy->user_khz)
+		{
+			policy->user_khz = policy->cap_khz;
+		}
+		if(!thermal || policy->cap_khz >= policy->user_khz)
+		{
+			continue;
+		}
+
+		throttled = 1;
+		lost_khz += policy->user_khz - policy->cap_khz;
+		if(min_khz == 0 || policy->cur_khz < min_khz)
+		{
+			min_khz = policy->cur_khz;
+		}
+	}
+
+	if(throttled)
+	{
+		if(!det->active)
+		{
+			memset(&det->current, 0, sizeof(det->current));
+			clock_gettime(CLOCK_REALTIME, &det->current.start);
+			snprintf(det->current.cause, sizeof(det->current.cause), "%s", cause);
+			det->current.min_khz = min_khz;
+			det->active = 1;
+		}
+
+		det->current.duration += dt;
+		det->current.lost_ghz_s += lost_khz / 1e6 * dt;
+		det->total_lost_ghz_s += lost_khz / 1e6 * dt;
+		if(min_khz < det->current.min_khz)
+		{
+			det->current.min_khz = min_khz;
+		}
+	}
+	else if(det->active)
+	{
+		throttle_end_episode(det);
+	}
+
+	return(det->active);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API moves the completed throttling episodes, oldest first, out of the
+* detector.
+*
+* @param	det: throttle detector
+* @param	episodes: array for the episodes
+* @param	max_episodes: size of episodes
+*
+* @return	number of episodes returned.
+*
+* @note		None.
+*
+******************************************************************************/
+int throttle_drain(struct throttle_detector *det, struct throttle_episode *episodes,
+		int max_episodes)
+{
+	int n;
+
+	for(n = 0; n < max_episodes && det->count > 0; n++)
+	{
+		episodes[n] = det->history[det->head];
+		det->head = (det->head + 1) % THROTTLE_HISTORY;
+		det->count--;
+	}
+
+	return(n);
+}
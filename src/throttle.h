@@ -0,0 +1,68 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+#ifndef _PLATFORMSTATS_THROTTLE_H_
+#define _PLATFORMSTATS_THROTTLE_H_
+
+#include <time.h>
+
+#include "thermal.h"
+
+/************************** Constant Definitions *****************************/
+#define CPUFREQ_PATH		"/sys/devices/system/cpu/cpufreq"
+#define MAX_CPUFREQ_POLICIES	16
+#define THROTTLE_TRIP_MARGIN	5000	/* m°C from a trip point that counts as near */
+#define THROTTLE_HISTORY	32
+#define THROTTLE_CAUSE_LEN	64
+
+/**************************** Type Definitions *******************************/
+struct cpufreq_policy {
+	int id;				/* N of policyN */
+	int cur_fd;			/* open fd of scaling_cur_freq */
+	int cap_fd;			/* open fd of scaling_max_freq */
+	long cur_khz;
+	long cap_khz;			/* current limit, lowered by thermal capping */
+	long user_khz;			/* limit set by the user, learned while cool */
+	long hw_max_khz;		/* cpuinfo_max_freq */
+	int status;			/* 0 if cur_khz and cap_khz are valid */
+};
+
+struct throttle_episode {
+	struct timespec start;		/* CLOCK_REALTIME start of the episode */
+	double duration;		/* seconds */
+	double lost_ghz_s;		/* sum over policies of (user cap - cap) * time */
+	long min_khz;			/* lowest frequency seen during the episode */
+	char cause[THROTTLE_CAUSE_LEN];	/* zone or cooling device held responsible */
+};
+
+/*
+ * Correlates CPU frequency with thermal state. A throttling episode runs
+ * while the limit of a CPU is below the limit set by the user and there is
+ * a thermal cause for it: a cpufreq cooling device is engaged, or a thermal
+ * zone is within THROTTLE_TRIP_MARGIN of a trip point.
+ */
+struct throttle_detector {
+	int valid;
+	int num_policies;
+	struct cpufreq_policy policies[MAX_CPUFREQ_POLICIES];
+	int primed;
+	struct timespec last_tick;	/* CLOCK_MONOTONIC time of previous update */
+	int active;			/* an episode is in progress */
+	struct throttle_episode current;
+	int head;
+	int count;
+	struct throttle_episode history[THROTTLE_HISTORY];
+	unsigned long total_episodes;
+	double total_lost_ghz_s;
+};
+
+/************************** Function Prototypes  *****************************/
+int throttle_init(struct throttle_detector *det);
+void throttle_release(struct throttle_detector *det);
+int throttle_update(struct throttle_detector *det, struct thermal_index *th);
+int throttle_drain(struct throttle_detector *det, struct throttle_episode *episodes,
+		int max_episodes);
+
+#endif /* _PLATFORMSTATS_THROTTLE_H_ */
@@ -6,6 +6,9 @@
 /******************************************************************************/
 /***************************** Include Files *********************************/
 #include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
 
 /************************** Function Definitions *****************************/
 /*****************************************************************************/
@@ -35,4 +38,145 @@ void skip_lines(FILE *fp, int numlines)
     	}
 }
 
+/*****************************************************************************/
+/*
+*
+* This API parses a decimal integer, as found in sysfs attributes, from a
+* buffer that is not necessarily NUL terminated. Leading blanks and an
+* optional sign are accepted and parsing stops at the first non digit.
+*
+* @param	buf: buffer holding the text
+* @param	len: number of valid bytes in buf
+* @param	value: parsed value
+*
+* @return	0 on success, EINVAL if no digits were found.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+int parse_long(const char *buf, size_t len, long *value)
+{
+	size_t i;
+	long result;
+	int negative, digits;
+
+	i = 0;
+	result = 0;
+	negative = 0;
+	digits = 0;
+
+	while(i < len && (buf[i] == ' ' || buf[i] == '\t'))
+	{
+		i++;
+	}
+
+	if(i < len && (buf[i] == '-' || buf[i] == '+'))
+	{
+		negative = (buf[i] == '-');
+		i++;
+	}
+
+	for(; i < len && buf[i] >= '0' && buf[i] <= '9'; i++, digits++)
+	{
+		result = result * 10 + (buf[i] - '0');
+	}
+
+	if(!digits)
+	{
+		return(EINVAL);
+	}
+
+	*value = negative ? -result : result;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API parses an unsigned decimal counter from a buffer that is not
+* necessarily NUL terminated. It is used for 64 bit counters such as
+* energy_uj, which do not fit a long on 32 bit targets.
+*
+* @param	buf: buffer holding the text
+* @param	len: number of valid bytes in buf
+* @param	value: parsed value
+*
+* @return	0 on success, EINVAL if no digits were found.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+int parse_ulonglong(const char *buf, size_t len, unsigned long long *value)
+{
+	size_t i;
+	unsigned long long result;
+	int digits;
+
+	i = 0;
+	result = 0;
+	digits = 0;
+
+	while(i < len && (buf[i] == ' ' || buf[i] == '\t'))
+	{
+		i++;
+	}
+
+	for(; i < len && buf[i] >= '0' && buf[i] <= '9'; i++, digits++)
+	{
+		result = result * 10 + (buf[i] - '0');
+	}
+
+	if(!digits)
+	{
+		return(EINVAL);
+	}
+
+	*value = result;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads a string attribute of a sysfs device through its directory
+* fd and strips the trailing newline.
+*
+* @param	dirfd: open directory fd of the sysfs device
+* @param	attr: attribute file name
+* @param	buf: buffer to store the attribute value
+* @param	len: size of buf
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+int read_sysfs_string(int dirfd, const char *attr, char *buf, size_t len)
+{
+	int fd;
+	ssize_t bytes_read;
+
+	fd = openat(dirfd, attr, O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+	{
+		return(errno);
+	}
+
+	bytes_read = read(fd, buf, len - 1);
+	close(fd);
 
+	if(bytes_read < 0)
+	{
+		return(errno);
+	}
+
+	while(bytes_read > 0 && (buf[bytes_read-1] == '\n' || buf[bytes_read-1] == ' '))
+	{
+		bytes_read--;
+	}
+	buf[bytes_read] = '\0';
+
+	return(0);
+}
@@ -5,3 +5,6 @@
 
 /************************** Function Prototypes  *****************************/
 void skip_lines(FILE *fp, int numlines);
+int parse_long(const char *buf, size_t len, long *value);
+int parse_ulonglong(const char *buf, size_t len, unsigned long long *value);
+int read_sysfs_string(int dirfd, const char *attr, char *buf, size_t len);
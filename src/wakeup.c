@@ -0,0 +1,562 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include "wakeup.h"
+#include "utils.h"
+
+/************************** Constant Definitions *****************************/
+/*
+ * Columns of the debugfs wakeup_sources table holding each attribute:
+ * name active_count event_count wakeup_count expire_count active_since
+ * total_time max_time last_change prevent_suspend_time
+ */
+static const int wakeup_columns[WAKEUP_NUM_ATTRS] = { 2, 3, 6, 9 };
+
+static const char *const wakeup_attrs[WAKEUP_NUM_ATTRS] = {
+	"event_count",
+	"wakeup_count",
+	"total_time_ms",
+	"prevent_suspend_time_ms",
+};
+
+#define WAKEUP_MAX_COLUMNS	10
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API folds a new cumulative value of a wakeup source into its delta.
+* A counter that went backwards, as when a source is removed and added
+* again, restarts the window.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void wakeup_update(struct wakeup_source *src, int attr,
+		unsigned long long value, int primed)
+{
+	src->delta[attr] = primed && value >= src->value[attr] ?
+		value - src->value[attr] : 0;
+	src->value[attr] = value;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API adds a wakeupN device of the sysfs class to the index and opens
+* its counters.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void wakeup_add_sysfs(struct wakeup_index *idx, int class_fd, const char *dname)
+{
+	struct wakeup_source *src;
+	int dev_fd, i;
+
+	if(idx->num_sources == MAX_WAKEUP_SOURCES)
+	{
+		idx->truncated = 1;
+		return;
+	}
+
+	dev_fd = openat(class_fd, dname, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(dev_fd < 0)
+	{
+		return;
+	}
+
+	src = &idx->sources[idx->num_sources];
+	memset(src, 0, sizeof(*src));
+	src->id = atoi(dname + strlen("wakeup"));
+	if(read_sysfs_string(dev_fd, "name", src->name, sizeof(src->name)))
+	{
+		snprintf(src->name, sizeof(src->name), "%.*s", WAKEUP_NAME_LEN - 1, dname);
+	}
+
+	for(i = 0; i < WAKEUP_NUM_ATTRS; i++)
+	{
+		src->fd[i] = openat(dev_fd, wakeup_attrs[i], O_RDONLY | O_CLOEXEC);
+	}
+	close(dev_fd);
+
+	if(src->fd[WAKEUP_EVENTS] < 0)
+	{
+		for(i = 0; i < WAKEUP_NUM_ATTRS; i++)
+		{
+			if(src->fd[i] >= 0)
+			{
+				close(src->fd[i]);
+			}
+		}
+		return;
+	}
+
+	idx->num_sources++;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API compares two wakeup sources by id for qsort.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int wakeup_id_compare(const void *a, const void *b)
+{
+	const struct wakeup_source *sa = a, *sb = b;
+
+	return(sa->id - sb->id);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API discovers the wakeup sources. The sysfs wakeup class is
+* preferred; each wakeupN device is found once and its counters are kept
+* open. Kernels without the class expose the sources only in the debugfs
+* wakeup_sources table, which is kept open instead and parsed on each read.
+*
+* @param	idx: wakeup index to populate
+*
+* @return	0 on success, errno otherwise.
+*
+* @note		None.
+*
+******************************************************************************/
+int wakeup_init(struct wakeup_index *idx)
+{
+	DIR *d;
+	struct dirent *dir;
+	int class_fd;
+
+	wakeup_release(idx);
+	memset(idx, 0, sizeof(*idx));
+	idx->debugfs_fd = -1;
+
+	class_fd = open(WAKEUP_CLASS_PATH, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(class_fd < 0)
+	{
+		idx->debugfs_fd = open(WAKEUP_DEBUGFS_PATH, O_RDONLY | O_CLOEXEC);
+		if(idx->debugfs_fd < 0)
+		{
+			return(errno);
+		}
+		idx->valid = 1;
+		return(0);
+	}
+
+	d = fdopendir(class_fd);
+	if(d == NULL)
+	{
+		close(class_fd);
+		return(errno);
+	}
+
+	while((dir = readdir(d)) != NULL)
+	{
+		if(strncmp(dir->d_name, "wakeup", strlen("wakeup")))
+		{
+			continue;
+		}
+		wakeup_add_sysfs(idx, dirfd(d), dir->d_name);
+	}
+	closedir(d);
+
+	qsort(idx->sources, idx->num_sources, sizeof(idx->sources[0]),
+		wakeup_id_compare);
+
+	idx->valid = 1;
+
+	return(0);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API closes all fds held by the wakeup index.
+*
+* @param	idx: wakeup index
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void wakeup_release(struct wakeup_index *idx)
+{
+	int i, j;
+
+	if(!idx->valid)
+	{
+		return;
+	}
+
+	for(i = 0; i < idx->num_sources; i++)
+	{
+		for(j = 0; j < WAKEUP_NUM_ATTRS; j++)
+		{
+			if(idx->sources[i].id >= 0 && idx->sources[i].fd[j] >= 0)
+			{
+				close(idx->sources[i].fd[j]);
+			}
+		}
+	}
+
+	if(idx->debugfs_fd >= 0)
+	{
+		close(idx->debugfs_fd);
+	}
+
+	idx->debugfs_fd = -1;
+	idx->num_sources = 0;
+	idx->valid = 0;
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads the counters of the sysfs wakeup sources through their
+* open fds.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int wakeup_read_sysfs(struct wakeup_index *idx)
+{
+	int i, j, num_read = 0;
+
+	for(i = 0; i < idx->num_sources; i++)
+	{
+		struct wakeup_source *src = &idx->sources[i];
+
+		src->status = 0;
+		for(j = 0; j < WAKEUP_NUM_ATTRS; j++)
+		{
+			unsigned long long value = 0;
+			char buf[32];
+			ssize_t len;
+
+			if(src->fd[j] < 0)
+			{
+				src->delta[j] = 0;
+				continue;
+			}
+
+			len = pread(src->fd[j], buf, sizeof(buf) - 1, 0);
+			if(len < 0)
+			{
+				src->status = errno;
+				break;
+			}
+			src->status = parse_ulonglong(buf, len, &value);
+			if(src->status)
+			{
+				break;
+			}
+			wakeup_update(src, j, value, idx->primed);
+		}
+
+		if(src->status)
+		{
+			memset(src->delta, 0, sizeof(src->delta));
+			continue;
+		}
+		num_read++;
+	}
+
+	return(num_read);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API returns the source of the given name, adding it to the index when
+* it is new. Sources that appear later start with a zero delta.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static struct wakeup_source *wakeup_lookup(struct wakeup_index *idx,
+		const char *name, int hint)
+{
+	struct wakeup_source *src;
+	int i;
+
+	/* The table keeps its order between reads, try the same row first */
+	if(hint < idx->num_sources && !strcmp(idx->sources[hint].name, name))
+	{
+		return(&idx->sources[hint]);
+	}
+
+	for(i = 0; i < idx->num_sources; i++)
+	{
+		if(!strcmp(idx->sources[i].name, name))
+		{
+			return(&idx->sources[i]);
+		}
+	}
+
+	if(idx->num_sources == MAX_WAKEUP_SOURCES)
+	{
+		idx->truncated = 1;
+		return(NULL);
+	}
+
+	src = &idx->sources[idx->num_sources++];
+	memset(src, 0, sizeof(*src));
+	src->id = -1;
+	src->status = ENOENT;
+	snprintf(src->name, sizeof(src->name), "%s", name);
+
+	return(src);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads the debugfs wakeup_sources table in one pread and updates
+* the sources listed in it.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int wakeup_read_debugfs(struct wakeup_index *idx)
+{
+	char *line, *next, *end;
+	ssize_t len;
+	int i, row, num_read = 0;
+
+	len = pread(idx->debugfs_fd, idx->table, sizeof(idx->table) - 1, 0);
+	if(len < 0)
+	{
+		return(0);
+	}
+	idx->table[len] = '\0';
+	end = idx->table + len;
+
+	/* Sources missing from this read keep ENODATA, new ones get ENOENT */
+	for(i = 0; i < idx->num_sources; i++)
+	{
+		idx->sources[i].status = ENODATA;
+	}
+
+	/* Skip the header line */
+	line = strchr(idx->table, '\n');
+	for(row = 0; line != NULL && line < end; line = next, row++)
+	{
+		char *cols[WAKEUP_MAX_COLUMNS];
+		struct wakeup_source *src;
+		int num_cols = 0, primed;
+
+		line++;
+		next = strchr(line, '\n');
+		if(next != NULL)
+		{
+			*next = '\0';
+		}
+
+		while(num_cols < WAKEUP_MAX_COLUMNS)
+		{
+			line += strspn(line, " \t");
+			if(*line == '\0')
+			{
+				break;
+			}
+			cols[num_cols++] = line;
+			line += strcspn(line, " \t");
+			if(*line != '\0')
+			{
+				*line++ = '\0';
+			}
+		}
+
+		if(num_cols < WAKEUP_MAX_COLUMNS)
+		{
+			continue;
+		}
+
+		src = wakeup_lookup(idx, cols[0], row);
+		if(src == NULL)
+		{
+			continue;
+		}
+
+		/* A source first seen in this read only starts its window */
+		primed = idx->primed && src->status != ENOENT;
+		src->status = 0;
+		for(i = 0; i < WAKEUP_NUM_ATTRS; i++)
+		{
+			unsigned long long value = 0;
+
+			parse_ulonglong(cols[wakeup_columns[i]],
+				strlen(cols[wakeup_columns[i]]), &value);
+			wakeup_update(src, i, value, primed);
+		}
+		num_read++;
+	}
+
+	return(num_read);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads the counters of every wakeup source and computes the
+* events, active time and prevented suspend time since the previous read.
+* The deltas are 0 on the first read.
+*
+* @param	idx: wakeup index
+*
+* @return	number of sources read successfully.
+*
+* @note		None.
+*
+******************************************************************************/
+int wakeup_read(struct wakeup_index *idx)
+{
+	int num_read;
+
+	if(idx->debugfs_fd >= 0)
+	{
+		num_read = wakeup_read_debugfs(idx);
+	}
+	else
+	{
+		num_read = wakeup_read_sysfs(idx);
+	}
+
+	idx->primed = 1;
+
+	return(num_read);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API orders two wakeup sources by activity in the window: active time
+* first, then events.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static int wakeup_busier(const struct wakeup_source *a, const struct wakeup_source *b)
+{
+	if(a->delta[WAKEUP_ACTIVE_MS] != b->delta[WAKEUP_ACTIVE_MS])
+	{
+		return(a->delta[WAKEUP_ACTIVE_MS] > b->delta[WAKEUP_ACTIVE_MS]);
+	}
+
+	return(a->delta[WAKEUP_EVENTS] > b->delta[WAKEUP_EVENTS]);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API restores the min-heap order below slot i of a heap of size n,
+* the least busy source at the root.
+*
+* @note		Internal API only.
+*
+******************************************************************************/
+static void wakeup_sift_down(struct wakeup_source **heap, int n, int i)
+{
+	while(1)
+	{
+		int least = i, l = 2 * i + 1, r = 2 * i + 2;
+		struct wakeup_source *tmp;
+
+		if(l < n && wakeup_busier(heap[least], heap[l]))
+		{
+			least = l;
+		}
+		if(r < n && wakeup_busier(heap[least], heap[r]))
+		{
+			least = r;
+		}
+		if(least == i)
+		{
+			return;
+		}
+
+		tmp = heap[i];
+		heap[i] = heap[least];
+		heap[least] = tmp;
+		i = least;
+	}
+}
+
+/*****************************************************************************/
+/*
+*
+* This API selects the n sources most active in the window, busiest first.
+* Sources with no event and no active time are skipped. The selection keeps
+* a min-heap of n entries in top, so it costs O(sources * log n) and needs
+* no scratch memory.
+*
+* @param	idx: wakeup index, after wakeup_read
+* @param	top: array of n entries to receive the sources
+* @param	n: number of sources to select
+*
+* @return	number of sources stored in top.
+*
+* @note		None.
+*
+******************************************************************************/
+int wakeup_top(struct wakeup_index *idx, struct wakeup_source **top, int n)
+{
+	int i, count = 0;
+
+	for(i = 0; i < idx->num_sources; i++)
+	{
+		struct wakeup_source *src = &idx->sources[i];
+		int j;
+
+		if(src->status || (src->delta[WAKEUP_EVENTS] == 0 &&
+			src->delta[WAKEUP_ACTIVE_MS] == 0))
+		{
+			continue;
+		}
+
+		if(count < n)
+		{
+			/* Sift up */
+			for(j = count++; j > 0 && wakeup_busier(top[(j - 1) / 2], src);
+				j = (j - 1) / 2)
+			{
+				top[j] = top[(j - 1) / 2];
+			}
+			top[j] = src;
+		}
+		else if(n > 0 && wakeup_busier(src, top[0]))
+		{
+			top[0] = src;
+			wakeup_sift_down(top, count, 0);
+		}
+	}
+
+	/* Heap sort in place; popping the minimum to the end orders busiest first */
+	for(i = count - 1; i > 0; i--)
+	{
+		struct wakeup_source *tmp = top[0];
+
+		top[0] = top[i];
+		top[i] = tmp;
+		wakeup_sift_down(top, i, 0);
+	}
+
+	return(count);
+}
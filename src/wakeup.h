@@ -0,0 +1,59 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+#ifndef _PLATFORMSTATS_WAKEUP_H_
+#define _PLATFORMSTATS_WAKEUP_H_
+
+/************************** Constant Definitions *****************************/
+#define WAKEUP_CLASS_PATH	"/sys/class/wakeup"
+#define WAKEUP_DEBUGFS_PATH	"/sys/kernel/debug/wakeup_sources"
+#define MAX_WAKEUP_SOURCES	256
+#define WAKEUP_NAME_LEN		64
+#define WAKEUP_TABLE_LEN	32768	/* debugfs wakeup_sources text */
+#define WAKEUP_TOP		10	/* sources printed without verbose */
+
+/**************************** Type Definitions *******************************/
+enum {
+	WAKEUP_EVENTS,			/* event_count */
+	WAKEUP_WAKEUPS,			/* wakeup_count, events that aborted suspend */
+	WAKEUP_ACTIVE_MS,		/* total_time_ms */
+	WAKEUP_PREVENT_MS,		/* prevent_suspend_time_ms */
+	WAKEUP_NUM_ATTRS
+};
+
+/*
+ * One wakeup source. Counters are cumulative; deltas cover the window since
+ * the previous read.
+ */
+struct wakeup_source {
+	int id;				/* N of wakeupN, -1 for debugfs sources */
+	char name[WAKEUP_NAME_LEN];
+	int fd[WAKEUP_NUM_ATTRS];	/* sysfs only */
+	unsigned long long value[WAKEUP_NUM_ATTRS];
+	unsigned long long delta[WAKEUP_NUM_ATTRS];
+	int status;			/* 0 if the values are valid, errno otherwise */
+};
+
+/*
+ * Wakeup sources from /sys/class/wakeup, discovered once, or else from the
+ * debugfs wakeup_sources table, read through one fd.
+ */
+struct wakeup_index {
+	int valid;
+	int primed;
+	int debugfs_fd;			/* -1 when the sysfs class is used */
+	int truncated;			/* more than MAX_WAKEUP_SOURCES were found */
+	int num_sources;
+	struct wakeup_source sources[MAX_WAKEUP_SOURCES];
+	char table[WAKEUP_TABLE_LEN];	/* debugfs read buffer */
+};
+
+/************************** Function Prototypes  *****************************/
+int wakeup_init(struct wakeup_index *idx);
+void wakeup_release(struct wakeup_index *idx);
+int wakeup_read(struct wakeup_index *idx);
+int wakeup_top(struct wakeup_index *idx, struct wakeup_source **top, int n);
+
+#endif /* _PLATFORMSTATS_WAKEUP_H_ */
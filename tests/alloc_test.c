@@ -0,0 +1,110 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <stddef.h>
+
+#include "platformstats.h"
+
+/************************** Constant Definitions *****************************/
+#define ALLOC_TEST_TICKS	1000000
+#define ALLOC_TEST_ALL_TICKS	10000
+
+/* Groups read every tick by a monitoring loop, the rest scan sysfs and /proc */
+#define ALLOC_TEST_GROUPS	(PS_SNAP_CPU_UTIL | PS_SNAP_CPU_FREQ | PS_SNAP_MEMORY | \
+				PS_SNAP_SOM_POWER | PS_SNAP_SYSMON | PS_SNAP_THERMAL | \
+				PS_SNAP_DEVFREQ)
+
+/************************** Function Prototypes ******************************/
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+/************************** Variable Definitions *****************************/
+static long alloc_count;
+static struct ps_snapshot snap;
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* These APIs replace the allocator of the test and of the library it links,
+* counting every allocation before passing it on to glibc.
+*
+******************************************************************************/
+void *malloc(size_t size)
+{
+	__atomic_add_fetch(&alloc_count, 1, __ATOMIC_RELAXED);
+	return(__libc_malloc(size));
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	__atomic_add_fetch(&alloc_count, 1, __ATOMIC_RELAXED);
+	return(__libc_calloc(nmemb, size));
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	__atomic_add_fetch(&alloc_count, 1, __ATOMIC_RELAXED);
+	return(__libc_realloc(ptr, size));
+}
+
+/*****************************************************************************/
+/*
+*
+* This API counts the allocations of num_ticks collections of the groups in
+* what.
+*
+******************************************************************************/
+static long count_allocations(struct ps_context *ctx, unsigned int what,
+		long num_ticks)
+{
+	long before, after;
+	long i;
+
+	before = __atomic_load_n(&alloc_count, __ATOMIC_RELAXED);
+	for(i = 0; i < num_ticks; i++)
+	{
+		ps_snapshot_collect(ctx, &snap, what);
+	}
+	after = __atomic_load_n(&alloc_count, __ATOMIC_RELAXED);
+
+	return(after - before);
+}
+
+int main(void)
+{
+	struct ps_context *ctx;
+	long allocs, all_allocs;
+
+	ctx = ps_context_create();
+	if(ctx == NULL)
+	{
+		printf("alloc_test: FAIL, no context\n");
+		return(1);
+	}
+
+	/*
+	 * The first collection may still find sensors and probes the lazily
+	 * scanned collectors, count from the second
+	 */
+	ps_snapshot_collect(ctx, &snap, PS_SNAP_ALL);
+
+	allocs = count_allocations(ctx, ALLOC_TEST_GROUPS, ALLOC_TEST_TICKS);
+	all_allocs = count_allocations(ctx, PS_SNAP_ALL, ALLOC_TEST_ALL_TICKS);
+
+	ps_context_destroy(ctx);
+
+	printf("alloc_test: %ld allocations in %d collections\n",
+		allocs, ALLOC_TEST_TICKS);
+	printf("alloc_test: %ld allocations in %d collections of every group\n",
+		all_allocs, ALLOC_TEST_ALL_TICKS);
+	printf("alloc_test: %s\n", allocs || all_allocs ? "FAIL" : "PASS");
+
+	return(allocs || all_allocs ? 1 : 0);
+}
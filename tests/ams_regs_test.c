@@ -0,0 +1,138 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "ams_regs.h"
+
+/************************** Constant Definitions *****************************/
+#define AMS_CONF	"ams_regs.conf"
+#define AMS_BLOCK	"ams_regs.bin"		/* named by AMS_CONF */
+#define AMS_BLOCK_SIZE	0x1000
+
+#define CHECK(cond)							\
+	do								\
+	{								\
+		if(!(cond))						\
+		{							\
+			printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+			failures++;					\
+		}							\
+	} while(0)
+
+/************************** Variable Definitions *****************************/
+static int failures;
+static struct ams_regs regs;
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API writes the stand-in register block with one raw value per
+* register of AMS_CONF. The upper half words are not part of the results
+* and must be masked off.
+*
+******************************************************************************/
+static void write_block(size_t size)
+{
+	uint32_t block[AMS_BLOCK_SIZE / sizeof(uint32_t)];
+	FILE *fp;
+
+	memset(block, 0, sizeof(block));
+	block[0x800 / 4] = 0xdead0000 | 0xa000;
+	block[0x810 / 4] = 0xdead0000 | 0x4000;
+	block[0x814 / 4] = 0x8000;
+	block[0x818 / 4] = 100;
+
+	fp = fopen(AMS_BLOCK, "w");
+	if(fp == NULL)
+	{
+		perror(AMS_BLOCK);
+		exit(1);
+	}
+	fwrite(block, 1, size, fp);
+	fclose(fp);
+}
+
+static long reg_value(const char *name)
+{
+	struct ams_reg *reg = ams_regs_lookup(&regs, name);
+
+	return(reg != NULL ? reg->value : -1);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API loads a one line map from a temporary file.
+*
+******************************************************************************/
+static int load_text(const char *text)
+{
+	char path[] = "/tmp/ams_regs_test.XXXXXX";
+	FILE *fp;
+	int fd, ret;
+
+	fd = mkstemp(path);
+	if(fd < 0 || (fp = fdopen(fd, "w")) == NULL)
+	{
+		perror(path);
+		exit(1);
+	}
+	fputs(text, fp);
+	fclose(fp);
+
+	ret = ams_regs_load(&regs, path);
+	unlink(path);
+
+	return(ret);
+}
+
+int main(void)
+{
+	write_block(AMS_BLOCK_SIZE);
+
+	CHECK(ams_regs_load(&regs, AMS_CONF) == 0);
+	CHECK(regs.num_regs == 4);
+	CHECK(regs.size == AMS_BLOCK_SIZE);
+	CHECK(ams_regs_open(&regs) == 0);
+
+	if(regs.block != NULL)
+	{
+		ams_regs_read(&regs);
+
+		/* 0xa000 * 509314 / 65536 - 280230 = 38091.25 m°C */
+		CHECK(reg_value("temp1") == 38091);
+		CHECK(reg_value("in1") == 750);
+		CHECK(reg_value("in2") == 3000);
+		CHECK(reg_value("in3") == 195);
+		CHECK(ams_regs_lookup(&regs, "in4") == NULL);
+	}
+	ams_regs_close(&regs);
+
+	/* a stand-in shorter than the block would fault on the last page */
+	write_block(AMS_BLOCK_SIZE / 2);
+	CHECK(ams_regs_load(&regs, AMS_CONF) == 0);
+	CHECK(ams_regs_open(&regs) == EINVAL);
+	unlink(AMS_BLOCK);
+
+	CHECK(load_text("device " AMS_BLOCK "\nsize 0x1000\nreg temp1 0x1000 temp\n") == EINVAL);
+	CHECK(load_text("device " AMS_BLOCK "\nsize 0x1000\nreg temp1 0x0802 temp\n") == EINVAL);
+	CHECK(load_text("device " AMS_BLOCK "\nreg temp1 0x0800 temp\n") == EINVAL);
+	CHECK(load_text("device " AMS_BLOCK "\nsize 0x1000\nreg temp1 0x0800 volts\n") == EINVAL);
+	CHECK(load_text("device " AMS_BLOCK " 0x1000\nsize 0x1000\n") == 0);
+	CHECK(regs.base == 0x1000);
+
+	printf("ams_regs_test: %s\n", failures ? "FAIL" : "PASS");
+
+	return(failures ? 1 : 0);
+}
@@ -0,0 +1,179 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "platformstats.h"
+
+/************************** Constant Definitions *****************************/
+#define STRESS_OWN_THREADS	3
+#define STRESS_PUBLISHERS	2
+#define STRESS_READERS		5
+#define STRESS_THREADS		(STRESS_OWN_THREADS + STRESS_PUBLISHERS + STRESS_READERS)
+#define STRESS_RAILS		"rails.conf"
+
+/* Lowered by the tsan target, instrumented copies are much slower */
+#ifndef STRESS_COLLECTIONS
+#define STRESS_COLLECTIONS	2000
+#endif
+#ifndef STRESS_READS
+#define STRESS_READS		50000
+#endif
+
+/************************** Variable Definitions *****************************/
+static struct ps_context *shared;
+static struct ps_snapshot own_snaps[STRESS_OWN_THREADS];
+static struct ps_snapshot read_snaps[STRESS_READERS];
+static long failures[STRESS_THREADS];
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API collects every group through a context private to the calling
+* thread, with a rail model loaded and its alarm thread running, so that
+* the derived collectors (energy, supplies, rails, throttling, CPU and
+* process power, runtime PM, wakeup sources and alarms) of the contexts run
+* concurrently.
+*
+******************************************************************************/
+static void *own_context(void *arg)
+{
+	long id = (long)arg;
+	struct ps_snapshot *snap = &own_snaps[id];
+	struct ps_context *ctx;
+	int i;
+
+	ctx = ps_context_create();
+	if(ctx == NULL)
+	{
+		failures[id]++;
+		return(NULL);
+	}
+
+	if(ps_context_load_rail_model(ctx, STRESS_RAILS) ||
+		ps_context_start_alarms(ctx))
+	{
+		failures[id]++;
+	}
+
+	for(i = 0; i < STRESS_COLLECTIONS; i++)
+	{
+		ps_snapshot_collect(ctx, snap, PS_SNAP_ALL);
+		if(snap->collected != PS_SNAP_ALL || snap->rails.status ||
+			snap->alarms.status)
+		{
+			failures[id]++;
+		}
+	}
+
+	ps_context_stop_alarms(ctx);
+	ps_context_destroy(ctx);
+
+	return(NULL);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API publishes snapshots of the shared context.
+*
+******************************************************************************/
+static void *publisher(void *arg)
+{
+	int i;
+
+	for(i = 0; i < STRESS_COLLECTIONS; i++)
+	{
+		ps_context_publish(shared, PS_SNAP_ALL);
+	}
+
+	return(arg);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads the latest snapshot of the shared context, once the first
+* one is published. Publishers are serialized, so a reader that sees a torn
+* copy or an older snapshot after a newer one counts a failure.
+*
+******************************************************************************/
+static void *reader(void *arg)
+{
+	long id = (long)arg;
+	struct ps_snapshot *snap = &read_snaps[id - STRESS_OWN_THREADS - STRESS_PUBLISHERS];
+	long long last_ns = 0;
+	int i, ret;
+
+	while(ps_snapshot_latest(shared, snap) == ENODATA)
+	{
+		sched_yield();
+	}
+
+	for(i = 0; i < STRESS_READS; i++)
+	{
+		ret = ps_snapshot_latest(shared, snap);
+		if(ret || snap->collected != PS_SNAP_ALL || snap->num_cpus < 1 ||
+			snap->timestamp_ns < last_ns)
+		{
+			failures[id]++;
+		}
+		last_ns = snap->timestamp_ns;
+	}
+
+	return(NULL);
+}
+
+int main(void)
+{
+	pthread_t threads[STRESS_THREADS];
+	long total = 0;
+	long i;
+
+	shared = ps_context_create();
+	if(shared == NULL)
+	{
+		printf("context_stress: FAIL, no context\n");
+		return(1);
+	}
+
+	for(i = 0; i < STRESS_THREADS; i++)
+	{
+		void *(*fn)(void *) = reader;
+
+		if(i < STRESS_OWN_THREADS)
+		{
+			fn = own_context;
+		}
+		else if(i < STRESS_OWN_THREADS + STRESS_PUBLISHERS)
+		{
+			fn = publisher;
+		}
+
+		if(pthread_create(&threads[i], NULL, fn, (void *)i))
+		{
+			printf("context_stress: FAIL, unable to start thread %ld\n", i);
+			return(1);
+		}
+	}
+
+	for(i = 0; i < STRESS_THREADS; i++)
+	{
+		pthread_join(threads[i], NULL);
+		total += failures[i];
+	}
+
+	ps_context_destroy(shared);
+
+	printf("context_stress: %s\n", total ? "FAIL" : "PASS");
+
+	return(total ? 1 : 0);
+}
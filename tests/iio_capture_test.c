@@ -0,0 +1,232 @@
+/******************************************************************************
+* Copyright (C) 2019 - 2020 Xilinx, Inc.  All rights reserved.
+* SPDX-License-Identifier: MIT
+******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files *********************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "iio_capture.h"
+
+/************************** Constant Definitions *****************************/
+#define FRAME_SIZE	16	/* u16, s12 in 16, s64 timestamp aligned to 8 */
+#define NUM_FRAMES	2
+
+#define CHECK(cond)							\
+	do								\
+	{								\
+		if(!(cond))						\
+		{							\
+			printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+			failures++;					\
+		}							\
+	} while(0)
+
+/************************** Variable Definitions *****************************/
+static int failures;
+static char fixture[] = "/tmp/iio_capture_test.XXXXXX";
+static char dev_path[IIO_PATH_LEN];
+static struct iio_capture cap;
+static struct iio_sample samples[NUM_FRAMES];
+
+/************************** Function Definitions *****************************/
+/*****************************************************************************/
+/*
+*
+* This API writes a file below the fixture directory.
+*
+******************************************************************************/
+static void write_file(const char *name, const void *data, size_t len)
+{
+	char path[IIO_PATH_LEN];
+	FILE *fp;
+
+	snprintf(path, sizeof(path), "%s/%s", fixture, name);
+	fp = fopen(path, "w");
+	if(fp == NULL)
+	{
+		perror(path);
+		exit(1);
+	}
+	fwrite(data, 1, len, fp);
+	fclose(fp);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API reads back a one line file below the fixture directory.
+*
+******************************************************************************/
+static void read_file(const char *name, char *value, size_t len)
+{
+	char path[IIO_PATH_LEN];
+	FILE *fp;
+
+	value[0] = '\0';
+	snprintf(path, sizeof(path), "%s/%s", fixture, name);
+	fp = fopen(path, "r");
+	if(fp != NULL)
+	{
+		if(fgets(value, len, fp) == NULL)
+		{
+			value[0] = '\0';
+		}
+		fclose(fp);
+	}
+}
+
+static void write_attr(const char *name, const char *value)
+{
+	write_file(name, value, strlen(value));
+}
+
+static void make_dir(const char *name)
+{
+	char path[IIO_PATH_LEN];
+
+	snprintf(path, sizeof(path), "%s/%s", fixture, name);
+	mkdir(path, 0755);
+}
+
+/*****************************************************************************/
+/*
+*
+* This API builds the stand-in device: an IIO sysfs directory with three
+* valid scan elements, one with an invalid zero bit type that must be
+* skipped, an empty current_trigger and a file of packed frames.
+*
+******************************************************************************/
+static void make_fixture(void)
+{
+	unsigned char frames[NUM_FRAMES * FRAME_SIZE];
+	uint16_t v0[NUM_FRAMES] = { 100, 4095 };
+	int16_t v1[NUM_FRAMES] = { -5, 2047 };
+	int64_t ts[NUM_FRAMES] = { 1000000, 2000000 };
+	int f;
+
+	if(mkdtemp(fixture) == NULL)
+	{
+		perror(fixture);
+		exit(1);
+	}
+
+	make_dir("scan_elements");
+	make_dir("buffer");
+	make_dir("trigger");
+
+	write_attr("scan_elements/in_voltage0_en", "0");
+	write_attr("scan_elements/in_voltage0_index", "0");
+	write_attr("scan_elements/in_voltage0_type", "le:u16/16>>0");
+	write_attr("in_voltage0_scale", "0.5");
+
+	write_attr("scan_elements/in_voltage1_en", "0");
+	write_attr("scan_elements/in_voltage1_index", "1");
+	write_attr("scan_elements/in_voltage1_type", "le:s12/16>>4");
+
+	write_attr("scan_elements/in_temp2_en", "1");	/* left on by an earlier user */
+	write_attr("scan_elements/in_temp2_index", "2");
+	write_attr("scan_elements/in_temp2_type", "le:u0/16>>0");
+
+	write_attr("scan_elements/in_timestamp_en", "0");
+	write_attr("scan_elements/in_timestamp_index", "3");
+	write_attr("scan_elements/in_timestamp_type", "le:s64/64>>0");
+
+	write_attr("buffer/enable", "0");
+	write_attr("buffer/length", "0");
+	write_attr("trigger/current_trigger", "");
+
+	memset(frames, 0, sizeof(frames));
+	for(f = 0; f < NUM_FRAMES; f++)
+	{
+		unsigned char *p = frames + f * FRAME_SIZE;
+		uint16_t raw1 = (uint16_t)(v1[f] << 4);
+		int i;
+
+		p[0] = v0[f] & 0xff;
+		p[1] = v0[f] >> 8;
+		p[2] = raw1 & 0xff;
+		p[3] = raw1 >> 8;
+		for(i = 0; i < 8; i++)
+		{
+			p[8 + i] = (uint64_t)ts[f] >> (8 * i);
+		}
+	}
+	write_file("frames", frames, sizeof(frames));
+	snprintf(dev_path, sizeof(dev_path), "%s/frames", fixture);
+}
+
+int main(void)
+{
+	char value[64];
+	char cmd[IIO_PATH_LEN];
+	int ret, n;
+
+	make_fixture();
+
+	/* an empty current_trigger fails instead of blocking in read() */
+	ret = iio_capture_open(&cap, fixture, dev_path, NULL, NULL, 0);
+	CHECK(ret == ENXIO);
+
+	ret = iio_capture_open(&cap, fixture, dev_path, "sysfstrig0", NULL, 0);
+	CHECK(ret == 0);
+	read_file("trigger/current_trigger", value, sizeof(value));
+	CHECK(!strcmp(value, "sysfstrig0"));
+	read_file("buffer/enable", value, sizeof(value));
+	CHECK(!strcmp(value, "1"));
+	read_file("scan_elements/in_voltage0_en", value, sizeof(value));
+	CHECK(!strcmp(value, "1"));
+
+	/* in_temp2 has zero bits, is left out of the frame and disabled */
+	read_file("scan_elements/in_temp2_en", value, sizeof(value));
+	CHECK(!strcmp(value, "0"));
+	CHECK(cap.num_channels == 3);
+	CHECK(cap.frame_size == FRAME_SIZE);
+	CHECK(cap.timestamp_channel == 2);
+
+	n = iio_capture_read(&cap, samples, NUM_FRAMES);
+	CHECK(n == NUM_FRAMES);
+	if(n == NUM_FRAMES)
+	{
+		CHECK(samples[0].values[0] == 50.0);
+		CHECK(samples[1].values[0] == 4095 * 0.5);
+		CHECK(samples[0].values[1] == -5.0);
+		CHECK(samples[1].values[1] == 2047.0);
+		CHECK(samples[0].timestamp == 1000000);
+		CHECK(samples[1].timestamp == 2000000);
+	}
+	CHECK(iio_capture_read(&cap, samples, NUM_FRAMES) == 0);
+
+	iio_capture_close(&cap);
+	read_file("buffer/enable", value, sizeof(value));
+	CHECK(!strcmp(value, "0"));
+
+	/* a missing device reports its own errno, not one from printf */
+	ret = iio_capture_open(&cap, fixture, "/nonexistent/iio:device0", "sysfstrig0",
+			NULL, 0);
+	CHECK(ret == ENOENT);
+
+	/* a buffer/enable that exists but cannot be written fails the open */
+	snprintf(cmd, sizeof(cmd), "%s/buffer/enable", fixture);
+	unlink(cmd);
+	make_dir("buffer/enable");
+	ret = iio_capture_open(&cap, fixture, dev_path, "sysfstrig0", NULL, 0);
+	CHECK(ret == EISDIR);
+
+	snprintf(cmd, sizeof(cmd), "rm -rf %s", fixture);
+	if(system(cmd))
+	{
+		printf("Unable to remove %s\n", fixture);
+	}
+
+	printf("iio_capture_test: %s\n", failures ? "FAIL" : "PASS");
+
+	return(failures ? 1 : 0);
+}
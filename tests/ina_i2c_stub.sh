@@ -0,0 +1,68 @@
+#!/bin/sh
+#*******************************************************************************
+#
+# Copyright (C) 2020 Xilinx, Inc.  All rights reserved.
+# SPDX-License-Identifier: MIT
+#
+# ******************************************************************************
+#
+# Reads an INA260 and an INA226 emulated by i2c-stub through --ina-i2c and
+# checks the SOM power printed by -p. Needs root, the i2c-stub and i2c-dev
+# modules and i2cset from i2c-tools; skipped when any of them is missing.
+# i2c-stub has no plain I2C, so this covers the SMBus word read path.
+
+APP=../app/platformstats
+INA260=0x40
+INA226=0x41
+
+skip()
+{
+	echo "ina_i2c_stub: SKIP ($1)"
+	exit 0
+}
+
+fail()
+{
+	echo "ina_i2c_stub: FAIL ($1)"
+	exit 1
+}
+
+# check <spec> <mW> <mA> <mV>
+check()
+{
+	out=$(LD_LIBRARY_PATH=../src $APP --ina-i2c "$1" -p) || fail "$1: exit status"
+	echo "$out" | grep -q "SOM total power *: *$2 mW" || fail "$1: power, got: $out"
+	echo "$out" | grep -q "SOM total current *: *$3 mA" || fail "$1: current, got: $out"
+	echo "$out" | grep -q "SOM total voltage.*: *$4 mV" || fail "$1: voltage, got: $out"
+}
+
+[ "$(id -u)" = 0 ] || skip "not root"
+command -v i2cset > /dev/null || skip "i2cset not found"
+[ -x $APP ] || skip "$APP not built"
+[ -d /sys/module/i2c_stub ] && skip "i2c-stub already loaded"
+
+modprobe i2c-dev 2> /dev/null
+modprobe i2c-stub chip_addr=$INA260,$INA226 2> /dev/null || skip "no i2c-stub module"
+trap 'rmmod i2c-stub' EXIT
+
+bus=
+for adapter in /sys/bus/i2c/devices/i2c-*; do
+	grep -q "SMBus stub driver" $adapter/name 2> /dev/null && bus=${adapter##*/i2c-}
+done
+[ -n "$bus" ] || fail "no i2c-stub adapter"
+[ -c /dev/i2c-$bus ] || fail "no /dev/i2c-$bus"
+
+# SMBus words are little endian, the INA registers big endian
+i2cset -y $bus $INA260 0x01 0x2003 w	# current 800 * 1.25 mA
+i2cset -y $bus $INA260 0x02 0x8025 w	# bus voltage 9600 * 1.25 mV
+i2cset -y $bus $INA260 0x03 0xb004 w	# power 1200 * 10 mW
+check /dev/i2c-$bus,$INA260 12000 1000 12000
+
+# a 2 mOhm shunt with calibration 2560 gives 1 mA and 25 mW per bit
+i2cset -y $bus $INA226 0x05 0x000a w	# calibration 2560
+i2cset -y $bus $INA226 0x04 0xf401 w	# current 500
+i2cset -y $bus $INA226 0x02 0xa00f w	# bus voltage 4000 * 1.25 mV
+i2cset -y $bus $INA226 0x03 0x6400 w	# power 100
+check /dev/i2c-$bus,$INA226,ina226,2000 2500 500 5000
+
+echo "ina_i2c_stub: PASS"